@@ -3,6 +3,8 @@
 #include <cuda_runtime.h>
 #include <cublas_v2.h>
 
+#include <algorithm>
+
 #include "caffe/blob.hpp"
 #include "caffe/common.hpp"
 #include "caffe/syncedmem.hpp"
@@ -22,6 +24,12 @@ void Blob<Dtype>::Reshape(const int num, const int channels, const int height,
   height_ = height;
   width_ = width;
   count_ = num_ * channels_ * height_ * width_;
+  sparse_ = false;
+  nnz_ = 0;
+  sparse_values_.reset();
+  sparse_indices_.reset();
+  sparse_ptr_.reset();
+  clear_diff_columns();
   if (count_) {
     data_.reset(new SyncedMemory(count_ * sizeof(Dtype)));
     diff_.reset(new SyncedMemory(count_ * sizeof(Dtype)));
@@ -33,6 +41,37 @@ void Blob<Dtype>::Reshape(const int num, const int channels, const int height,
   }
 }
 
+// A sparse blob holds num rows of dim columns in CSR form: the nonzeros of
+// row i are sparse_values/sparse_indices [sparse_ptr[i], sparse_ptr[i + 1]).
+// It has no dense data or diff. The value and index buffers only grow, so
+// reshaping every batch does not reallocate once they are large enough.
+template <typename Dtype>
+void Blob<Dtype>::ReshapeSparse(const int num, const int dim, const int nnz) {
+  CHECK_GE(num, 0);
+  CHECK_GT(dim, 0);
+  CHECK_GE(nnz, 0);
+  if (!sparse_) {
+    data_.reset();
+    diff_.reset();
+    second_diff_.reset();
+  }
+  sparse_ = true;
+  num_ = num;
+  channels_ = dim;
+  height_ = 1;
+  width_ = 1;
+  count_ = num_ * channels_;
+  nnz_ = nnz;
+  const size_t capacity = std::max(nnz, 1);
+  if (!sparse_values_ || sparse_values_->size() < capacity * sizeof(Dtype)) {
+    sparse_values_.reset(new SyncedMemory(capacity * sizeof(Dtype)));
+    sparse_indices_.reset(new SyncedMemory(capacity * sizeof(int)));
+  }
+  if (!sparse_ptr_ || sparse_ptr_->size() < (num + 1) * sizeof(int)) {
+    sparse_ptr_.reset(new SyncedMemory((num + 1) * sizeof(int)));
+  }
+}
+
 template <typename Dtype>
 Blob<Dtype>::Blob(const int num, const int channels, const int height,
     const int width) {
@@ -111,12 +150,85 @@ Dtype* Blob<Dtype>::mutable_gpu_2nd_diff() {
   return reinterpret_cast<Dtype*>(second_diff_->mutable_gpu_data());
 }
 
+template <typename Dtype>
+const Dtype* Blob<Dtype>::cpu_sparse_values() const {
+  CHECK(sparse_);
+  return (const Dtype*)sparse_values_->cpu_data();
+}
+
+template <typename Dtype>
+const int* Blob<Dtype>::cpu_sparse_indices() const {
+  CHECK(sparse_);
+  return (const int*)sparse_indices_->cpu_data();
+}
+
+template <typename Dtype>
+const int* Blob<Dtype>::cpu_sparse_ptr() const {
+  CHECK(sparse_);
+  return (const int*)sparse_ptr_->cpu_data();
+}
+
+template <typename Dtype>
+Dtype* Blob<Dtype>::mutable_cpu_sparse_values() {
+  CHECK(sparse_);
+  return reinterpret_cast<Dtype*>(sparse_values_->mutable_cpu_data());
+}
+
+template <typename Dtype>
+int* Blob<Dtype>::mutable_cpu_sparse_indices() {
+  CHECK(sparse_);
+  return reinterpret_cast<int*>(sparse_indices_->mutable_cpu_data());
+}
+
+template <typename Dtype>
+int* Blob<Dtype>::mutable_cpu_sparse_ptr() {
+  CHECK(sparse_);
+  return reinterpret_cast<int*>(sparse_ptr_->mutable_cpu_data());
+}
+
+template <typename Dtype>
+void Blob<Dtype>::ShareData(const Blob& other) {
+  CHECK_EQ(count_, other.count());
+  data_ = other.data();
+}
+
+// Marks the diff as zero outside the given columns (along width). Layers with
+// sparse gradients set this so that the solver and Update() can skip the
+// rest; whoever writes the diff densely has to clear it.
+template <typename Dtype>
+void Blob<Dtype>::set_diff_columns(const vector<int>& columns) {
+  diff_columns_ = columns;
+  has_diff_columns_ = true;
+}
+
+template <typename Dtype>
+void Blob<Dtype>::clear_diff_columns() {
+  has_diff_columns_ = false;
+  diff_columns_.clear();
+}
+
+template <typename Dtype>
+const vector<int>* Blob<Dtype>::diff_columns() const {
+  return has_diff_columns_ ? &diff_columns_ : NULL;
+}
 
 template <typename Dtype>
 void Blob<Dtype>::Update() {
   // We will perform update based on where the data is located.
   switch (data_->head()) {
   case SyncedMemory::HEAD_AT_CPU:
+    if (has_diff_columns_) {
+      const Dtype* diff = reinterpret_cast<const Dtype*>(diff_->cpu_data());
+      Dtype* data = reinterpret_cast<Dtype*>(data_->mutable_cpu_data());
+      const int rows = count_ / width_;
+      for (int j = 0; j < diff_columns_.size(); ++j) {
+        for (int r = 0; r < rows; ++r) {
+          data[r * width_ + diff_columns_[j]] -=
+              diff[r * width_ + diff_columns_[j]];
+        }
+      }
+      break;
+    }
     // perform computation on CPU
     caffe_axpy<Dtype>(count_, Dtype(-1),
         reinterpret_cast<const Dtype*>(diff_->cpu_data()),
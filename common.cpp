@@ -19,11 +19,36 @@ long cluster_seedgen(void) {
 }
 
 
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3", SC 2011). Every counter gives four independent random words, so any
+// thread can draw the numbers of any record without sharing state.
+void philox4x32(const uint32_t counter[4], const uint32_t key[2],
+    uint32_t out[4]) {
+  uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int round = 0; round < 10; ++round) {
+    const uint64_t p0 = static_cast<uint64_t>(0xD2511F53) * c0;
+    const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57) * c2;
+    const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    c1 = static_cast<uint32_t>(p1);
+    c3 = static_cast<uint32_t>(p0);
+    c0 = n0;
+    c2 = n2;
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
 Caffe::Caffe()
     : mode_(Caffe::CPU), phase_(Caffe::TRAIN), cublas_handle_(NULL),
       curand_generator_(NULL),
       //vsl_stream_(NULL)
-      random_generator_()
+      random_generator_(), rng_seed_(cluster_seedgen()), rng_streams_(0)
 {
   // Try to create a cublas handler, and report an error if failed (but we will
   // keep the program running as one might just want to run CPU code).
@@ -71,7 +96,17 @@ void Caffe::set_random_seed(const unsigned int seed) {
   //VSL_CHECK(vslDeleteStream(&(Get().vsl_stream_)));
   //VSL_CHECK(vslNewStream(&(Get().vsl_stream_), VSL_BRNG_MT19937, seed));
   Get().random_generator_ = random_generator_t(seed);
+  // Counter-based streams restart, so that a net built after seeding gets
+  // the same streams every time.
+  Get().rng_seed_ = seed;
+  Get().rng_streams_ = 0;
+}
 
+// Hands out the next counter-based random stream. The philox4x32 key of
+// stream s is {rng_seed(), s}. Streams are meant to be taken while a net is
+// set up, which happens on one thread.
+uint32_t Caffe::NewRngStream() {
+  return Get().rng_streams_++;
 }
 
 void Caffe::SetDevice(const int device_id) {
@@ -7,125 +7,354 @@
 #include <string>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include "caffe/layer.hpp"
+#include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/dequantize.hpp"
 #include "caffe/util/io.hpp"
 #include "caffe/vision_layers.hpp"
 
 using std::string;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormatLite;
 
 namespace caffe {
 
+// The random crop and mirror picked for one record of a batch.
+struct DatumTransform {
+  int h_off;
+  int w_off;
+  bool mirror;
+};
+
+// A batch of prefetched data. The data layer owns a ring of these that is
+// passed back and forth between the prefetch thread and Forward. The raw
+// records are staging space for the decode workers.
 template <typename Dtype>
-void* DataLayerPrefetch(void* layer_pointer) {
-  CHECK(layer_pointer);
-  DataLayer<Dtype>* layer = reinterpret_cast<DataLayer<Dtype>*>(layer_pointer);
-  CHECK(layer);
-  Datum datum;
-  CHECK(layer->prefetch_data_);
-  Dtype* top_data = layer->prefetch_data_->mutable_cpu_data();
-  Dtype* top_label = layer->prefetch_label_->mutable_cpu_data();
-  Dtype* top_qid = (layer->prefetch_qid_.get() == NULL) ? NULL : layer->prefetch_qid_->mutable_cpu_data();
-  Dtype scale = layer->layer_param_.scale();
-  if(Caffe::phase() == Caffe::TRAIN)
-	scale = scale *(1 + layer->layer_param_.jitter_rate() * 2 * (gsl_rng_uniform(layer->rng) - 0.5));
-  const int batchsize = layer->layer_param_.batchsize();
-  const int cropsize = layer->layer_param_.cropsize();
-  const bool mirror = layer->layer_param_.mirror();
+class DataBatch {
+ public:
+  shared_ptr<Blob<Dtype> > data_;
+  shared_ptr<Blob<Dtype> > label_;
+  shared_ptr<Blob<Dtype> > qid_;
+  shared_ptr<Blob<Dtype> > query_offsets_;
+  vector<string> records_;
+  // The number of the batch among those the layer has loaded. Together with
+  // the slot of a record it picks the random numbers of its transform.
+  uint64_t index_;
+  // Staging space for the nonzeros of a sparse batch, which is only sized
+  // once all of its records are read.
+  vector<int> sparse_indices_;
+  vector<Dtype> sparse_values_;
+  // Where each query group of the batch starts, followed by the fill.
+  vector<int> query_starts_;
+  // The records of a batch read from a dense dataset.
+  vector<int> dense_records_;
+  // The raw feature rows of a streamed dense batch, in slot order
+  vector<char> stream_rows_;
+  // The wall time the prefetch thread spent decoding this batch, as opposed
+  // to reading it
+  int64_t decode_ns_;
+  Dtype scale_;
+  // The dequantization, mean subtraction and scaling of the batch folded
+  // into feature j -> x * norm_scale_[j] + norm_shift_[j].
+  vector<Dtype> norm_scale_;
+  vector<Dtype> norm_shift_;
+  // Whether the folded normalization leaves every feature as it is
+  bool norm_identity_;
+};
 
-  if (mirror && cropsize == 0) {
-    LOG(FATAL) << "Current implementation requires mirror and cropsize to be "
-        << "set at the same time.";
+// A fixed set of threads that run the same job on disjoint parts of a batch.
+// Run() calls job(i) once for every worker i and returns when all are done;
+// the calling thread takes part 0 itself.
+class DecodeWorkers {
+ public:
+  explicit DecodeWorkers(int num_workers)
+      : num_workers_(num_workers), job_(NULL), generation_(0), pending_(0),
+        stop_(false) {
+    CHECK_GT(num_workers, 0);
+    for (int i = 1; i < num_workers; ++i) {
+      threads_.push_back(thread(&DecodeWorkers::Entry, this, i));
+    }
   }
-  // datum scales
-  const int channels = layer->datum_channels_;
-  const int height = layer->datum_height_;
-  const int width = layer->datum_width_;
-  const int size = layer->datum_size_;
-  const Dtype* mean = layer->data_mean_.cpu_data();
 
-  if (layer->randomJump) {
-	  /*Random jump to a point in database*/
-	  layer->iter_->Seek(layer->dbKeys[layer->randIdx]);
+  ~DecodeWorkers() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+    lock.unlock();
+    start_.notify_all();
+    for (int i = 0; i < threads_.size(); ++i) {
+      threads_[i].join();
+    }
   }
 
-  /*CHECK(layer->iter_);
-  CHECK(layer->iter_->Valid());
-  datum.ParseFromString(layer->iter_->value().ToString());
-  /*int curGroupId = -1;
-  if(datum.has_group_id())
-  {
-	  memset(top_data, 0, sizeof(Dtype) * layer->prefetch_data_->count());
-	  curGroupId = datum.group_id();
-	  for(int i = 0; i < batchsize; i++)
-		  top_label[i] = -1;
-  }*/
+  int size() const { return num_workers_; }
 
-  for (int itemid = 0; itemid < batchsize; ++itemid) {
-    // get a blob
-    CHECK(layer->iter_);
-    CHECK(layer->iter_->Valid());
-    datum.ParseFromString(layer->iter_->value().ToString());
-	//if(Caffe::phase() == Caffe::TRAIN && datum.has_group_id() && datum.group_id() != curGroupId)
-	//	break;
-    const string& data = datum.data();
-    if (cropsize) {
-      CHECK(data.size()) << "Image cropping only support uint8 data";
-      int h_off, w_off;
-      // We only do random crop when we do training.
-      if (Caffe::phase() == Caffe::TRAIN) {
-        h_off = (height == cropsize) ? 0 : rand() % (height - cropsize);
-        w_off = (height == cropsize) ? 0 : rand() % (width - cropsize);
-      } else {
-        h_off = (height - cropsize) / 2;
-        w_off = (width - cropsize) / 2;
+  void Run(const std::function<void(int)>& job) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_ = &job;
+    pending_ = num_workers_ - 1;
+    ++generation_;
+    lock.unlock();
+    start_.notify_all();
+    job(0);
+    lock.lock();
+    while (pending_ > 0) {
+      done_.wait(lock);
+    }
+    job_ = NULL;
+  }
+
+ private:
+  void Entry(int worker_id) {
+    int generation = 0;
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!stop_ && generation_ == generation) {
+        start_.wait(lock);
       }
-      if (mirror && rand() % 2) {
-        // Copy mirrored version
-        for (int c = 0; c < channels; ++c) {
-          for (int h = 0; h < cropsize; ++h) {
-            for (int w = 0; w < cropsize; ++w) {
-              top_data[((itemid * channels + c) * cropsize + h) * cropsize
-                       + cropsize - 1 - w] =
-                  (static_cast<Dtype>(
-                      (uint8_t)data[(c * height + h + h_off) * width
-                                    + w + w_off])
-                    - mean[(c * height + h + h_off) * width + w + w_off])
-                  * scale;
-            }
-          }
-        }
-      } else {
-        // Normal copy
-        for (int c = 0; c < channels; ++c) {
-          for (int h = 0; h < cropsize; ++h) {
-            for (int w = 0; w < cropsize; ++w) {
-              top_data[((itemid * channels + c) * cropsize + h) * cropsize + w]
-                  = (static_cast<Dtype>(
-                      (uint8_t)data[(c * height + h + h_off) * width
-                                    + w + w_off])
-                     - mean[(c * height + h + h_off) * width + w + w_off])
-                  * scale;
-            }
-          }
-        }
+      if (stop_) {
+        return;
       }
+      generation = generation_;
+      const std::function<void(int)>* job = job_;
+      lock.unlock();
+      (*job)(worker_id);
+      lock.lock();
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  const int num_workers_;
+  vector<thread> threads_;
+  const std::function<void(int)>* job_;
+  int generation_;
+  int pending_;
+  bool stop_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+};
+
+typedef std::chrono::steady_clock data_clock;
+
+static inline int64_t Nanos(const data_clock::duration& duration) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+      .count();
+}
+
+static inline int64_t NanosSince(const data_clock::time_point& start) {
+  return Nanos(data_clock::now() - start);
+}
+
+// Running totals of what a data layer has done since they were reset. The
+// prefetch thread, the decode workers and Forward add to them concurrently.
+class DataLayerCounters {
+ public:
+  enum Counter { WAIT_NS, READ_NS, PARSE_NS, NORMALIZE_NS, COPY_NS, BATCHES,
+      RECORDS, BYTES, NUM_COUNTERS };
+
+  DataLayerCounters() { Reset(); }
+
+  void Add(const Counter counter, const int64_t value) {
+    counters_[counter].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  int64_t Get(const Counter counter) const {
+    return counters_[counter].load(std::memory_order_relaxed);
+  }
+
+  double Seconds(const Counter counter) const { return Get(counter) * 1e-9; }
+
+  double ElapsedSeconds() const { return NanosSince(since_) * 1e-9; }
+
+  void Reset() {
+    for (int i = 0; i < NUM_COUNTERS; ++i) {
+      counters_[i].store(0, std::memory_order_relaxed);
+    }
+    since_ = data_clock::now();
+  }
+
+ private:
+  std::atomic<int64_t> counters_[NUM_COUNTERS];
+  data_clock::time_point since_;
+};
+
+// Runs job on the decode workers and adds the wall time to *nanos.
+static void RunTimed(DecodeWorkers* workers,
+    const std::function<void(int)>& job, int64_t* nanos) {
+  const data_clock::time_point start = data_clock::now();
+  workers->Run(job);
+  *nanos += NanosSince(start);
+}
+
+// Reads the group_id of a serialized Datum without parsing the rest of it.
+// Returns false if the record has none.
+static bool ReadDatumGroupId(const leveldb::Slice& value, int* group_id) {
+  CodedInputStream input(reinterpret_cast<const uint8_t*>(value.data()),
+      value.size());
+  bool found = false;
+  uint32_t tag;
+  while ((tag = input.ReadTag()) != 0) {
+    if (WireFormatLite::GetTagFieldNumber(tag) == Datum::kGroupIdFieldNumber &&
+        WireFormatLite::GetTagWireType(tag) ==
+        WireFormatLite::WIRETYPE_VARINT) {
+      uint64_t id;
+      CHECK(input.ReadVarint64(&id)) << "Corrupted datum";
+      *group_id = static_cast<int32_t>(id);
+      found = true;
     } else {
-      // we will prefer to use data() first, and then try float_data()
-      if (data.size()) {
-        for (int j = 0; j < size; ++j) {
-          top_data[itemid * size + j] =
-              (static_cast<Dtype>((uint8_t)data[j]) - mean[j]) * scale;
+      CHECK(WireFormatLite::SkipField(&input, tag)) << "Corrupted datum";
+    }
+  }
+  return found;
+}
+
+// The fields of a serialized Datum whose features are a packed float_data,
+// pointing into the record. Filled by ScanPackedFloatDatum.
+struct PackedFloatDatum {
+  const char* float_data;
+  int float_data_size;
+  bool has_label;
+  int label;
+  // The packed float_label, if there is no label
+  const char* float_label;
+  int float_label_size;
+  bool has_group_id;
+  int group_id;
+};
+
+// Finds the fields of a serialized Datum with packed float_data features
+// without parsing it, so that the features can be copied straight out of the
+// record. Returns false for any other record: uint8 or fp16 features, sparse
+// ones, and the unpacked float_data and float_label of datasets written
+// before those fields were packed, which all take the full parse.
+static bool ScanPackedFloatDatum(const char* record, const size_t length,
+    PackedFloatDatum* datum) {
+  CodedInputStream input(reinterpret_cast<const uint8_t*>(record), length);
+  datum->float_data = NULL;
+  datum->float_data_size = 0;
+  datum->has_label = false;
+  datum->float_label = NULL;
+  datum->float_label_size = 0;
+  datum->has_group_id = false;
+  uint32_t tag;
+  while ((tag = input.ReadTag()) != 0) {
+    const int field = WireFormatLite::GetTagFieldNumber(tag);
+    const WireFormatLite::WireType type = WireFormatLite::GetTagWireType(tag);
+    if (field == Datum::kFloatDataFieldNumber ||
+        field == Datum::kFloatLabelFieldNumber) {
+      uint32_t bytes;
+      if (type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED ||
+          !input.ReadVarint32(&bytes) || bytes % sizeof(float) ||
+          bytes > length - input.CurrentPosition()) {
+        return false;
+      }
+      const char* payload = record + input.CurrentPosition();
+      const int count = bytes / sizeof(float);
+      // A repeated field may come in several pieces; leave those to the
+      // parser.
+      if (field == Datum::kFloatDataFieldNumber) {
+        if (datum->float_data) {
+          return false;
         }
+        datum->float_data = payload;
+        datum->float_data_size = count;
       } else {
-        for (int j = 0; j < size; ++j) {
-          top_data[itemid * size + j] =
-              (datum.float_data(j) - mean[j]) * scale;
+        if (datum->float_label) {
+          return false;
         }
+        datum->float_label = payload;
+        datum->float_label_size = count;
+      }
+      input.Skip(bytes);
+    } else if ((field == Datum::kLabelFieldNumber ||
+        field == Datum::kGroupIdFieldNumber) &&
+        type == WireFormatLite::WIRETYPE_VARINT) {
+      uint64_t value;
+      if (!input.ReadVarint64(&value)) {
+        return false;
       }
+      if (field == Datum::kLabelFieldNumber) {
+        datum->has_label = true;
+        datum->label = static_cast<int32_t>(value);
+      } else {
+        datum->has_group_id = true;
+        datum->group_id = static_cast<int32_t>(value);
+      }
+    } else if (field == Datum::kDataFieldNumber ||
+        field == Datum::kHalfDataFieldNumber) {
+      // Features in data or half_data win over float_data, but empty ones
+      // do not count.
+      uint32_t bytes;
+      if (type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED ||
+          !input.ReadVarint32(&bytes) || bytes) {
+        return false;
+      }
+    } else if (field == Datum::kSparseIndexFieldNumber ||
+        field == Datum::kSparseValueFieldNumber ||
+        field == Datum::kSparseDimFieldNumber) {
+      return false;
+    } else if (!WireFormatLite::SkipField(&input, tag)) {
+      return false;
     }
+  }
+  return datum->float_data != NULL;
+}
+
+// Draws the four random words of one item of a batch from the Philox stream
+// of a layer. Any item can be drawn from any thread, in any order.
+static void DataLayerDraw(const uint32_t stream, const uint64_t batch_index,
+    const uint32_t item, uint32_t out[4]) {
+  const uint32_t counter[4] = {item, 0, static_cast<uint32_t>(batch_index),
+      static_cast<uint32_t>(batch_index >> 32)};
+  const uint32_t key[2] = {Caffe::rng_seed(), stream};
+  philox4x32(counter, key, out);
+}
+
+// Maps a random word onto [0, n).
+static inline int DataLayerUniformInt(const uint32_t word, const int n) {
+  return static_cast<int>((static_cast<uint64_t>(word) * n) >> 32);
+}
 
+// Draws the random crop and mirror of the record in slot itemid of a batch.
+template <typename Dtype>
+void DataLayerDrawTransform(DataLayer<Dtype>* layer, const uint64_t batch_index,
+    const int itemid, DatumTransform* transform) {
+  const int cropsize = layer->layer_param_.cropsize();
+  const int height = layer->datum_height_;
+  const int width = layer->datum_width_;
+  uint32_t words[4];
+  DataLayerDraw(layer->rng_stream_, batch_index, itemid, words);
+  // We only do random crop when we do training.
+  if (Caffe::phase() == Caffe::TRAIN) {
+    transform->h_off = DataLayerUniformInt(words[0], height - cropsize + 1);
+    transform->w_off = DataLayerUniformInt(words[1], width - cropsize + 1);
+  } else {
+    transform->h_off = (height - cropsize) / 2;
+    transform->w_off = (width - cropsize) / 2;
+  }
+  transform->mirror = layer->layer_param_.mirror() && (words[2] & 1);
+}
+
+// Writes the label and query id of one parsed record into slot itemid.
+template <typename Dtype>
+static void DataLayerDecodeLabel(const Datum& datum, const int itemid,
+    Dtype* top_label, Dtype* top_qid) {
 	if(datum.has_label())
 		top_label[itemid] = datum.label();
 	else
@@ -138,39 +367,849 @@ void* DataLayerPrefetch(void* layer_pointer) {
 	// top[3] stores the query id
 	if(datum.has_group_id() && top_qid != NULL)
 		top_qid[itemid] = datum.group_id();
+}
+
+// Writes the normalized data, label and query id of one parsed record into
+// slot itemid of the batch buffers.
+template <typename Dtype>
+void DataLayerDecodeDatum(DataLayer<Dtype>* layer, const Datum& datum,
+    const DataBatch<Dtype>& batch, const int itemid, Dtype* top_data,
+    Dtype* top_label, Dtype* top_qid) {
+  const int cropsize = layer->layer_param_.cropsize();
+  // datum scales
+  const int channels = layer->datum_channels_;
+  const int height = layer->datum_height_;
+  const int width = layer->datum_width_;
+  const int size = layer->datum_size_;
+  const Dtype* norm_scale = &batch.norm_scale_[0];
+  const Dtype* norm_shift = &batch.norm_shift_[0];
+
+  const string& data = datum.data();
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+  if (cropsize) {
+    CHECK(data.size()) << "Image cropping only support uint8 data";
+    DatumTransform transform;
+    DataLayerDrawTransform(layer, batch.index_, itemid, &transform);
+    const int h_off = transform.h_off;
+    const int w_off = transform.w_off;
+    for (int c = 0; c < channels; ++c) {
+      for (int h = 0; h < cropsize; ++h) {
+        const int src = (c * height + h + h_off) * width + w_off;
+        Dtype* out = top_data + ((itemid * channels + c) * cropsize + h)
+            * cropsize;
+        caffe_dequantize_uint8(cropsize, bytes + src, norm_scale + src,
+            norm_shift + src, out);
+        if (transform.mirror) {
+          std::reverse(out, out + cropsize);
+        }
+      }
+    }
+  } else {
+    // we will prefer to use data() first, then half_data() and float_data()
+    Dtype* out = top_data + itemid * size;
+    const string& half_data = datum.half_data();
+    if (data.size()) {
+      CHECK_EQ(data.size(), size);
+      caffe_dequantize_uint8(size, bytes, norm_scale, norm_shift, out);
+    } else if (half_data.size()) {
+      CHECK_EQ(half_data.size(), 2 * size);
+      caffe_dequantize_half(size,
+          reinterpret_cast<const uint16_t*>(half_data.data()), norm_scale,
+          norm_shift, out);
+    } else {
+      CHECK_EQ(datum.float_data_size(), size);
+      caffe_dequantize_float(size, datum.float_data().data(), norm_scale,
+          norm_shift, out);
+    }
+  }
+
+  DataLayerDecodeLabel(datum, itemid, top_label, top_qid);
+}
+
+// Appends the scaled nonzeros of one parsed sparse record to the staging
+// space of the batch and writes its label and query id.
+template <typename Dtype>
+void DataLayerDecodeSparseDatum(DataLayer<Dtype>* layer, const Datum& datum,
+    DataBatch<Dtype>* batch, const int itemid, int* top_ptr, Dtype* top_label,
+    Dtype* top_qid) {
+  const int nnz = datum.sparse_index_size();
+  CHECK_EQ(datum.sparse_value_size(), nnz);
+  const int* indices = datum.sparse_index().data();
+  const float* values = datum.sparse_value().data();
+  const Dtype scale = batch->scale_;
+  top_ptr[itemid] = batch->sparse_indices_.size();
+  for (int j = 0; j < nnz; ++j) {
+    CHECK_GE(indices[j], 0);
+    CHECK_LT(indices[j], layer->sparse_dim_);
+    batch->sparse_indices_.push_back(indices[j]);
+    batch->sparse_values_.push_back(values[j] * scale);
+  }
+  DataLayerDecodeLabel(datum, itemid, top_label, top_qid);
+}
+
+// Copies n packed little endian floats into out and normalizes them, in
+// place when Dtype is float.
+static void CopyPackedFloats(const int n, const char* x, const float* scale,
+    const float* shift, const bool identity, float* out) {
+  memcpy(out, x, n * sizeof(float));
+  if (!identity) {
+    caffe_dequantize_float(n, out, scale, shift, out);
+  }
+}
+
+static void CopyPackedFloats(const int n, const char* x, const double* scale,
+    const double* shift, const bool identity, double* out) {
+  for (int j = 0; j < n; ++j) {
+    float value;
+    memcpy(&value, x + j * sizeof(float), sizeof(float));
+    out[j] = value * scale[j] + shift[j];
+  }
+}
+
+// Reading the clock costs about as much as copying a packed float record, so
+// only every kDecodeSampleInterval-th record is timed on its own. The samples
+// split the time of a range of records between parsing and normalizing.
+const int kDecodeSampleInterval = 16;
+
+// Decodes one serialized dense record into slot itemid of the batch buffers.
+// Records with packed float features skip the Datum and are copied straight
+// from the wire; the rest are parsed into datum, which is reused from record
+// to record. A sampled record, given a non-NULL parse_ns, adds the time
+// spent parsing to *parse_ns and the rest to *normalize_ns.
+template <typename Dtype>
+void DataLayerDecodeRecord(DataLayer<Dtype>* layer, const char* record,
+    const size_t length, Datum* datum, const DataBatch<Dtype>& batch,
+    const int itemid, Dtype* top_data, Dtype* top_label, Dtype* top_qid,
+    int64_t* parse_ns, int64_t* normalize_ns) {
+  const int size = layer->datum_size_;
+  const int label_dim = layer->label_dim_;
+  const bool sampled = parse_ns != NULL;
+  const data_clock::time_point start =
+      sampled ? data_clock::now() : data_clock::time_point();
+  PackedFloatDatum packed;
+  if (!layer->layer_param_.cropsize() &&
+      ScanPackedFloatDatum(record, length, &packed) &&
+      (packed.has_label || packed.float_label_size == label_dim)) {
+    const data_clock::time_point parsed =
+        sampled ? data_clock::now() : start;
+    CHECK_EQ(packed.float_data_size, size);
+    CopyPackedFloats(size, packed.float_data, &batch.norm_scale_[0],
+        &batch.norm_shift_[0], batch.norm_identity_,
+        top_data + itemid * size);
+    if (packed.has_label) {
+      top_label[itemid] = packed.label;
+    } else {
+      for (int i = 0; i < label_dim; ++i) {
+        float value;
+        memcpy(&value, packed.float_label + i * sizeof(float), sizeof(float));
+        top_label[itemid * label_dim + i] = value;
+      }
+    }
+    if (packed.has_group_id && top_qid != NULL) {
+      top_qid[itemid] = packed.group_id;
+    }
+    if (sampled) {
+      *parse_ns += Nanos(parsed - start);
+      *normalize_ns += NanosSince(parsed);
+    }
+    return;
+  }
+  CHECK(datum->ParseFromArray(record, length));
+  const data_clock::time_point parsed = sampled ? data_clock::now() : start;
+  DataLayerDecodeDatum(layer, *datum, batch, itemid, top_data, top_label,
+      top_qid);
+  if (sampled) {
+    *parse_ns += Nanos(parsed - start);
+    *normalize_ns += NanosSince(parsed);
+  }
+}
+
+// Parses the raw records [begin, end) of a batch into the given Datum, which
+// is reused from record to record, and decodes them into the batch buffers.
+// Different ranges of the same batch can be decoded concurrently. The range
+// is timed as a whole and split by the sampled records.
+template <typename Dtype>
+void DataLayerDecodeItems(DataLayer<Dtype>* layer, DataBatch<Dtype>* batch,
+    const int begin, const int end, Datum* datum, Dtype* top_data,
+    Dtype* top_label, Dtype* top_qid) {
+  int64_t sampled_parse_ns = 0;
+  int64_t sampled_normalize_ns = 0;
+  const data_clock::time_point start = data_clock::now();
+  for (int itemid = begin; itemid < end; ++itemid) {
+    const string& record = batch->records_[itemid];
+    const bool sampled = (itemid - begin) % kDecodeSampleInterval == 0;
+    DataLayerDecodeRecord(layer, record.data(), record.size(), datum, *batch,
+        itemid, top_data, top_label, top_qid,
+        sampled ? &sampled_parse_ns : NULL, &sampled_normalize_ns);
+  }
+  const int64_t decode_ns = NanosSince(start);
+  const int64_t sampled_ns = sampled_parse_ns + sampled_normalize_ns;
+  const int64_t parse_ns = sampled_ns == 0 ? 0 : static_cast<int64_t>(
+      static_cast<double>(decode_ns) * sampled_parse_ns / sampled_ns);
+  layer->counters_->Add(DataLayerCounters::PARSE_NS, parse_ns);
+  layer->counters_->Add(DataLayerCounters::NORMALIZE_NS,
+      decode_ns - parse_ns);
+}
+
+// Shuffles order in place with the layer's random number generator.
+template <typename T>
+static void ShuffleOrder(vector<T>* order, gsl_rng* rng) {
+  for (int i = static_cast<int>(order->size()) - 1; i > 0; --i) {
+    std::swap((*order)[i], (*order)[gsl_rng_uniform_int(rng, i + 1)]);
+  }
+}
+
+// Returns the next entry of the shuffled order of this epoch: a record of a
+// dense dataset or a block of the jump index of a leveldb. The order is
+// reshuffled when an epoch ends.
+template <typename Dtype>
+int DataLayerNextShuffled(DataLayer<Dtype>* layer) {
+  if (layer->shuffle_pos_ == layer->shuffle_order_.size()) {
+    ShuffleOrder(&layer->shuffle_order_, layer->rng);
+    layer->shuffle_pos_ = 0;
+    ++layer->epoch_;
+    LOG(INFO) << "Data layer starts epoch " << layer->epoch_;
+  }
+  return layer->shuffle_order_[layer->shuffle_pos_++];
+}
+
+// Normalizes the slots [begin, end) of a batch read from a dense dataset.
+// Slot i holds record dense_records_[i] of the batch, whose row is staged in
+// stream_rows_ when the dataset is streamed.
+template <typename Dtype>
+void DataLayerDecodeDenseItems(DataLayer<Dtype>* layer,
+    const DataBatch<Dtype>& batch, const int begin, const int end,
+    Dtype* top_data) {
+  const DenseDatasetHeader* header = layer->dense_header_;
+  const char* features = layer->dense_map_ + header->feature_offset;
+  const int size = layer->datum_size_;
+  const size_t row_bytes = DenseFeatureBytes(*header) * size;
+  const Dtype* norm_scale = &batch.norm_scale_[0];
+  const Dtype* norm_shift = &batch.norm_shift_[0];
+  const vector<int>& records = batch.dense_records_;
+  const bool streamed = !batch.stream_rows_.empty();
+  const data_clock::time_point start = data_clock::now();
+  for (int itemid = begin; itemid < end; ++itemid) {
+    const char* row = streamed ? &batch.stream_rows_[itemid * row_bytes] :
+        features + static_cast<size_t>(records[itemid]) * row_bytes;
+    Dtype* out = top_data + itemid * size;
+    switch (header->feature_type) {
+    case DENSE_UINT8:
+      caffe_dequantize_uint8(size, reinterpret_cast<const uint8_t*>(row),
+          norm_scale, norm_shift, out);
+      break;
+    case DENSE_FLOAT16:
+      caffe_dequantize_half(size, reinterpret_cast<const uint16_t*>(row),
+          norm_scale, norm_shift, out);
+      break;
+    default:
+      caffe_dequantize_float(size, reinterpret_cast<const float*>(row),
+          norm_scale, norm_shift, out);
+    }
+  }
+  layer->counters_->Add(DataLayerCounters::NORMALIZE_NS, NanosSince(start));
+}
+
+// Picks the records of a batch out of a dataset of num records that are
+// read by index, a dense or an in-memory one. Records are read in order from
+// the current position and wrap around at the end, or in the shuffled order
+// of the epoch.
+template <typename Dtype>
+void DataLayerPickRecords(DataLayer<Dtype>* layer, const int num,
+    DataBatch<Dtype>* batch) {
+  const int batchsize = layer->layer_param_.batchsize();
+  vector<int>& records = batch->dense_records_;
+  records.resize(batchsize);
+  if (layer->layer_param_.shuffle()) {
+    for (int itemid = 0; itemid < batchsize; ++itemid) {
+      records[itemid] = DataLayerNextShuffled(layer);
+    }
+  } else {
+    if (layer->randomJump) {
+      layer->dense_pos_ = layer->randIdx;
+    }
+    for (int itemid = 0; itemid < batchsize; ++itemid) {
+      records[itemid] = (layer->dense_pos_ + itemid) % num;
+    }
+    layer->dense_pos_ = (layer->dense_pos_ + batchsize) % num;
+  }
+}
+
+// Folds the dequantization, the mean and the scale of a batch into its
+// per-feature normalization.
+template <typename Dtype>
+void DataLayerFoldNormalization(DataLayer<Dtype>* layer,
+    DataBatch<Dtype>* batch) {
+  const int size = layer->datum_size_;
+  const Dtype scale = batch->scale_;
+  const Dtype* quant_scale = layer->data_quant_.cpu_data();
+  const Dtype* quant_offset = quant_scale + size;
+  const Dtype* mean = layer->data_mean_.cpu_data();
+  batch->norm_scale_.resize(size);
+  batch->norm_shift_.resize(size);
+  batch->norm_identity_ = true;
+  for (int j = 0; j < size; ++j) {
+    batch->norm_scale_[j] = quant_scale[j] * scale;
+    batch->norm_shift_[j] = (quant_offset[j] - mean[j]) * scale;
+    batch->norm_identity_ = batch->norm_identity_ &&
+        batch->norm_scale_[j] == 1 && batch->norm_shift_[j] == 0;
+  }
+}
+
+// Fills a batch from the in-memory dataset, which already holds normalized
+// features. Only the scale jitter of the batch is left to apply.
+template <typename Dtype>
+void DataLayerLoadMemoryBatch(DataLayer<Dtype>* layer,
+    DataBatch<Dtype>* batch) {
+  const int batchsize = layer->layer_param_.batchsize();
+  const int size = layer->datum_size_;
+  const int label_dim = layer->label_dim_;
+  Dtype* top_data = batch->data_->mutable_cpu_data();
+  Dtype* top_label = batch->label_->mutable_cpu_data();
+  Dtype* top_qid = (batch->qid_.get() == NULL) ? NULL : batch->qid_->mutable_cpu_data();
+  DataLayerPickRecords(layer, layer->memory_num_, batch);
+  const vector<int>& records = batch->dense_records_;
+  const Dtype scale = layer->layer_param_.scale();
+  const bool jittered = batch->scale_ != scale;
+  const data_clock::time_point start = data_clock::now();
+  for (int itemid = 0; itemid < batchsize; ++itemid) {
+    const size_t record = records[itemid];
+    const Dtype* row = &layer->memory_data_[record * size];
+    Dtype* out = top_data + itemid * size;
+    if (jittered) {
+      const Dtype jitter = batch->scale_ / scale;
+      for (int j = 0; j < size; ++j) {
+        out[j] = row[j] * jitter;
+      }
+    } else {
+      memcpy(out, row, sizeof(Dtype) * size);
+    }
+    memcpy(top_label + itemid * label_dim,
+        &layer->memory_label_[record * label_dim], sizeof(Dtype) * label_dim);
+    if (top_qid != NULL) {
+      top_qid[itemid] = layer->memory_qid_[record];
+    }
+  }
+  const int64_t normalize_ns = NanosSince(start);
+  layer->counters_->Add(DataLayerCounters::NORMALIZE_NS, normalize_ns);
+  batch->decode_ns_ += normalize_ns;
+}
+
+// Fills a batch from a memory-mapped dense dataset. When there is nothing to
+// normalize the features are copied with one memcpy per run of consecutive
+// records.
+template <typename Dtype>
+void DataLayerLoadDenseBatch(DataLayer<Dtype>* layer,
+    DataBatch<Dtype>* batch) {
+  const DenseDatasetHeader* header = layer->dense_header_;
+  const int batchsize = layer->layer_param_.batchsize();
+  const int size = layer->datum_size_;
+  const int label_dim = header->label_dim;
+  Dtype* top_data = batch->data_->mutable_cpu_data();
+  Dtype* top_label = batch->label_->mutable_cpu_data();
+  Dtype* top_qid = (batch->qid_.get() == NULL) ? NULL : batch->qid_->mutable_cpu_data();
+  DataLayerPickRecords(layer, header->num, batch);
+  const vector<int>& records = batch->dense_records_;
+
+  const char* features = layer->dense_map_ + header->feature_offset;
+  const size_t row_bytes = DenseFeatureBytes(*header) * size;
+  const bool plain_copy = sizeof(Dtype) == sizeof(float) &&
+      header->feature_type == DENSE_FLOAT32 && batch->scale_ == Dtype(1) &&
+      !layer->layer_param_.has_meanfile() &&
+      !layer->layer_param_.has_quantization_file();
+  // A streamed batch has its raw rows staged for the decode workers.
+  SequentialFileReader* stream = layer->dense_stream_.get();
+  if (stream != NULL && !plain_copy) {
+    batch->stream_rows_.resize(batchsize * row_bytes);
+  }
+  layer->counters_->Add(DataLayerCounters::BYTES,
+      static_cast<int64_t>(batchsize) * row_bytes);
+  if (plain_copy || stream != NULL) {
+    char* rows = plain_copy ? reinterpret_cast<char*>(top_data) :
+        &batch->stream_rows_[0];
+    for (int itemid = 0; itemid < batchsize; ) {
+      int run = 1;
+      while (itemid + run < batchsize &&
+          records[itemid + run] == records[itemid] + run) {
+        ++run;
+      }
+      const uint64_t offset =
+          static_cast<uint64_t>(records[itemid]) * row_bytes;
+      if (stream != NULL) {
+        stream->Read(offset, run * row_bytes, rows + itemid * row_bytes);
+      } else {
+        memcpy(rows + itemid * row_bytes, features + offset, run * row_bytes);
+      }
+      itemid += run;
+    }
+  }
+  if (!plain_copy) {
+    DecodeWorkers* workers = layer->decode_workers_.get();
+    const int num_workers = workers->size();
+    RunTimed(workers, [=](int worker_id) {
+      DataLayerDecodeDenseItems(layer, *batch,
+          batchsize * worker_id / num_workers,
+          batchsize * (worker_id + 1) / num_workers, top_data);
+    }, &batch->decode_ns_);
+  }
+
+  const float* labels = reinterpret_cast<const float*>(
+      layer->dense_map_ + header->label_offset);
+  for (int itemid = 0; itemid < batchsize; ++itemid) {
+    const float* label =
+        labels + static_cast<size_t>(records[itemid]) * label_dim;
+    for (int i = 0; i < label_dim; ++i) {
+      top_label[itemid * label_dim + i] = label[i];
+    }
+  }
+
+  if (top_qid != NULL && header->num_groups) {
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(
+        layer->dense_map_ + header->group_offset);
+    const int32_t* group_ids = reinterpret_cast<const int32_t*>(
+        layer->dense_map_ + header->group_id_offset);
+    // offsets holds num_groups + 1 ascending record offsets
+    for (int itemid = 0; itemid < batchsize; ++itemid) {
+      const int group = std::upper_bound(offsets,
+          offsets + header->num_groups + 1,
+          static_cast<uint32_t>(records[itemid])) - offsets - 1;
+      top_qid[itemid] = group_ids[group];
+    }
+  }
+
+  if (layer->layer_param_.shuffle()) {
+    // Read ahead the scattered rows of the next batch of this epoch.
+    const vector<int>& order = layer->shuffle_order_;
+    const int next_end = std::min(layer->shuffle_pos_ + batchsize,
+        static_cast<int>(order.size()));
+    for (int i = layer->shuffle_pos_; i < next_end; ++i) {
+      AdviseWillNeed(features + static_cast<size_t>(order[i]) * row_bytes,
+          row_bytes);
+    }
+  }
+}
+
+// Decodes the first count staged records of a batch on the decode workers.
+template <typename Dtype>
+void DataLayerDecodeStaged(DataLayer<Dtype>* layer, DataBatch<Dtype>* batch,
+    const int count, Dtype* top_data, Dtype* top_label, Dtype* top_qid) {
+  int64_t bytes = 0;
+  for (int itemid = 0; itemid < count; ++itemid) {
+    bytes += batch->records_[itemid].size();
+  }
+  layer->counters_->Add(DataLayerCounters::BYTES, bytes);
+  DecodeWorkers* workers = layer->decode_workers_.get();
+  const int num_workers = workers->size();
+  RunTimed(workers, [=](int worker_id) {
+    DataLayerDecodeItems(layer, batch, count * worker_id / num_workers,
+        count * (worker_id + 1) / num_workers,
+        &layer->decode_datum_[worker_id], top_data, top_label, top_qid);
+  }, &batch->decode_ns_);
+}
+
+// Advances the leveldb iterator, wrapping around at the end. Returns false
+// when it wrapped.
+template <typename Dtype>
+bool DataLayerNextRecord(DataLayer<Dtype>* layer) {
+  layer->iter_->Next();
+  if (!layer->iter_->Valid()) {
+    // We have reached the end. Restart from the first.
+    DLOG(INFO) << "Restarting data prefetching from start.";
+    layer->iter_->SeekToFirst();
+    return false;
+  }
+  return true;
+}
+
+// Copies the records of the query group under the iterator into group and
+// moves past it. A group is a run of records with the same group_id; the end
+// of the leveldb closes a group and records without a group_id are groups of
+// their own.
+template <typename Dtype>
+void DataLayerReadQueryGroup(DataLayer<Dtype>* layer, vector<string>* group) {
+  int first_id, id;
+  CHECK(layer->iter_->Valid());
+  const bool has_id = ReadDatumGroupId(layer->iter_->value(), &first_id);
+  do {
+    const leveldb::Slice value = layer->iter_->value();
+    group->push_back(string(value.data(), value.size()));
+    if (!DataLayerNextRecord(layer))
+      return;
+  } while (has_id && ReadDatumGroupId(layer->iter_->value(), &id) &&
+      id == first_id);
+}
+
+// Stages whole query groups into the records of a batch until the next group
+// does not fit. That group is kept for the next batch. A group larger than
+// the batch is cut. Returns the number of staged records.
+template <typename Dtype>
+int DataLayerStageQueryGroups(DataLayer<Dtype>* layer,
+    DataBatch<Dtype>* batch) {
+  const int batchsize = layer->layer_param_.batchsize();
+  vector<string>& group = layer->query_group_;
+  batch->records_.resize(batchsize);
+  batch->query_starts_.clear();
+  int filled = 0;
+  while (filled < batchsize) {
+    if (group.empty())
+      DataLayerReadQueryGroup(layer, &group);
+    if (group.size() > batchsize) {
+      LOG(WARNING) << "Cutting a query of " << group.size()
+          << " records to the batch size " << batchsize;
+      group.resize(batchsize);
+    }
+    if (filled + group.size() > batchsize)
+      break;
+    batch->query_starts_.push_back(filled);
+    for (int i = 0; i < group.size(); ++i) {
+      batch->records_[filled++].swap(group[i]);
+    }
+    group.clear();
+  }
+  batch->query_starts_.push_back(filled);
+  return filled;
+}
+
+// Fills a batch with whole query groups. The slots after the last group are
+// padding: zero data and label, and query id -1. The query offsets hold the
+// start of every query followed by the fill, and -1 after that.
+template <typename Dtype>
+void DataLayerLoadQueryBatch(DataLayer<Dtype>* layer, DataBatch<Dtype>* batch,
+    Dtype* top_data, Dtype* top_label, Dtype* top_qid) {
+  const int batchsize = layer->layer_param_.batchsize();
+  if (layer->randomJump) {
+    // Start at the first whole group after the jump.
+    layer->query_group_.clear();
+    int first_id, id;
+    if (ReadDatumGroupId(layer->iter_->value(), &first_id)) {
+      while (DataLayerNextRecord(layer) &&
+          ReadDatumGroupId(layer->iter_->value(), &id) && id == first_id) {
+      }
+    }
+  }
+  const int filled = DataLayerStageQueryGroups(layer, batch);
+  DataLayerDecodeStaged(layer, batch, filled, top_data, top_label, top_qid);
+
+  const int data_dim = batch->data_->count() / batchsize;
+  const int label_dim = batch->label_->count() / batchsize;
+  memset(top_data + filled * data_dim, 0,
+      sizeof(Dtype) * (batchsize - filled) * data_dim);
+  memset(top_label + filled * label_dim, 0,
+      sizeof(Dtype) * (batchsize - filled) * label_dim);
+  for (int itemid = filled; itemid < batchsize; ++itemid) {
+    top_qid[itemid] = -1;
+  }
+  if (batch->query_offsets_) {
+    Dtype* offsets = batch->query_offsets_->mutable_cpu_data();
+    const vector<int>& starts = batch->query_starts_;
+    for (int i = 0; i <= batchsize; ++i) {
+      offsets[i] = i < starts.size() ? starts[i] : -1;
+    }
+  }
+}
+
+// Refills the shuffle window with the records of the next shuffle_window
+// blocks of the epoch, one seek per block, and shuffles them. A window does
+// not reach into the next epoch.
+template <typename Dtype>
+void DataLayerFillShuffleWindow(DataLayer<Dtype>* layer) {
+  vector<string>& window = layer->shuffle_window_;
+  window.clear();
+  const int blocks = layer->layer_param_.shuffle_window();
+  for (int b = 0; b < blocks; ++b) {
+    if (b > 0 && layer->shuffle_pos_ == layer->shuffle_order_.size())
+      break;
+    const int block = DataLayerNextShuffled(layer);
+    layer->iter_->Seek(layer->dbKeys[block]);
+    for (int i = 0; i < layer->jump_stride_ && layer->iter_->Valid(); ++i) {
+      const leveldb::Slice value = layer->iter_->value();
+      window.push_back(string(value.data(), value.size()));
+      layer->iter_->Next();
+    }
+  }
+  ShuffleOrder(&window, layer->rng);
+  layer->shuffle_window_pos_ = 0;
+}
+
+// Fills a batch with the next records of the shuffle window.
+template <typename Dtype>
+void DataLayerLoadShuffledBatch(DataLayer<Dtype>* layer,
+    DataBatch<Dtype>* batch, Dtype* top_data, Dtype* top_label,
+    Dtype* top_qid) {
+  const int batchsize = layer->layer_param_.batchsize();
+  batch->records_.resize(batchsize);
+  for (int itemid = 0; itemid < batchsize; ++itemid) {
+    if (layer->shuffle_window_pos_ == layer->shuffle_window_.size())
+      DataLayerFillShuffleWindow(layer);
+    batch->records_[itemid].swap(
+        layer->shuffle_window_[layer->shuffle_window_pos_++]);
+  }
+  DataLayerDecodeStaged(layer, batch, batchsize, top_data, top_label, top_qid);
+}
+
+// Reads the raw records of one batch on the prefetch thread. The random
+// numbers of the batch are counted from its index, so the result does not
+// depend on how many decode workers share the parsing afterwards.
+template <typename Dtype>
+void DataLayerLoadBatch(DataLayer<Dtype>* layer, DataBatch<Dtype>* batch) {
+  CHECK(batch->data_);
+  batch->index_ = layer->batch_index_++;
+  Dtype scale = layer->layer_param_.scale();
+  if(Caffe::phase() == Caffe::TRAIN)
+  {
+	// The jitter takes the words of an item no record can have.
+	uint32_t words[4];
+	DataLayerDraw(layer->rng_stream_, batch->index_, 0xffffffffu, words);
+	const double uniform = words[0] / 4294967296.;
+	scale = scale *(1 + layer->layer_param_.jitter_rate() * 2 * (uniform - 0.5));
+  }
+  batch->scale_ = scale;
+  batch->decode_ns_ = 0;
+  if (layer->memory_num_) {
+    DataLayerLoadMemoryBatch(layer, batch);
+    return;
+  }
+  if (!layer->sparse_dim_) {
+    const data_clock::time_point start = data_clock::now();
+    DataLayerFoldNormalization(layer, batch);
+    batch->decode_ns_ = NanosSince(start);
+    layer->counters_->Add(DataLayerCounters::NORMALIZE_NS, batch->decode_ns_);
+  }
+  const int batchsize = layer->layer_param_.batchsize();
+  const int cropsize = layer->layer_param_.cropsize();
+  const bool mirror = layer->layer_param_.mirror();
+
+  if (mirror && cropsize == 0) {
+    LOG(FATAL) << "Current implementation requires mirror and cropsize to be "
+        << "set at the same time.";
+  }
+  if (layer->dense_header_ != NULL) {
+    DataLayerLoadDenseBatch(layer, batch);
+    return;
+  }
+
+  if (layer->randomJump) {
+	  /*Random jump to a point in database*/
+	  layer->iter_->Seek(layer->dbKeys[layer->randIdx]);
+	  for (int i = 0; i < layer->jump_skip_; ++i)
+		  DataLayerNextRecord(layer);
+  }
+
+  // The blob pointers are taken here since SyncedMemory is not safe to touch
+  // from many threads.
+  const bool sparse = layer->sparse_dim_ > 0;
+  Dtype* top_data = sparse ? NULL : batch->data_->mutable_cpu_data();
+  Dtype* top_label = batch->label_->mutable_cpu_data();
+  Dtype* top_qid = (batch->qid_.get() == NULL) ? NULL : batch->qid_->mutable_cpu_data();
+  DecodeWorkers* workers = layer->decode_workers_.get();
+  const int num_workers = workers->size();
+  // A single worker parses straight from the leveldb slice, while a pool
+  // needs the records staged. The staging strings keep their capacity from
+  // batch to batch. Sparse records are appended in order, so they are always
+  // decoded here.
+  const bool staged = num_workers > 1 && !sparse;
+  vector<int> sparse_ptr;
+  if (sparse) {
+    batch->sparse_indices_.clear();
+    batch->sparse_values_.clear();
+    sparse_ptr.resize(batchsize + 1);
+  }
+
+  if (layer->layer_param_.query_batching()) {
+    DataLayerLoadQueryBatch(layer, batch, top_data, top_label, top_qid);
+    return;
+  }
+  if (layer->layer_param_.shuffle()) {
+    DataLayerLoadShuffledBatch(layer, batch, top_data, top_label, top_qid);
+    return;
+  }
+
+  batch->records_.resize(batchsize);
+  int64_t bytes = 0;
+  // Reading the leveldb is interleaved with decoding here, so the decode
+  // time is extrapolated from the sampled records alone.
+  int64_t sampled_parse_ns = 0;
+  int64_t sampled_normalize_ns = 0;
+  int num_sampled = 0;
+  for (int itemid = 0; itemid < batchsize; ++itemid) {
+    // get a blob
+    CHECK(layer->iter_);
+    CHECK(layer->iter_->Valid());
+    const leveldb::Slice value = layer->iter_->value();
+    bytes += value.size();
+    if (staged) {
+      batch->records_[itemid].assign(value.data(), value.size());
+    } else {
+      Datum* datum = &layer->decode_datum_[0];
+      const bool sampled = itemid % kDecodeSampleInterval == 0;
+      num_sampled += sampled;
+      if (sparse) {
+        const data_clock::time_point start =
+            sampled ? data_clock::now() : data_clock::time_point();
+        CHECK(datum->ParseFromArray(value.data(), value.size()));
+        const data_clock::time_point parsed =
+            sampled ? data_clock::now() : start;
+        DataLayerDecodeSparseDatum(layer, *datum, batch, itemid,
+            &sparse_ptr[0], top_label, top_qid);
+        if (sampled) {
+          sampled_parse_ns += Nanos(parsed - start);
+          sampled_normalize_ns += NanosSince(parsed);
+        }
+      } else {
+        DataLayerDecodeRecord(layer, value.data(), value.size(), datum,
+            *batch, itemid, top_data, top_label, top_qid,
+            sampled ? &sampled_parse_ns : NULL, &sampled_normalize_ns);
+      }
+    }
     // go to the next iter
-    layer->iter_->Next();
-    if (!layer->iter_->Valid()) {
-      // We have reached the end. Restart from the first.
-      DLOG(INFO) << "Restarting data prefetching from start.";
-      layer->iter_->SeekToFirst();
+    DataLayerNextRecord(layer);
+  }
+  layer->counters_->Add(DataLayerCounters::BYTES, bytes);
+  if (num_sampled) {
+    const double records_per_sample =
+        static_cast<double>(batchsize) / num_sampled;
+    const int64_t parse_ns = sampled_parse_ns * records_per_sample;
+    const int64_t normalize_ns = sampled_normalize_ns * records_per_sample;
+    layer->counters_->Add(DataLayerCounters::PARSE_NS, parse_ns);
+    layer->counters_->Add(DataLayerCounters::NORMALIZE_NS, normalize_ns);
+    batch->decode_ns_ += parse_ns + normalize_ns;
+  }
+
+  if (sparse) {
+    const int nnz = batch->sparse_indices_.size();
+    sparse_ptr[batchsize] = nnz;
+    Blob<Dtype>* data = batch->data_.get();
+    data->ReshapeSparse(batchsize, layer->sparse_dim_, nnz);
+    memcpy(data->mutable_cpu_sparse_ptr(), &sparse_ptr[0],
+        sizeof(int) * (batchsize + 1));
+    if (nnz) {
+      memcpy(data->mutable_cpu_sparse_indices(), &batch->sparse_indices_[0],
+          sizeof(int) * nnz);
+      memcpy(data->mutable_cpu_sparse_values(), &batch->sparse_values_[0],
+          sizeof(Dtype) * nnz);
     }
   }
 
+  if (staged) {
+    // Decode disjoint slices of the batch in parallel
+    RunTimed(workers, [=](int worker_id) {
+      DataLayerDecodeItems(layer, batch, batchsize * worker_id / num_workers,
+          batchsize * (worker_id + 1) / num_workers,
+          &layer->decode_datum_[worker_id], top_data, top_label, top_qid);
+    }, &batch->decode_ns_);
+  }
+}
+
+// The prefetch thread lives as long as the layer. It keeps filling batches
+// from the free queue and hands them over through the full queue, so up to
+// prefetch_count batches are read ahead of the solver. A NULL batch asks the
+// thread to quit.
+template <typename Dtype>
+void* DataLayerPrefetch(void* layer_pointer) {
+  CHECK(layer_pointer);
+  DataLayer<Dtype>* layer = reinterpret_cast<DataLayer<Dtype>*>(layer_pointer);
+  CHECK(layer);
+  while (true) {
+    DataBatch<Dtype>* batch = layer->prefetch_free_->pop();
+    if (batch == NULL) {
+      break;
+    }
+    layer->updateRandIdx();
+    const data_clock::time_point start = data_clock::now();
+    DataLayerLoadBatch(layer, batch);
+    // What is not decoding is reading.
+    DataLayerCounters* counters = layer->counters_.get();
+    counters->Add(DataLayerCounters::READ_NS,
+        NanosSince(start) - batch->decode_ns_);
+    counters->Add(DataLayerCounters::BATCHES, 1);
+    // A query batch ends with padding.
+    const vector<int>& query_starts = batch->query_starts_;
+    counters->Add(DataLayerCounters::RECORDS, query_starts.empty() ?
+        layer->layer_param_.batchsize() : query_starts.back());
+    layer->prefetch_full_->push(batch);
+    // Without batch_read the first batch is used for good, so stop here.
+    if (!layer->layer_param_.batch_read()) {
+      break;
+    }
+  }
   return (void*)NULL;
 }
 
 template <typename Dtype>
 DataLayer<Dtype>::~DataLayer<Dtype>() {
-  // Finally, join the thread
-	if(thread_.joinable())
+  // Finally, stop and join the thread
+	if(thread_.joinable()) {
+		prefetch_free_->push(NULL);
 		thread_.join();
+	}
   //CHECK(!pthread_join(thread_, NULL)) << "Pthread joining failed.";
 	if(rng != NULL)
 		gsl_rng_free(rng);
+	if(dense_map_ != NULL)
+		UnmapFile(dense_map_, dense_map_size_);
 }
 
 template <typename Dtype>
 void DataLayer<Dtype>::updateRandIdx() {
-	if(randomJump)
-		randIdx = gsl_rng_uniform(rng) * dbKeys.size();
+	if(randomJump && memory_num_)
+		randIdx = gsl_rng_uniform(rng) * memory_num_;
+	else if(randomJump && dense_header_ != NULL)
+		randIdx = gsl_rng_uniform(rng) * dense_header_->num;
+	else if(randomJump)
+	{
+		// Draw a record uniformly and reach it from the sampled key before it
+		const uint64_t record = gsl_rng_uniform(rng) * num_records_;
+		randIdx = record / jump_stride_;
+		jump_skip_ = record % jump_stride_;
+	}
 }
 
+// Loads the sampled keys that random jumps seek to: every jump_stride_-th key
+// of the leveldb. They come from jump_index_file if it holds an index with
+// the same stride, else from a scan of the keys, which is then saved there.
+// The index file has to be removed when the leveldb changes.
 template <typename Dtype>
-void DataLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
-      vector<Blob<Dtype>*>* top) {
-  CHECK_EQ(bottom.size(), 0) << "Data Layer takes no input blobs.";
-  CHECK_GE(top->size(), 2) << "Data Layer takes at least two blobs as output.";
+void DataLayer<Dtype>::SetUpJumpIndex() {
+  jump_stride_ = this->layer_param_.jump_index_stride();
+  CHECK_GT(jump_stride_, 0);
+  const string& index_file = this->layer_param_.jump_index_file();
+  KeyIndex index;
+  if (!index_file.empty() && std::ifstream(index_file.c_str()).good()) {
+    LOG(INFO) << "Loading jump index " << index_file;
+    ReadProtoFromBinaryFile(index_file.c_str(), &index);
+    if (index.stride() != jump_stride_) {
+      LOG(INFO) << "The jump index has stride " << index.stride()
+          << ", rebuilding it";
+      index.Clear();
+    }
+  }
+  if (index.keys_size() == 0) {
+    LOG(INFO) << "Sampling every " << jump_stride_ << "th key of the leveldb";
+    leveldb::ReadOptions options;
+    options.fill_cache = false;
+    shared_ptr<leveldb::Iterator> iter(db_->NewIterator(options));
+    uint64_t num_records = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++num_records) {
+      if (num_records % jump_stride_ == 0)
+        index.add_keys(iter->key().data(), iter->key().size());
+    }
+    index.set_stride(jump_stride_);
+    index.set_num_records(num_records);
+    if (!index_file.empty()) {
+      LOG(INFO) << "Saving jump index " << index_file;
+      WriteProtoToBinaryFile(index, index_file.c_str());
+    }
+  }
+  CHECK_GT(index.num_records(), 0) << "Empty leveldb";
+  num_records_ = index.num_records();
+  dbKeys.assign(index.keys().begin(), index.keys().end());
+  jump_skip_ = 0;
+  LOG(INFO) << "Jump index holds " << dbKeys.size() << " keys for "
+      << num_records_ << " records";
+}
+
+template <typename Dtype>
+void DataLayer<Dtype>::SetUpLevelDB() {
   // Initialize the leveldb
   leveldb::DB* db_temp;
   leveldb::Options options;
@@ -181,25 +1220,20 @@ void DataLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
   CHECK(status.ok()) << "Failed to open leveldb "
       << this->layer_param_.source() << std::endl << status.ToString();
   db_.reset(db_temp);
-  iter_.reset(db_->NewIterator(leveldb::ReadOptions()));
-  randomJump = this->layer_param_.random_jump() & (Caffe::phase() == Caffe::TRAIN);
-  if(randomJump)
-  {
-	  /*Read all the keys in database*/
-	  iter_->SeekToFirst();
-	  while(iter_->Valid())
-	  {
-		  dbKeys.push_back(iter_->key().ToString());
-		  iter_->Next();
-	  }
-  }
-  gsl_rng_default_seed = (unsigned long)(time(NULL));
-  rng = gsl_rng_alloc(gsl_rng_default);
+  // A streamed leveldb is read once per epoch, so its blocks are not worth
+  // keeping in the block cache.
+  leveldb::ReadOptions read_options;
+  read_options.fill_cache = !this->layer_param_.streaming();
+  iter_.reset(db_->NewIterator(read_options));
+  // An in-memory dataset is read by index instead.
+  if((randomJump || this->layer_param_.shuffle()) && !in_memory_)
+	  SetUpJumpIndex();
 
   iter_->SeekToFirst();
   // Check if we would need to randomly skip a few data points
   if (this->layer_param_.rand_skip()) {
-    unsigned int skip = rand() % this->layer_param_.rand_skip();
+    unsigned int skip = gsl_rng_uniform_int(rng,
+        this->layer_param_.rand_skip());
     LOG(INFO) << "Skipping first " << skip << " data points.";
     while (skip-- > 0) {
       iter_->Next();
@@ -208,43 +1242,362 @@ void DataLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
       }
     }
   }
-  // Read a data point, and use it to initialize the top blob.
+  // Read a data point, and use it to initialize the shapes.
   Datum datum;
-  datum.ParseFromString(iter_->value().ToString());
+  CHECK(datum.ParseFromArray(iter_->value().data(), iter_->value().size()));
+  datum_channels_ = datum.channels();
+  datum_height_ = datum.height();
+  datum_width_ = datum.width();
+  label_dim_ = datum.has_label() ? 1 : datum.float_label_size();
+  // Sparse records are served as a CSR blob of sparse_dim columns.
+  sparse_dim_ = datum.sparse_dim();
+  if (sparse_dim_) {
+    datum_channels_ = sparse_dim_;
+    datum_height_ = 1;
+    datum_width_ = 1;
+    CHECK_EQ(this->layer_param_.cropsize(), 0)
+        << "Cropping is not supported for sparse data";
+    CHECK(!this->layer_param_.has_meanfile())
+        << "Mean subtraction is not supported for sparse data";
+    CHECK(!this->layer_param_.zero_copy())
+        << "zero_copy is not supported for sparse data";
+  }
+}
+
+template <typename Dtype>
+void DataLayer<Dtype>::SetUpDenseSource() {
+  LOG(INFO) << "Mapping dense dataset " << this->layer_param_.source();
+  dense_map_ = MapFileReadOnly(this->layer_param_.source(), &dense_map_size_);
+  CHECK_GE(dense_map_size_, sizeof(DenseDatasetHeader))
+      << "Truncated dense dataset";
+  dense_header_ = reinterpret_cast<const DenseDatasetHeader*>(dense_map_);
+  CheckDenseDatasetHeader(*dense_header_, dense_map_size_);
+  CHECK_EQ(this->layer_param_.cropsize(), 0)
+      << "Cropping is not supported for dense datasets";
+  LOG(INFO) << "Dense dataset holds " << dense_header_->num << " records in "
+      << dense_header_->num_groups << " groups";
+  dense_pos_ = 0;
+  if (this->layer_param_.rand_skip()) {
+    dense_pos_ = gsl_rng_uniform_int(rng, this->layer_param_.rand_skip())
+        % dense_header_->num;
+    LOG(INFO) << "Skipping first " << dense_pos_ << " data points.";
+  }
+  datum_channels_ = dense_header_->channels;
+  datum_height_ = dense_header_->height;
+  datum_width_ = dense_header_->width;
+  label_dim_ = dense_header_->label_dim;
+  // Streamed features are read in large chunks instead of through the map,
+  // which only serves the labels and groups then.
+  if (this->layer_param_.streaming()) {
+    const uint64_t feature_bytes = static_cast<uint64_t>(dense_header_->num) *
+        datum_channels_ * datum_height_ * datum_width_ *
+        DenseFeatureBytes(*dense_header_);
+    dense_stream_.reset(new SequentialFileReader(this->layer_param_.source(),
+        dense_header_->feature_offset,
+        dense_header_->feature_offset + feature_bytes,
+        static_cast<size_t>(this->layer_param_.stream_chunk_kb()) * 1024));
+  }
+}
+
+// Reads every shard of the source with a data layer of its own, so that each
+// has its own reader thread and prefetch ring. The shards must give batches
+// of the same shape.
+template <typename Dtype>
+void DataLayer<Dtype>::SetUpShards(const vector<string>& shards,
+    const vector<Blob<Dtype>*>& bottom, vector<Blob<Dtype>*>* top) {
+  LOG(INFO) << "Reading " << shards.size() << " shards";
+  vector<int> shape;
+  for (int i = 0; i < shards.size(); ++i) {
+    LayerParameter param = this->layer_param_;
+    param.set_source(shards[i]);
+    if (param.has_jump_index_file()) {
+      std::ostringstream jump_index_file;
+      jump_index_file << param.jump_index_file() << "." << i;
+      param.set_jump_index_file(jump_index_file.str());
+    }
+    shared_ptr<DataLayer<Dtype> > shard(new DataLayer<Dtype>(param));
+    shard->SetUp(bottom, top);
+    vector<int> shard_shape;
+    for (int j = 0; j < top->size(); ++j) {
+      shard_shape.push_back((*top)[j]->count());
+    }
+    if (i == 0) {
+      shape = shard_shape;
+    }
+    CHECK(shard_shape == shape) << "Shard " << shards[i]
+        << " gives batches of another shape than " << shards[0];
+    const double weight =
+        this->layer_param_.shard_order() == LayerParameter_ShardOrder_BY_SIZE ?
+        shard->SourceSize() : 1;
+    LOG(INFO) << "Shard " << shards[i] << " has weight " << weight;
+    shards_.push_back(shard);
+    // An empty shard is still read now and then.
+    shard_weights_.push_back(std::max(weight, 1.));
+    shard_credits_.push_back(0);
+  }
+}
+
+// Picks the shard the next batch comes from with a smooth weighted round
+// robin: every shard earns its weight in credit each time, and the richest
+// shard pays the total for its turn. Equal weights give plain round robin.
+template <typename Dtype>
+int DataLayer<Dtype>::NextShard() {
+  int next = 0;
+  double total = 0;
+  for (int i = 0; i < shards_.size(); ++i) {
+    shard_credits_[i] += shard_weights_[i];
+    total += shard_weights_[i];
+    if (shard_credits_[i] > shard_credits_[next]) {
+      next = i;
+    }
+  }
+  shard_credits_[next] -= total;
+  return next;
+}
+
+// How much data the source holds: the number of records when it is known,
+// or else the approximate bytes the leveldb takes on disk.
+template <typename Dtype>
+double DataLayer<Dtype>::SourceSize() {
+  if (memory_num_) {
+    return memory_num_;
+  }
+  if (dense_header_ != NULL) {
+    return dense_header_->num;
+  }
+  if (num_records_) {
+    return num_records_;
+  }
+  // iter_ belongs to the prefetch thread by now
+  shared_ptr<leveldb::Iterator> iter(db_->NewIterator(leveldb::ReadOptions()));
+  iter->SeekToFirst();
+  const string first = iter->key().ToString();
+  iter->SeekToLast();
+  // The limit of a range is exclusive
+  const string last = iter->key().ToString() + '\0';
+  const leveldb::Range range(first, last);
+  uint64_t size;
+  db_->GetApproximateSizes(&range, 1, &size);
+  return size;
+}
+
+// Decodes the whole source once into memory_data_, normalized with the
+// layer's scale, along with its labels and query ids. The source is closed
+// afterwards and batches are served from memory by index.
+template <typename Dtype>
+void DataLayer<Dtype>::SetUpMemory() {
+  CHECK(!sparse_dim_) << "in_memory is not supported for sparse data";
+  CHECK_EQ(this->layer_param_.cropsize(), 0)
+      << "in_memory does not support cropping";
+  CHECK(!this->layer_param_.query_batching())
+      << "in_memory does not support query_batching";
+  const int size = datum_size_;
+  DataBatch<Dtype> batch;
+  batch.scale_ = this->layer_param_.scale();
+  DataLayerFoldNormalization(this, &batch);
+  DecodeWorkers* workers = decode_workers_.get();
+  const int num_workers = workers->size();
+  if (dense_header_ != NULL) {
+    memory_num_ = dense_header_->num;
+    memory_data_.resize(static_cast<size_t>(memory_num_) * size);
+    memory_label_.resize(static_cast<size_t>(memory_num_) * label_dim_);
+    memory_qid_.assign(memory_num_, Dtype(0));
+    batch.dense_records_.resize(memory_num_);
+    for (int i = 0; i < memory_num_; ++i) {
+      batch.dense_records_[i] = i;
+    }
+    const int num = memory_num_;
+    Dtype* data = &memory_data_[0];
+    workers->Run([&](int worker_id) {
+      DataLayerDecodeDenseItems(this, batch, num * worker_id / num_workers,
+          num * (worker_id + 1) / num_workers, data);
+    });
+    const float* labels = reinterpret_cast<const float*>(
+        dense_map_ + dense_header_->label_offset);
+    std::copy(labels, labels + memory_label_.size(), memory_label_.begin());
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(
+        dense_map_ + dense_header_->group_offset);
+    const int32_t* group_ids = reinterpret_cast<const int32_t*>(
+        dense_map_ + dense_header_->group_id_offset);
+    for (int group = 0; group < dense_header_->num_groups; ++group) {
+      const int end = offsets[group + 1];
+      for (int i = offsets[group]; i < end; ++i) {
+        memory_qid_[i] = group_ids[group];
+      }
+    }
+    UnmapFile(dense_map_, dense_map_size_);
+    dense_map_ = NULL;
+    dense_header_ = NULL;
+  } else {
+    // Decode the leveldb a chunk of records at a time on the decode workers.
+    const int chunk = 1024;
+    batch.records_.resize(chunk);
+    for (iter_->SeekToFirst(); iter_->Valid(); ) {
+      int count = 0;
+      for (; count < chunk && iter_->Valid(); ++count, iter_->Next()) {
+        const leveldb::Slice value = iter_->value();
+        batch.records_[count].assign(value.data(), value.size());
+      }
+      memory_data_.resize(static_cast<size_t>(memory_num_ + count) * size);
+      memory_label_.resize(
+          static_cast<size_t>(memory_num_ + count) * label_dim_);
+      memory_qid_.resize(memory_num_ + count, Dtype(0));
+      Dtype* data = &memory_data_[static_cast<size_t>(memory_num_) * size];
+      Dtype* label =
+          &memory_label_[static_cast<size_t>(memory_num_) * label_dim_];
+      Dtype* qid = &memory_qid_[memory_num_];
+      workers->Run([&](int worker_id) {
+        DataLayerDecodeItems(this, &batch, count * worker_id / num_workers,
+            count * (worker_id + 1) / num_workers, &decode_datum_[worker_id],
+            data, label, qid);
+      });
+      memory_num_ += count;
+    }
+    iter_.reset();
+    db_.reset();
+    dense_pos_ = 0;
+    if (this->layer_param_.rand_skip()) {
+      dense_pos_ = gsl_rng_uniform_int(rng, this->layer_param_.rand_skip())
+          % memory_num_;
+    }
+  }
+  LOG(INFO) << "Loaded " << memory_num_ << " records into memory ("
+      << sizeof(Dtype) * memory_data_.size() / 1048576 << " MB of features)";
+}
+
+template <typename Dtype>
+void DataLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
+      vector<Blob<Dtype>*>* top) {
+  CHECK_EQ(bottom.size(), 0) << "Data Layer takes no input blobs.";
+  CHECK_GE(top->size(), 2) << "Data Layer takes at least two blobs as output.";
+  counters_.reset(new DataLayerCounters());
+  batch_served_ = false;
+  const vector<string> shards = ExpandShardList(this->layer_param_.source());
+  CHECK(!shards.empty()) << "No data source given";
+  if (shards.size() > 1) {
+    SetUpShards(shards, bottom, top);
+    return;
+  }
+  this->layer_param_.set_source(shards[0]);
+  randomJump = this->layer_param_.random_jump() & (Caffe::phase() == Caffe::TRAIN);
+  // Every layer, and every shard of one, draws from its own Philox stream.
+  // The gsl generator that drives jumps and shuffles is seeded from it too.
+  rng_stream_ = Caffe::NewRngStream();
+  batch_index_ = 0;
+  uint32_t words[4];
+  DataLayerDraw(rng_stream_, ~static_cast<uint64_t>(0), 0, words);
+  rng = gsl_rng_alloc(gsl_rng_default);
+  gsl_rng_set(rng, words[0]);
+  dense_map_ = NULL;
+  dense_header_ = NULL;
+  sparse_dim_ = 0;
+  query_group_.clear();
+  epoch_ = 0;
+  memory_num_ = 0;
+  num_records_ = 0;
+  // Streaming reads the source once per epoch, in order.
+  if (this->layer_param_.streaming()) {
+    CHECK(!this->layer_param_.shuffle()) << "streaming reads records in order";
+    CHECK(!this->layer_param_.in_memory())
+        << "streaming and in_memory do not mix";
+    randomJump = false;
+  }
+  // in_memory_if_supported is in_memory for the settings it supports. The
+  // source may still turn out to be sparse.
+  in_memory_ = this->layer_param_.in_memory();
+  if (!in_memory_ && this->layer_param_.in_memory_if_supported()) {
+    if (this->layer_param_.cropsize() || this->layer_param_.query_batching() ||
+        this->layer_param_.streaming()) {
+      LOG(WARNING) << "Data layer " << this->layer_param_.name()
+          << " reads its source at every pass: in_memory does not support "
+          << "cropping, query_batching or streaming";
+    } else {
+      in_memory_ = true;
+    }
+  }
+  if (this->layer_param_.source_type() == LayerParameter_DataSource_DENSE) {
+    SetUpDenseSource();
+  } else {
+    SetUpLevelDB();
+  }
+  if (in_memory_ && sparse_dim_ && !this->layer_param_.in_memory()) {
+    LOG(WARNING) << "Data layer " << this->layer_param_.name()
+        << " reads its source at every pass: in_memory does not support "
+        << "sparse data";
+    in_memory_ = false;
+    // SetUpLevelDB left out the jump index of an in-memory source.
+    if (randomJump || this->layer_param_.shuffle()) {
+      SetUpJumpIndex();
+    }
+  }
+  // Shuffled epochs read records, or blocks of a leveldb, in a fresh random
+  // order every epoch, so random jumps are not needed.
+  if (this->layer_param_.shuffle()) {
+    CHECK(!this->layer_param_.query_batching())
+        << "shuffle would break up the query groups";
+    CHECK(!sparse_dim_) << "shuffle is not supported for sparse data";
+    CHECK_GT(this->layer_param_.shuffle_window(), 0);
+    randomJump = false;
+  }
   // image
   int cropsize = this->layer_param_.cropsize();
-  if (cropsize > 0) {
+  if (sparse_dim_) {
+    (*top)[0]->ReshapeSparse(this->layer_param_.batchsize(), sparse_dim_, 0);
+  } else if (cropsize > 0) {
     (*top)[0]->Reshape(
-        this->layer_param_.batchsize(), datum.channels(), cropsize, cropsize);
-    prefetch_data_.reset(new Blob<Dtype>(
-        this->layer_param_.batchsize(), datum.channels(), cropsize, cropsize));
+        this->layer_param_.batchsize(), datum_channels_, cropsize, cropsize);
   } else {
     (*top)[0]->Reshape(
-        this->layer_param_.batchsize(), datum.channels(), datum.height(),
-        datum.width());
-    prefetch_data_.reset(new Blob<Dtype>(
-        this->layer_param_.batchsize(), datum.channels(), datum.height(),
-        datum.width()));
+        this->layer_param_.batchsize(), datum_channels_, datum_height_,
+        datum_width_);
   }
   LOG(INFO) << "output data size: " << (*top)[0]->num() << ","
       << (*top)[0]->channels() << "," << (*top)[0]->height() << ","
       << (*top)[0]->width();
   // label
-  int label_dim = datum.has_label() ? 1 : datum.float_label_size();
+  const int label_dim = label_dim_;
   (*top)[1]->Reshape(this->layer_param_.batchsize(), label_dim, 1, 1);
-  prefetch_label_.reset(
-      new Blob<Dtype>(this->layer_param_.batchsize(), label_dim, 1, 1));
-  if(top->size() == 3)
-  {
+  if(top->size() >= 3)
 	  (*top)[2]->Reshape(this->layer_param_.batchsize(), 1, 1, 1);
-	  prefetch_qid_.reset(
-		  new Blob<Dtype>(this->layer_param_.batchsize(), 1, 1, 1));
+  // With query_batching an optional fourth top gets the query offsets.
+  if (this->layer_param_.query_batching()) {
+    CHECK_GE(top->size(), 3) << "query_batching needs the query id top";
+    CHECK(dense_header_ == NULL && !sparse_dim_)
+        << "query_batching is only supported for dense leveldb data";
+    if (top->size() == 4)
+      (*top)[3]->Reshape(this->layer_param_.batchsize() + 1, 1, 1, 1);
+  } else {
+    CHECK_LE(top->size(), 3) << "Query offsets need query_batching";
+  }
+  // The prefetch buffers share the shapes of the top blobs. A single batch
+  // is enough if it is only read once.
+  const int prefetch_count = this->layer_param_.batch_read() ?
+      this->layer_param_.prefetch_count() : 1;
+  CHECK_GT(prefetch_count, 0);
+  // With zero_copy one batch is always held by the top blobs.
+  if (this->layer_param_.zero_copy() && this->layer_param_.batch_read())
+    CHECK_GE(prefetch_count, 2) << "zero_copy needs prefetch_count >= 2";
+  prefetch_.resize(prefetch_count);
+  for (int i = 0; i < prefetch_count; ++i) {
+    prefetch_[i].reset(new DataBatch<Dtype>());
+    if (sparse_dim_) {
+      prefetch_[i]->data_.reset(new Blob<Dtype>());
+      prefetch_[i]->data_->ReshapeSparse((*top)[0]->num(), sparse_dim_, 0);
+    } else {
+      prefetch_[i]->data_.reset(new Blob<Dtype>((*top)[0]->num(),
+          (*top)[0]->channels(), (*top)[0]->height(), (*top)[0]->width()));
+    }
+    prefetch_[i]->label_.reset(
+        new Blob<Dtype>(this->layer_param_.batchsize(), label_dim, 1, 1));
+    if(top->size() >= 3)
+      prefetch_[i]->qid_.reset(
+          new Blob<Dtype>(this->layer_param_.batchsize(), 1, 1, 1));
+    if(top->size() == 4)
+      prefetch_[i]->query_offsets_.reset(
+          new Blob<Dtype>(this->layer_param_.batchsize() + 1, 1, 1, 1));
   }
   // datum size
-  datum_channels_ = datum.channels();
-  datum_height_ = datum.height();
-  datum_width_ = datum.width();
-  datum_size_ = datum.channels() * datum.height() * datum.width();
+  datum_size_ = datum_channels_ * datum_height_ * datum_width_;
   CHECK_GE(datum_height_, cropsize);
   CHECK_GE(datum_width_, cropsize);
   // check if we want to have mean
@@ -257,23 +1610,80 @@ void DataLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
     CHECK_EQ(data_mean_.channels(), datum_channels_);
     CHECK_EQ(data_mean_.height(), datum_height_);
     CHECK_EQ(data_mean_.width(), datum_width_);
+  } else if (sparse_dim_) {
+    // Sparse data is never mean subtracted.
+    data_mean_.Reshape(1, 1, 1, 1);
   } else {
     // Simply initialize an all-empty mean.
     data_mean_.Reshape(1, datum_channels_, datum_height_, datum_width_);
   }
+  // The per-feature scale and offset of quantized features
+  if (this->layer_param_.has_quantization_file()) {
+    CHECK(!sparse_dim_) << "Quantization is not supported for sparse data";
+    BlobProto blob_proto;
+    LOG(INFO) << "Loading quantization file from "
+        << this->layer_param_.quantization_file();
+    ReadProtoFromBinaryFile(this->layer_param_.quantization_file().c_str(),
+        &blob_proto);
+    data_quant_.FromProto(blob_proto);
+    CHECK_EQ(data_quant_.num(), 2);
+    CHECK_EQ(data_quant_.channels(), datum_channels_);
+    CHECK_EQ(data_quant_.height(), datum_height_);
+    CHECK_EQ(data_quant_.width(), datum_width_);
+  } else if (sparse_dim_) {
+    data_quant_.Reshape(1, 1, 1, 1);
+  } else {
+    // Stored features are taken as they are.
+    data_quant_.Reshape(2, datum_channels_, datum_height_, datum_width_);
+    Dtype* quant_scale = data_quant_.mutable_cpu_data();
+    for (int j = 0; j < datum_size_; ++j) {
+      quant_scale[j] = 1;
+    }
+  }
   // Now, start the prefetch thread. Before calling prefetch, we make two
   // cpu_data calls so that the prefetch thread does not accidentally make
   // simultaneous cudaMalloc calls when the main thread is running. In some
   // GPUs this seems to cause failures if we do not so.
-  prefetch_data_->mutable_cpu_data();
-  prefetch_label_->mutable_cpu_data();
-  if(top->size() == 3)
-		prefetch_qid_->mutable_cpu_data();
+  prefetch_free_.reset(new BlockingQueue<DataBatch<Dtype>*>());
+  prefetch_full_.reset(new BlockingQueue<DataBatch<Dtype>*>());
+  for (int i = 0; i < prefetch_.size(); ++i) {
+    if (sparse_dim_)
+      prefetch_[i]->data_->mutable_cpu_sparse_ptr();
+    else
+      prefetch_[i]->data_->mutable_cpu_data();
+    prefetch_[i]->label_->mutable_cpu_data();
+    if(top->size() >= 3)
+      prefetch_[i]->qid_->mutable_cpu_data();
+    if(top->size() == 4)
+      prefetch_[i]->query_offsets_->mutable_cpu_data();
+    prefetch_free_->push(prefetch_[i].get());
+  }
   data_mean_.cpu_data();
+  data_quant_.cpu_data();
+  batch_in_use_ = NULL;
+  CHECK_GT(this->layer_param_.decode_threads(), 0);
+  decode_workers_.reset(new DecodeWorkers(this->layer_param_.decode_threads()));
+  decode_datum_.resize(this->layer_param_.decode_threads());
+  if (in_memory_) {
+    SetUpMemory();
+  }
+  if (this->layer_param_.shuffle()) {
+    // The records of a dense or in-memory dataset, the blocks of a leveldb
+    shuffle_order_.resize(memory_num_ ? memory_num_ :
+        dense_header_ != NULL ? dense_header_->num : dbKeys.size());
+    for (int i = 0; i < shuffle_order_.size(); ++i) {
+      shuffle_order_[i] = i;
+    }
+    ShuffleOrder(&shuffle_order_, rng);
+    shuffle_pos_ = 0;
+    shuffle_window_.clear();
+    shuffle_window_pos_ = 0;
+  }
+  // Decoding the source into memory does not count.
+  counters_->Reset();
   DLOG(INFO) << "Initializing prefetch";
   //CHECK(!pthread_create(&thread_, NULL, DataLayerPrefetch<Dtype>,
   //    reinterpret_cast<void*>(this))) << "Pthread execution failed.";
-  updateRandIdx();
   thread_ = thread(DataLayerPrefetch<Dtype>,reinterpret_cast<void*>(this));
   DLOG(INFO) << "Prefetch initialized.";
 }
@@ -281,52 +1691,142 @@ void DataLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
 template <typename Dtype>
 void DataLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       vector<Blob<Dtype>*>* top) {
-  // First, join the thread
-  //CHECK(!pthread_join(thread_, NULL)) << "Pthread joining failed.";
-  if(thread_.joinable())
-  {
-	 thread_.join();
+  // Without batch_read the top blobs keep holding the first batch.
+  if (!this->layer_param_.batch_read() && batch_served_)
+    return;
+  if (!shards_.empty()) {
+    shards_[NextShard()]->Forward(bottom, top);
+    batch_served_ = true;
+    return;
+  }
+  if (this->layer_param_.zero_copy()) {
+    // The top blobs are done with the batch they shared last time.
+    if (batch_in_use_ != NULL)
+      prefetch_free_->push(batch_in_use_);
+    const data_clock::time_point start = data_clock::now();
+    batch_in_use_ = prefetch_full_->pop();
+    counters_->Add(DataLayerCounters::WAIT_NS, NanosSince(start));
+    (*top)[0]->ShareData(*batch_in_use_->data_);
+    (*top)[1]->ShareData(*batch_in_use_->label_);
+    if(top->size() >= 3)
+      (*top)[2]->ShareData(*batch_in_use_->qid_);
+    if(top->size() == 4)
+      (*top)[3]->ShareData(*batch_in_use_->query_offsets_);
+    batch_served_ = true;
+    return;
+  }
+  // Wait for the prefetch thread to fill a batch
+  data_clock::time_point start = data_clock::now();
+  DataBatch<Dtype>* batch = prefetch_full_->pop();
+  counters_->Add(DataLayerCounters::WAIT_NS, NanosSince(start));
   // Copy the data
-	  memcpy((*top)[0]->mutable_cpu_data(), prefetch_data_->cpu_data(),
-		  sizeof(Dtype) * prefetch_data_->count());
-	  memcpy((*top)[1]->mutable_cpu_data(), prefetch_label_->cpu_data(),
-		  sizeof(Dtype) * prefetch_label_->count());
-	  if(top->size() == 3)
-			memcpy((*top)[2]->mutable_cpu_data(), prefetch_qid_->cpu_data(),
-				sizeof(Dtype) * prefetch_qid_->count());
-  }
-  // Start a new prefetch thread
-  //CHECK(!pthread_create(&thread_, NULL, DataLayerPrefetch<Dtype>,
-  //    reinterpret_cast<void*>(this))) << "Pthread execution failed.";
-  //DataLayerPrefetch<Dtype>(reinterpret_cast<void*>(this));
-  updateRandIdx();
-  if(this->layer_param_.batch_read())
-		thread_ = thread(DataLayerPrefetch<Dtype>,reinterpret_cast<void*>(this));
+  start = data_clock::now();
+  const Blob<Dtype>& data = *batch->data_;
+  if (data.sparse()) {
+    (*top)[0]->ReshapeSparse(data.num(), data.channels(), data.nnz());
+    memcpy((*top)[0]->mutable_cpu_sparse_ptr(), data.cpu_sparse_ptr(),
+        sizeof(int) * (data.num() + 1));
+    memcpy((*top)[0]->mutable_cpu_sparse_indices(), data.cpu_sparse_indices(),
+        sizeof(int) * data.nnz());
+    memcpy((*top)[0]->mutable_cpu_sparse_values(), data.cpu_sparse_values(),
+        sizeof(Dtype) * data.nnz());
+  } else {
+    memcpy((*top)[0]->mutable_cpu_data(), data.cpu_data(),
+        sizeof(Dtype) * data.count());
+  }
+  memcpy((*top)[1]->mutable_cpu_data(), batch->label_->cpu_data(),
+      sizeof(Dtype) * batch->label_->count());
+  if(top->size() >= 3)
+    memcpy((*top)[2]->mutable_cpu_data(), batch->qid_->cpu_data(),
+        sizeof(Dtype) * batch->qid_->count());
+  if(top->size() == 4)
+    memcpy((*top)[3]->mutable_cpu_data(), batch->query_offsets_->cpu_data(),
+        sizeof(Dtype) * batch->query_offsets_->count());
+  counters_->Add(DataLayerCounters::COPY_NS, NanosSince(start));
+  // Hand the buffer back so the prefetch thread can refill it
+  prefetch_free_->push(batch);
+  batch_served_ = true;
 }
 
 template <typename Dtype>
 void DataLayer<Dtype>::Forward_gpu(const vector<Blob<Dtype>*>& bottom,
       vector<Blob<Dtype>*>* top) {
-  // First, join the thread
-  //CHECK(!pthread_join(thread_, NULL)) << "Pthread joining failed.";
-  thread_.join();
+  if (!this->layer_param_.batch_read() && batch_served_)
+    return;
+  if (!shards_.empty()) {
+    shards_[NextShard()]->Forward(bottom, top);
+    batch_served_ = true;
+    return;
+  }
+  // Sparse blobs only live on the host.
+  if (this->layer_param_.zero_copy() || sparse_dim_) {
+    // SyncedMemory uploads the shared buffers when they are first used.
+    Forward_cpu(bottom, top);
+    return;
+  }
+  data_clock::time_point start = data_clock::now();
+  DataBatch<Dtype>* batch = prefetch_full_->pop();
+  counters_->Add(DataLayerCounters::WAIT_NS, NanosSince(start));
   // Copy the data
+  start = data_clock::now();
   CUDA_CHECK(cudaMemcpy((*top)[0]->mutable_gpu_data(),
-      prefetch_data_->cpu_data(), sizeof(Dtype) * prefetch_data_->count(),
+      batch->data_->cpu_data(), sizeof(Dtype) * batch->data_->count(),
       cudaMemcpyHostToDevice));
   CUDA_CHECK(cudaMemcpy((*top)[1]->mutable_gpu_data(),
-      prefetch_label_->cpu_data(), sizeof(Dtype) * prefetch_label_->count(),
+      batch->label_->cpu_data(), sizeof(Dtype) * batch->label_->count(),
       cudaMemcpyHostToDevice));
-  if(top->size() == 3)
+  if(top->size() >= 3)
 	  CUDA_CHECK(cudaMemcpy((*top)[2]->mutable_gpu_data(),
-      prefetch_qid_->cpu_data(), sizeof(Dtype) * prefetch_qid_->count(),
+      batch->qid_->cpu_data(), sizeof(Dtype) * batch->qid_->count(),
       cudaMemcpyHostToDevice));
-  // Start a new prefetch thread
-  //CHECK(!pthread_create(&thread_, NULL, DataLayerPrefetch<Dtype>,
-  //    reinterpret_cast<void*>(this))) << "Pthread execution failed.";
-  //DataLayerPrefetch<Dtype>(reinterpret_cast<void*>(this));
-  updateRandIdx();
-  thread_ = thread(DataLayerPrefetch<Dtype>,reinterpret_cast<void*>(this));
+  if(top->size() == 4)
+    CUDA_CHECK(cudaMemcpy((*top)[3]->mutable_gpu_data(),
+        batch->query_offsets_->cpu_data(),
+        sizeof(Dtype) * batch->query_offsets_->count(),
+        cudaMemcpyHostToDevice));
+  counters_->Add(DataLayerCounters::COPY_NS, NanosSince(start));
+  prefetch_free_->push(batch);
+  batch_served_ = true;
+}
+
+// Returns what the layer, or all of its shards, did since the last reset.
+template <typename Dtype>
+DataLayerStats DataLayer<Dtype>::stats() const {
+  DataLayerStats stats;
+  memset(&stats, 0, sizeof(stats));
+  stats.elapsed_seconds = counters_->ElapsedSeconds();
+  if (!shards_.empty()) {
+    for (int i = 0; i < shards_.size(); ++i) {
+      const DataLayerStats shard = shards_[i]->stats();
+      stats.wait_seconds += shard.wait_seconds;
+      stats.read_seconds += shard.read_seconds;
+      stats.parse_seconds += shard.parse_seconds;
+      stats.normalize_seconds += shard.normalize_seconds;
+      stats.copy_seconds += shard.copy_seconds;
+      stats.batches += shard.batches;
+      stats.records += shard.records;
+      stats.bytes += shard.bytes;
+    }
+    return stats;
+  }
+  stats.wait_seconds = counters_->Seconds(DataLayerCounters::WAIT_NS);
+  stats.read_seconds = counters_->Seconds(DataLayerCounters::READ_NS);
+  stats.parse_seconds = counters_->Seconds(DataLayerCounters::PARSE_NS);
+  stats.normalize_seconds =
+      counters_->Seconds(DataLayerCounters::NORMALIZE_NS);
+  stats.copy_seconds = counters_->Seconds(DataLayerCounters::COPY_NS);
+  stats.batches = counters_->Get(DataLayerCounters::BATCHES);
+  stats.records = counters_->Get(DataLayerCounters::RECORDS);
+  stats.bytes = counters_->Get(DataLayerCounters::BYTES);
+  return stats;
+}
+
+template <typename Dtype>
+void DataLayer<Dtype>::ResetStats() {
+  counters_->Reset();
+  for (int i = 0; i < shards_.size(); ++i) {
+    shards_[i]->ResetStats();
+  }
 }
 
 // The backward operations are dummy - they do not carry any computation.
@@ -26,6 +26,12 @@ void InnerProductLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
   M_ = bottom[0]->num();
   K_ = bottom[0]->count() / bottom[0]->num();
   N_ = num_output;
+  if (bottom[0]->sparse()) {
+    CHECK(!this->layer_param_.cal_2nd_grad())
+        << "cal_2nd_grad is not supported for sparse inputs";
+    column_seen_.assign(K_, false);
+    seen_columns_.clear();
+  }
   (*top)[0]->Reshape(bottom[0]->num(), num_output, 1, 1);
   // Check if we need to set up the weights
   if (this->blobs_.size() > 0) {
@@ -66,9 +72,84 @@ void InnerProductLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
   }
 };
 
+// top = bottom * weight' for a CSR bottom: each output only reads the weight
+// columns of the nonzeros of its row.
+template <typename Dtype>
+void InnerProductLayer<Dtype>::SparseForward_cpu(const Blob<Dtype>& bottom,
+    Dtype* top_data) {
+  const Dtype* values = bottom.cpu_sparse_values();
+  const int* indices = bottom.cpu_sparse_indices();
+  const int* ptr = bottom.cpu_sparse_ptr();
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  for (int i = 0; i < M_; ++i) {
+    for (int n = 0; n < N_; ++n) {
+      const Dtype* weight_row = weight + n * K_;
+      Dtype sum = 0;
+      for (int p = ptr[i]; p < ptr[i + 1]; ++p) {
+        sum += values[p] * weight_row[indices[p]];
+      }
+      top_data[i * N_ + n] = sum;
+    }
+  }
+}
+
+// weight_diff = top_diff' * bottom / M for a CSR bottom. Only the columns of
+// the nonzeros in this batch are written, and they are recorded as the diff
+// columns of the weight so that the solver can leave the others alone. If
+// the solver has turned the diff dense since the last batch, it is cleared
+// as a whole.
+template <typename Dtype>
+void InnerProductLayer<Dtype>::SparseBackward_cpu(const Blob<Dtype>& bottom,
+    const Dtype* top_diff) {
+  const Dtype* values = bottom.cpu_sparse_values();
+  const int* indices = bottom.cpu_sparse_indices();
+  const int* ptr = bottom.cpu_sparse_ptr();
+  Blob<Dtype>* weight = this->blobs_[0].get();
+  Dtype* weight_diff = weight->mutable_cpu_diff();
+  if (weight->diff_columns() != NULL) {
+    for (int j = 0; j < seen_columns_.size(); ++j) {
+      for (int n = 0; n < N_; ++n) {
+        weight_diff[n * K_ + seen_columns_[j]] = 0;
+      }
+    }
+  } else {
+    memset(weight_diff, 0, sizeof(Dtype) * weight->count());
+  }
+  seen_columns_.clear();
+  for (int p = 0; p < bottom.nnz(); ++p) {
+    if (!column_seen_[indices[p]]) {
+      column_seen_[indices[p]] = true;
+      seen_columns_.push_back(indices[p]);
+    }
+  }
+  for (int j = 0; j < seen_columns_.size(); ++j) {
+    column_seen_[seen_columns_[j]] = false;
+  }
+  for (int i = 0; i < M_; ++i) {
+    for (int p = ptr[i]; p < ptr[i + 1]; ++p) {
+      const Dtype value = values[p] / M_;
+      Dtype* diff_column = weight_diff + indices[p];
+      for (int n = 0; n < N_; ++n) {
+        diff_column[n * K_] += top_diff[i * N_ + n] * value;
+      }
+    }
+  }
+  weight->set_diff_columns(seen_columns_);
+}
+
 template <typename Dtype>
 void InnerProductLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     vector<Blob<Dtype>*>* top) {
+  if (bottom[0]->sparse()) {
+    Dtype* top_data = (*top)[0]->mutable_cpu_data();
+    SparseForward_cpu(*bottom[0], top_data);
+    if (biasterm_) {
+      caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, M_, N_, 1, (Dtype)1.,
+          reinterpret_cast<const Dtype*>(bias_multiplier_->cpu_data()),
+          this->blobs_[1]->cpu_data(), (Dtype)1., top_data);
+    }
+    return;
+  }
   const Dtype* bottom_data = bottom[0]->cpu_data();
   Dtype* top_data = (*top)[0]->mutable_cpu_data();
   const Dtype* weight = this->blobs_[0]->cpu_data();
@@ -87,6 +168,16 @@ Dtype InnerProductLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
     const bool propagate_down,
     vector<Blob<Dtype>*>* bottom) {
   const Dtype* top_diff = top[0]->cpu_diff();
+  if ((*bottom)[0]->sparse()) {
+    // Sparse inputs come straight from the data, so there is no bottom diff.
+    SparseBackward_cpu(*(*bottom)[0], top_diff);
+    if (biasterm_) {
+      caffe_cpu_gemv<Dtype>(CblasTrans, M_, N_, (Dtype)1./M_, top_diff,
+          reinterpret_cast<const Dtype*>(bias_multiplier_->cpu_data()),
+          (Dtype)0., this->blobs_[1]->mutable_cpu_diff());
+    }
+    return Dtype(0);
+  }
   const Dtype* top_2nd_diff = this->layer_param_.cal_2nd_grad() ? top[0]->cpu_2nd_diff() : NULL;
   const Dtype* bottom_data = (*bottom)[0]->cpu_data();
   // Gradient with respect to weight
@@ -142,6 +233,7 @@ Dtype InnerProductLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
 template <typename Dtype>
 void InnerProductLayer<Dtype>::Forward_gpu(const vector<Blob<Dtype>*>& bottom,
     vector<Blob<Dtype>*>* top) {
+  CHECK(!bottom[0]->sparse()) << "Sparse inputs are only supported on the CPU";
   const Dtype* bottom_data = bottom[0]->gpu_data();
   Dtype* top_data = (*top)[0]->mutable_gpu_data();
   const Dtype* weight = this->blobs_[0]->gpu_data();
@@ -158,6 +250,7 @@ template <typename Dtype>
 Dtype InnerProductLayer<Dtype>::Backward_gpu(const vector<Blob<Dtype>*>& top,
     const bool propagate_down,
     vector<Blob<Dtype>*>* bottom) {
+  CHECK(!(*bottom)[0]->sparse()) << "Sparse inputs are only supported on the CPU";
   const Dtype* top_diff = top[0]->gpu_diff();
   const Dtype* bottom_data = (*bottom)[0]->gpu_data();
   // Gradient with respect to weight
@@ -8,6 +8,7 @@
 #include "caffe/layer.hpp"
 #include "caffe/vision_layers.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/query_ranges.hpp"
 #include "l2r/util.h"
 
 #define MAX_EXP_POWER 45
@@ -22,7 +23,8 @@ namespace caffe {
 	void LambdaRankLossLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
       vector<Blob<Dtype>*>* top)
 	{
-		CHECK_EQ(bottom.size(), 3) << "Listnet loss Layer takes three blobs as input.";
+		CHECK_GE(bottom.size(), 3) << "Listnet loss Layer takes three blobs as input.";
+		CHECK_LE(bottom.size(), 4) << "The fourth input can only be the query offsets.";
 	    CHECK_EQ(top->size(), 0) << "Listnet loss Layer takes no blobs as output.";
 		delta = this->layer_param_.delta();
 		topK = this->layer_param_.top_k();
@@ -37,32 +39,24 @@ namespace caffe {
 		const Dtype* label = (*bottom)[1]->cpu_data();
 		const Dtype* scores = (*bottom)[0]->cpu_data();
 		const Dtype* qid = (*bottom)[2]->cpu_data();
-		vector<int> qNum;
-		int curGroupId = qid[0];
-		int startIdx = 0;
 		int dataNum =  (*bottom)[0]->num();
-		for(int i = 0; i < dataNum; i++)
-		{
-			if(qid[i] != curGroupId)
-			{
-				qNum.push_back(i - startIdx);
-				startIdx = i;
-				curGroupId = qid[i];
-			}
-		}
-		qNum.push_back(dataNum - startIdx);
+		vector<int> qStart, qNum;
+		if(bottom->size() == 4)
+			QueryRangesFromOffsets(*(*bottom)[3], &qStart, &qNum);
+		else
+			QueryRangesFromQid(qid, dataNum, this->layer_param_.query_padding(),
+					&qStart, &qNum);
 		Dtype loss = 0;
 		//int dim = *max_element(qNum.begin(), qNum.end());
 		//Dtype* changes = new Dtype[dim*dim];
 	
-		startIdx = 0;
-
 		memset(f_diff, 0, sizeof(Dtype) * dataNum);
 		if(f_2nd_diff)
 			memset(f_2nd_diff, 0, sizeof(Dtype) * dataNum);
 
 		for(int q = 0; q < qNum.size(); q++)
 		{
+			int startIdx = qStart[q];
 			int num = qNum[q];
 			int k = (topK == 0) ? num : topK;
 			//ndcgSwapChg(scores+startIdx, label+startIdx, changes, num, k, dim);
@@ -125,7 +119,6 @@ namespace caffe {
 				}
 				//f_diff[startIdx+i] = lambda;
 			}
-			startIdx += qNum[q];
 		}
 		/*for(int i = 0; i < dataNum; i++)
 		{
@@ -134,7 +127,8 @@ namespace caffe {
 		}*/
 		//caffe_scal((*bottom)[0]->count(), (Dtype)1./dataNum, f_diff);
 		//delete[] changes;
-		loss /= qNum.size();
+		if(qNum.size())
+			loss /= qNum.size();
 		return loss ;
 	}
 
@@ -7,6 +7,7 @@
 #include "caffe/layer.hpp"
 #include "caffe/vision_layers.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/query_ranges.hpp"
 #include "l2r/util.h"
 
 using std::max;
@@ -17,7 +18,8 @@ namespace caffe {
 	void NdcgLayer<Dtype>::SetUp(const vector<Blob<Dtype>*>& bottom,
       vector<Blob<Dtype>*>* top)
 	{
-	  CHECK_EQ(bottom.size(), 3) << "NDCG Layer takes three blobs as input.";
+	  CHECK_GE(bottom.size(), 3) << "NDCG Layer takes three blobs as input.";
+	  CHECK_LE(bottom.size(), 4) << "The fourth input can only be the query offsets.";
 	  CHECK_EQ(top->size(), 1) << "NDCG Layer takes 1 output.";
 	  CHECK_EQ(bottom[0]->num(), bottom[1]->num())
 		  << "The data and label should have the same number.";
@@ -34,29 +36,18 @@ namespace caffe {
 		const Dtype* label = bottom[1]->cpu_data();
 		const Dtype* scores = bottom[0]->cpu_data();
 		const Dtype* qid = bottom[2]->cpu_data();
-		vector<int> qNum;
-		int curGroupId = qid[0];
-		int startIdx = 0;
-		for(int i = 0; i < bottom[2]->num(); i++)
-		{
-			if(qid[i] != curGroupId)
-			{
-				qNum.push_back(i - startIdx);
-				startIdx = i;
-				curGroupId = qid[i];
-			}
-		}
-		qNum.push_back(bottom[2]->num() - startIdx);
+		vector<int> qStart, qNum;
+		if(bottom.size() == 4)
+			QueryRangesFromOffsets(*bottom[3], &qStart, &qNum);
+		else
+			QueryRangesFromQid(qid, bottom[2]->num(),
+					this->layer_param_.query_padding(), &qStart, &qNum);
 		Dtype sumNdcg = 0;
-		startIdx = 0;
 
 		for(int q = 0; q < qNum.size(); q++)
-		{
-			sumNdcg += calNdcg(scores+startIdx, label+startIdx, qNum[q], topK);
-			startIdx += qNum[q];
-		}
+			sumNdcg += calNdcg(scores+qStart[q], label+qStart[q], qNum[q], topK);
 
-		(*top)[0]->mutable_cpu_data()[0] = sumNdcg / qNum.size();
+		(*top)[0]->mutable_cpu_data()[0] = qNum.size() ? sumNdcg / qNum.size() : 0;
 	}
 
 	INSTANTIATE_CLASS(NdcgLayer);
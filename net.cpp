@@ -237,42 +237,55 @@ Dtype Net<Dtype>::Backward() {
   return loss;
 }
 
+// Copies the blobs of a trained layer into the layer of the same name, if
+// the net has one.
+template <typename Dtype>
+static void CopyTrainedLayer(Net<Dtype>* net,
+    const LayerParameter& source_layer) {
+  const vector<string>& layer_names = net->layer_names();
+  const string& source_layer_name = source_layer.name();
+  int target_layer_id = 0;
+  while (target_layer_id != layer_names.size() &&
+      layer_names[target_layer_id] != source_layer_name) {
+    ++target_layer_id;
+  }
+  if (target_layer_id == layer_names.size()) {
+    DLOG(INFO) << "Ignoring source layer " << source_layer_name;
+    return;
+  }
+  DLOG(INFO) << "Copying source layer " << source_layer_name;
+  const shared_ptr<Layer<Dtype> >& target_layer =
+      net->layers()[target_layer_id];
+  target_layer->CopyFrom(source_layer);
+  vector<shared_ptr<Blob<Dtype> > >& target_blobs = target_layer->blobs();
+  CHECK_EQ(target_blobs.size(), source_layer.blobs_size())
+      << "Incompatible number of blobs for layer " << source_layer_name;
+  for (int j = 0; j < target_blobs.size(); ++j) {
+    CHECK_EQ(target_blobs[j]->num(), source_layer.blobs(j).num());
+    CHECK_EQ(target_blobs[j]->channels(), source_layer.blobs(j).channels());
+    CHECK_EQ(target_blobs[j]->height(), source_layer.blobs(j).height());
+    CHECK_EQ(target_blobs[j]->width(), source_layer.blobs(j).width());
+    target_blobs[j]->FromProto(source_layer.blobs(j));
+  }
+}
+
 template <typename Dtype>
 void Net<Dtype>::CopyTrainedLayersFrom(const NetParameter& param) {
   int num_source_layers = param.layers_size();
   for (int i = 0; i < num_source_layers; ++i) {
-    const LayerParameter& source_layer = param.layers(i).layer();
-    const string& source_layer_name = source_layer.name();
-    int target_layer_id = 0;
-    while (target_layer_id != layer_names_.size() &&
-        layer_names_[target_layer_id] != source_layer_name) {
-      ++target_layer_id;
-    }
-    if (target_layer_id == layer_names_.size()) {
-      DLOG(INFO) << "Ignoring source layer " << source_layer_name;
-      continue;
-    }
-    DLOG(INFO) << "Copying source layer " << source_layer_name;
-	layers_[target_layer_id]->CopyFrom(source_layer);
-    vector<shared_ptr<Blob<Dtype> > >& target_blobs =
-        layers_[target_layer_id]->blobs();
-    CHECK_EQ(target_blobs.size(), source_layer.blobs_size())
-        << "Incompatible number of blobs for layer " << source_layer_name;
-    for (int j = 0; j < target_blobs.size(); ++j) {
-      CHECK_EQ(target_blobs[j]->num(), source_layer.blobs(j).num());
-      CHECK_EQ(target_blobs[j]->channels(), source_layer.blobs(j).channels());
-      CHECK_EQ(target_blobs[j]->height(), source_layer.blobs(j).height());
-      CHECK_EQ(target_blobs[j]->width(), source_layer.blobs(j).width());
-      target_blobs[j]->FromProto(source_layer.blobs(j));
-    }
+    CopyTrainedLayer(this, param.layers(i).layer());
   }
 }
 
 template <typename Dtype>
 void Net<Dtype>::CopyTrainedLayersFrom(const string trained_filename) {
-  NetParameter param;
-  ReadProtoFromBinaryFile(trained_filename, &param);
-  CopyTrainedLayersFrom(param);
+  // Parse the layers one at a time into the same message rather than the
+  // whole net at once: the model is never held twice, and the layers reuse
+  // the memory of the blobs of the ones before them.
+  LayerConnection layer_connection;
+  ReadRepeatedProtoFromBinaryFile(trained_filename.c_str(),
+      NetParameter::kLayersFieldNumber, &layer_connection,
+      [&]() { CopyTrainedLayer(this, layer_connection.layer()); });
 }
 
 template <typename Dtype>
@@ -26,6 +26,9 @@ const ::google::protobuf::internal::GeneratedMessageReflection*
 const ::google::protobuf::Descriptor* BlobProtoVector_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   BlobProtoVector_reflection_ = NULL;
+const ::google::protobuf::Descriptor* KeyIndex_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  KeyIndex_reflection_ = NULL;
 const ::google::protobuf::Descriptor* Datum_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   Datum_reflection_ = NULL;
@@ -45,6 +48,8 @@ const ::google::protobuf::Descriptor* LayerParameter_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   LayerParameter_reflection_ = NULL;
 const ::google::protobuf::EnumDescriptor* LayerParameter_PoolMethod_descriptor_ = NULL;
+const ::google::protobuf::EnumDescriptor* LayerParameter_DataSource_descriptor_ = NULL;
+const ::google::protobuf::EnumDescriptor* LayerParameter_ShardOrder_descriptor_ = NULL;
 const ::google::protobuf::Descriptor* LayerConnection_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   LayerConnection_reflection_ = NULL;
@@ -103,8 +108,25 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(BlobProtoVector));
-  Datum_descriptor_ = file->message_type(2);
-  static const int Datum_offsets_[8] = {
+  KeyIndex_descriptor_ = file->message_type(2);
+  static const int KeyIndex_offsets_[3] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(KeyIndex, stride_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(KeyIndex, num_records_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(KeyIndex, keys_),
+  };
+  KeyIndex_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      KeyIndex_descriptor_,
+      KeyIndex::default_instance_,
+      KeyIndex_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(KeyIndex, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(KeyIndex, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(KeyIndex));
+  Datum_descriptor_ = file->message_type(3);
+  static const int Datum_offsets_[12] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, channels_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, height_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, width_),
@@ -113,6 +135,10 @@ void protobuf_AssignDesc_caffe_2eproto() {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, float_data_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, float_label_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, group_id_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, sparse_index_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, sparse_value_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, sparse_dim_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Datum, half_data_),
   };
   Datum_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -125,7 +151,7 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(Datum));
-  FillerParameter_descriptor_ = file->message_type(3);
+  FillerParameter_descriptor_ = file->message_type(4);
   static const int FillerParameter_offsets_[6] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(FillerParameter, type_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(FillerParameter, value_),
@@ -145,7 +171,7 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(FillerParameter));
-  TreeNodeProto_descriptor_ = file->message_type(4);
+  TreeNodeProto_descriptor_ = file->message_type(5);
   static const int TreeNodeProto_offsets_[9] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TreeNodeProto, feature_split_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TreeNodeProto, value_split_),
@@ -168,7 +194,7 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(TreeNodeProto));
-  TreeProto_descriptor_ = file->message_type(5);
+  TreeProto_descriptor_ = file->message_type(6);
   static const int TreeProto_offsets_[1] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TreeProto, tree_nodes_),
   };
@@ -183,7 +209,7 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(TreeProto));
-  ForestProto_descriptor_ = file->message_type(6);
+  ForestProto_descriptor_ = file->message_type(7);
   static const int ForestProto_offsets_[10] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ForestProto, init_pred_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ForestProto, dim_),
@@ -207,8 +233,8 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(ForestProto));
-  LayerParameter_descriptor_ = file->message_type(7);
-  static const int LayerParameter_offsets_[43] = {
+  LayerParameter_descriptor_ = file->message_type(8);
+  static const int LayerParameter_offsets_[59] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, name_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, type_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, num_output_),
@@ -247,6 +273,22 @@ void protobuf_AssignDesc_caffe_2eproto() {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, max_leaf_num_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, lazy_pred_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, cal_2nd_grad_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, prefetch_count_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, zero_copy_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, decode_threads_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, source_type_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, query_batching_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, jump_index_stride_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, jump_index_file_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, shuffle_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, shuffle_window_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, quantization_file_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, in_memory_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, shard_order_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, streaming_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, stream_chunk_kb_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, in_memory_if_supported_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, query_padding_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, blobs_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, blobs_lr_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerParameter, weight_decay_),
@@ -265,7 +307,9 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(LayerParameter));
   LayerParameter_PoolMethod_descriptor_ = LayerParameter_descriptor_->enum_type(0);
-  LayerConnection_descriptor_ = file->message_type(8);
+  LayerParameter_DataSource_descriptor_ = LayerParameter_descriptor_->enum_type(1);
+  LayerParameter_ShardOrder_descriptor_ = LayerParameter_descriptor_->enum_type(2);
+  LayerConnection_descriptor_ = file->message_type(9);
   static const int LayerConnection_offsets_[3] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerConnection, layer_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(LayerConnection, bottom_),
@@ -282,7 +326,7 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(LayerConnection));
-  NetParameter_descriptor_ = file->message_type(9);
+  NetParameter_descriptor_ = file->message_type(10);
   static const int NetParameter_offsets_[5] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(NetParameter, name_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(NetParameter, layers_),
@@ -301,8 +345,8 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(NetParameter));
-  SolverParameter_descriptor_ = file->message_type(10);
-  static const int SolverParameter_offsets_[19] = {
+  SolverParameter_descriptor_ = file->message_type(11);
+  static const int SolverParameter_offsets_[20] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverParameter, train_net_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverParameter, test_net_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverParameter, test_iter_),
@@ -322,6 +366,7 @@ void protobuf_AssignDesc_caffe_2eproto() {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverParameter, solver_mode_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverParameter, device_id_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverParameter, cal_2nd_grad_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverParameter, test_data_in_memory_),
   };
   SolverParameter_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -334,7 +379,7 @@ void protobuf_AssignDesc_caffe_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(SolverParameter));
-  SolverState_descriptor_ = file->message_type(11);
+  SolverState_descriptor_ = file->message_type(12);
   static const int SolverState_offsets_[3] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverState, iter_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SolverState, learned_net_),
@@ -367,6 +412,8 @@ void protobuf_RegisterTypes(const ::std::string&) {
     BlobProto_descriptor_, &BlobProto::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
     BlobProtoVector_descriptor_, &BlobProtoVector::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    KeyIndex_descriptor_, &KeyIndex::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
     Datum_descriptor_, &Datum::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
@@ -396,6 +443,8 @@ void protobuf_ShutdownFile_caffe_2eproto() {
   delete BlobProto_reflection_;
   delete BlobProtoVector::default_instance_;
   delete BlobProtoVector_reflection_;
+  delete KeyIndex::default_instance_;
+  delete KeyIndex_reflection_;
   delete Datum::default_instance_;
   delete Datum_reflection_;
   delete FillerParameter::default_instance_;
@@ -431,75 +480,96 @@ void protobuf_AddDesc_caffe_2eproto() {
     "t\030\003 \001(\005:\0010\022\020\n\005width\030\004 \001(\005:\0010\022\020\n\004data\030\005 \003"
     "(\002B\002\020\001\022\020\n\004diff\030\006 \003(\002B\002\020\001\022\027\n\013second_diff\030"
     "\007 \003(\002B\002\020\001\"2\n\017BlobProtoVector\022\037\n\005blobs\030\001 "
-    "\003(\0132\020.caffe.BlobProto\"\220\001\n\005Datum\022\020\n\010chann"
-    "els\030\001 \001(\005\022\016\n\006height\030\002 \001(\005\022\r\n\005width\030\003 \001(\005"
-    "\022\014\n\004data\030\004 \001(\014\022\r\n\005label\030\005 \001(\005\022\022\n\nfloat_d"
-    "ata\030\006 \003(\002\022\023\n\013float_label\030\007 \003(\002\022\020\n\010group_"
-    "id\030\010 \001(\005\"|\n\017FillerParameter\022\026\n\004type\030\001 \001("
-    "\t:\010constant\022\020\n\005value\030\002 \001(\002:\0010\022\016\n\003min\030\003 \001"
-    "(\002:\0010\022\016\n\003max\030\004 \001(\002:\0011\022\017\n\004mean\030\005 \001(\002:\0010\022\016"
-    "\n\003std\030\006 \001(\002:\0011\"\271\001\n\rTreeNodeProto\022\025\n\rfeat"
-    "ure_split\030\001 \002(\r\022\023\n\013value_split\030\002 \002(\002\022\014\n\004"
-    "leaf\030\003 \002(\010\022\020\n\010nSamples\030\004 \002(\r\022\022\n\nleft_chi"
-    "ld\030\005 \002(\r\022\023\n\013right_child\030\006 \002(\r\022\021\n\tini_err"
-    "or\030\007 \002(\002\022\022\n\nbest_error\030\010 \002(\002\022\014\n\004pred\030\t \001"
-    "(\002\"5\n\tTreeProto\022(\n\ntree_nodes\030\001 \003(\0132\024.ca"
-    "ffe.TreeNodeProto\"\331\001\n\013ForestProto\022\021\n\tini"
-    "t_pred\030\001 \002(\002\022\013\n\003dim\030\002 \002(\r\022\025\n\rlearning_ra"
-    "te\030\003 \002(\002\022\021\n\tmax_depth\030\004 \002(\r\022\022\n\nmin_leaf_"
-    "n\030\005 \002(\r\022\037\n\005trees\030\006 \003(\0132\020.caffe.TreeProto"
-    "\022\021\n\trand_feat\030\007 \002(\002\022\021\n\trand_samp\030\010 \002(\002\022\017"
-    "\n\007min_obs\030\t \002(\002\022\024\n\014max_leaf_num\030\n \002(\r\"\272\010"
-    "\n\016LayerParameter\022\014\n\004name\030\001 \001(\t\022\014\n\004type\030\002"
-    " \001(\t\022\022\n\nnum_output\030\003 \001(\r\022\026\n\010biasterm\030\004 \001"
-    "(\010:\004true\022-\n\rweight_filler\030\005 \001(\0132\026.caffe."
-    "FillerParameter\022+\n\013bias_filler\030\006 \001(\0132\026.c"
-    "affe.FillerParameter\022\016\n\003pad\030\007 \001(\r:\0010\022\022\n\n"
-    "kernelsize\030\010 \001(\r\022\020\n\005group\030\t \001(\r:\0011\022\021\n\006st"
-    "ride\030\n \001(\r:\0011\0223\n\004pool\030\013 \001(\0162 .caffe.Laye"
-    "rParameter.PoolMethod:\003MAX\022\032\n\rdropout_ra"
-    "tio\030\014 \001(\002:\0030.5\022\025\n\nlocal_size\030\r \001(\r:\0015\022\020\n"
-    "\005alpha\030\016 \001(\002:\0011\022\022\n\004beta\030\017 \001(\002:\0040.75\022\016\n\006s"
-    "ource\030\020 \001(\t\022\020\n\005scale\030\021 \001(\002:\0011\022\020\n\010meanfil"
-    "e\030\022 \001(\t\022\021\n\tbatchsize\030\023 \001(\r\022\023\n\010cropsize\030\024"
-    " \001(\r:\0010\022\025\n\006mirror\030\025 \001(\010:\005false\022\024\n\tmax_de"
-    "pth\030\026 \001(\r:\0015\022\026\n\tforest_lr\030\027 \001(\002:\0030.1\022\025\n\n"
-    "forest_std\030\030 \001(\002:\0011\022\025\n\nmin_leaf_n\030\031 \001(\r:"
-    "\0011\022\020\n\005power\030\032 \001(\r:\0011\022\026\n\013jitter_rate\030\033 \001("
-    "\002:\0010\022\031\n\013random_jump\030\034 \001(\010:\004true\022\020\n\005delta"
-    "\030\035 \001(\002:\0011\022\020\n\005top_k\030\036 \001(\r:\0010\022\024\n\tn_threads"
-    "\030\037 \001(\r:\0011\022\030\n\nbatch_read\030  \001(\010:\004true\022\024\n\tr"
-    "and_feat\030! \001(\002:\0011\022\024\n\trand_samp\030\" \001(\002:\0011\022"
-    "\022\n\007min_obs\030# \001(\002:\0010\022\032\n\014max_leaf_num\030$ \001("
-    "\r:\0049999\022\030\n\tlazy_pred\030% \001(\010:\005false\022\033\n\014cal"
-    "_2nd_grad\030& \001(\010:\005false\022\037\n\005blobs\0302 \003(\0132\020."
-    "caffe.BlobProto\022\020\n\010blobs_lr\0303 \003(\002\022\024\n\014wei"
-    "ght_decay\0304 \003(\002\022\024\n\trand_skip\0305 \001(\r:\0010\022#\n"
-    "\007forests\0306 \003(\0132\022.caffe.ForestProto\".\n\nPo"
-    "olMethod\022\007\n\003MAX\020\000\022\007\n\003AVE\020\001\022\016\n\nSTOCHASTIC"
-    "\020\002\"T\n\017LayerConnection\022$\n\005layer\030\001 \001(\0132\025.c"
-    "affe.LayerParameter\022\016\n\006bottom\030\002 \003(\t\022\013\n\003t"
-    "op\030\003 \003(\t\"\205\001\n\014NetParameter\022\014\n\004name\030\001 \001(\t\022"
-    "&\n\006layers\030\002 \003(\0132\026.caffe.LayerConnection\022"
-    "\r\n\005input\030\003 \003(\t\022\021\n\tinput_dim\030\004 \003(\005\022\035\n\016for"
-    "ce_backward\030\005 \001(\010:\005false\"\234\003\n\017SolverParam"
-    "eter\022\021\n\ttrain_net\030\001 \001(\t\022\020\n\010test_net\030\002 \001("
-    "\t\022\024\n\ttest_iter\030\003 \001(\005:\0010\022\030\n\rtest_interval"
-    "\030\004 \001(\005:\0010\022\017\n\007base_lr\030\005 \001(\002\022\017\n\007display\030\006 "
-    "\001(\005\022\020\n\010max_iter\030\007 \001(\005\022\021\n\tlr_policy\030\010 \001(\t"
-    "\022\r\n\005gamma\030\t \001(\002\022\r\n\005power\030\n \001(\002\022\020\n\010moment"
-    "um\030\013 \001(\002\022\024\n\014weight_decay\030\014 \001(\002\022\020\n\010stepsi"
-    "ze\030\r \001(\005\022\023\n\010snapshot\030\016 \001(\005:\0010\022\027\n\017snapsho"
-    "t_prefix\030\017 \001(\t\022\034\n\rsnapshot_diff\030\020 \001(\010:\005f"
-    "alse\022\026\n\013solver_mode\030\021 \001(\005:\0011\022\024\n\tdevice_i"
-    "d\030\022 \001(\005:\0010\022\033\n\014cal_2nd_grad\030\023 \001(\010:\005false\""
-    "S\n\013SolverState\022\014\n\004iter\030\001 \001(\005\022\023\n\013learned_"
-    "net\030\002 \001(\t\022!\n\007history\030\003 \003(\0132\020.caffe.BlobP"
-    "roto", 2764);
+    "\003(\0132\020.caffe.BlobProto\"=\n\010KeyIndex\022\016\n\006str"
+    "ide\030\001 \001(\r\022\023\n\013num_records\030\002 \001(\004\022\014\n\004keys\030\003"
+    " \003(\014\"\366\001\n\005Datum\022\020\n\010channels\030\001 \001(\005\022\016\n\006heig"
+    "ht\030\002 \001(\005\022\r\n\005width\030\003 \001(\005\022\014\n\004data\030\004 \001(\014\022\r\n"
+    "\005label\030\005 \001(\005\022\026\n\nfloat_data\030\006 \003(\002B\002\020\001\022\027\n\013"
+    "float_label\030\007 \003(\002B\002\020\001\022\020\n\010group_id\030\010 \001(\005\022"
+    "\030\n\014sparse_index\030\t \003(\005B\002\020\001\022\030\n\014sparse_valu"
+    "e\030\n \003(\002B\002\020\001\022\025\n\nsparse_dim\030\013 \001(\005:\0010\022\021\n\tha"
+    "lf_data\030\014 \001(\014\"|\n\017FillerParameter\022\026\n\004type"
+    "\030\001 \001(\t:\010constant\022\020\n\005value\030\002 \001(\002:\0010\022\016\n\003mi"
+    "n\030\003 \001(\002:\0010\022\016\n\003max\030\004 \001(\002:\0011\022\017\n\004mean\030\005 \001(\002"
+    ":\0010\022\016\n\003std\030\006 \001(\002:\0011\"\271\001\n\rTreeNodeProto\022\025\n"
+    "\rfeature_split\030\001 \002(\r\022\023\n\013value_split\030\002 \002("
+    "\002\022\014\n\004leaf\030\003 \002(\010\022\020\n\010nSamples\030\004 \002(\r\022\022\n\nlef"
+    "t_child\030\005 \002(\r\022\023\n\013right_child\030\006 \002(\r\022\021\n\tin"
+    "i_error\030\007 \002(\002\022\022\n\nbest_error\030\010 \002(\002\022\014\n\004pre"
+    "d\030\t \001(\002\"5\n\tTreeProto\022(\n\ntree_nodes\030\001 \003(\013"
+    "2\024.caffe.TreeNodeProto\"\331\001\n\013ForestProto\022\021"
+    "\n\tinit_pred\030\001 \002(\002\022\013\n\003dim\030\002 \002(\r\022\025\n\rlearni"
+    "ng_rate\030\003 \002(\002\022\021\n\tmax_depth\030\004 \002(\r\022\022\n\nmin_"
+    "leaf_n\030\005 \002(\r\022\037\n\005trees\030\006 \003(\0132\020.caffe.Tree"
+    "Proto\022\021\n\trand_feat\030\007 \002(\002\022\021\n\trand_samp\030\010 "
+    "\002(\002\022\017\n\007min_obs\030\t \002(\002\022\024\n\014max_leaf_num\030\n \002"
+    "(\r\"\240\r\n\016LayerParameter\022\014\n\004name\030\001 \001(\t\022\014\n\004t"
+    "ype\030\002 \001(\t\022\022\n\nnum_output\030\003 \001(\r\022\026\n\010biaster"
+    "m\030\004 \001(\010:\004true\022-\n\rweight_filler\030\005 \001(\0132\026.c"
+    "affe.FillerParameter\022+\n\013bias_filler\030\006 \001("
+    "\0132\026.caffe.FillerParameter\022\016\n\003pad\030\007 \001(\r:\001"
+    "0\022\022\n\nkernelsize\030\010 \001(\r\022\020\n\005group\030\t \001(\r:\0011\022"
+    "\021\n\006stride\030\n \001(\r:\0011\0223\n\004pool\030\013 \001(\0162 .caffe"
+    ".LayerParameter.PoolMethod:\003MAX\022\032\n\rdropo"
+    "ut_ratio\030\014 \001(\002:\0030.5\022\025\n\nlocal_size\030\r \001(\r:"
+    "\0015\022\020\n\005alpha\030\016 \001(\002:\0011\022\022\n\004beta\030\017 \001(\002:\0040.75"
+    "\022\016\n\006source\030\020 \001(\t\022\020\n\005scale\030\021 \001(\002:\0011\022\020\n\010me"
+    "anfile\030\022 \001(\t\022\021\n\tbatchsize\030\023 \001(\r\022\023\n\010crops"
+    "ize\030\024 \001(\r:\0010\022\025\n\006mirror\030\025 \001(\010:\005false\022\024\n\tm"
+    "ax_depth\030\026 \001(\r:\0015\022\026\n\tforest_lr\030\027 \001(\002:\0030."
+    "1\022\025\n\nforest_std\030\030 \001(\002:\0011\022\025\n\nmin_leaf_n\030\031"
+    " \001(\r:\0011\022\020\n\005power\030\032 \001(\r:\0011\022\026\n\013jitter_rate"
+    "\030\033 \001(\002:\0010\022\031\n\013random_jump\030\034 \001(\010:\004true\022\020\n\005"
+    "delta\030\035 \001(\002:\0011\022\020\n\005top_k\030\036 \001(\r:\0010\022\024\n\tn_th"
+    "reads\030\037 \001(\r:\0011\022\030\n\nbatch_read\030  \001(\010:\004true"
+    "\022\024\n\trand_feat\030! \001(\002:\0011\022\024\n\trand_samp\030\" \001("
+    "\002:\0011\022\022\n\007min_obs\030# \001(\002:\0010\022\032\n\014max_leaf_num"
+    "\030$ \001(\r:\0049999\022\030\n\tlazy_pred\030% \001(\010:\005false\022\033"
+    "\n\014cal_2nd_grad\030& \001(\010:\005false\022\031\n\016prefetch_"
+    "count\030\' \001(\r:\0013\022\030\n\tzero_copy\030( \001(\010:\005false"
+    "\022\031\n\016decode_threads\030) \001(\r:\0011\022>\n\013source_ty"
+    "pe\030* \001(\0162 .caffe.LayerParameter.DataSour"
+    "ce:\007LEVELDB\022\035\n\016query_batching\030+ \001(\010:\005fal"
+    "se\022\036\n\021jump_index_stride\030, \001(\r:\003256\022\027\n\017ju"
+    "mp_index_file\030- \001(\t\022\026\n\007shuffle\030. \001(\010:\005fa"
+    "lse\022\032\n\016shuffle_window\030/ \001(\r:\00216\022\031\n\021quant"
+    "ization_file\0300 \001(\t\022\030\n\tin_memory\0301 \001(\010:\005f"
+    "alse\022B\n\013shard_order\0307 \001(\0162 .caffe.LayerP"
+    "arameter.ShardOrder:\013ROUND_ROBIN\022\030\n\tstre"
+    "aming\0308 \001(\010:\005false\022\036\n\017stream_chunk_kb\0309 "
+    "\001(\r:\00565536\022%\n\026in_memory_if_supported\030: \001"
+    "(\010:\005false\022\034\n\rquery_padding\030; \001(\010:\005false\022"
+    "\037\n\005blobs\0302 \003(\0132\020.caffe.BlobProto\022\020\n\010blob"
+    "s_lr\0303 \003(\002\022\024\n\014weight_decay\0304 \003(\002\022\024\n\trand"
+    "_skip\0305 \001(\r:\0010\022#\n\007forests\0306 \003(\0132\022.caffe."
+    "ForestProto\".\n\nPoolMethod\022\007\n\003MAX\020\000\022\007\n\003AV"
+    "E\020\001\022\016\n\nSTOCHASTIC\020\002\"$\n\nDataSource\022\013\n\007LEV"
+    "ELDB\020\000\022\t\n\005DENSE\020\001\"*\n\nShardOrder\022\017\n\013ROUND"
+    "_ROBIN\020\000\022\013\n\007BY_SIZE\020\001\"T\n\017LayerConnection"
+    "\022$\n\005layer\030\001 \001(\0132\025.caffe.LayerParameter\022\016"
+    "\n\006bottom\030\002 \003(\t\022\013\n\003top\030\003 \003(\t\"\205\001\n\014NetParam"
+    "eter\022\014\n\004name\030\001 \001(\t\022&\n\006layers\030\002 \003(\0132\026.caf"
+    "fe.LayerConnection\022\r\n\005input\030\003 \003(\t\022\021\n\tinp"
+    "ut_dim\030\004 \003(\005\022\035\n\016force_backward\030\005 \001(\010:\005fa"
+    "lse\"\300\003\n\017SolverParameter\022\021\n\ttrain_net\030\001 \001"
+    "(\t\022\020\n\010test_net\030\002 \001(\t\022\024\n\ttest_iter\030\003 \001(\005:"
+    "\0010\022\030\n\rtest_interval\030\004 \001(\005:\0010\022\017\n\007base_lr\030"
+    "\005 \001(\002\022\017\n\007display\030\006 \001(\005\022\020\n\010max_iter\030\007 \001(\005"
+    "\022\021\n\tlr_policy\030\010 \001(\t\022\r\n\005gamma\030\t \001(\002\022\r\n\005po"
+    "wer\030\n \001(\002\022\020\n\010momentum\030\013 \001(\002\022\024\n\014weight_de"
+    "cay\030\014 \001(\002\022\020\n\010stepsize\030\r \001(\005\022\023\n\010snapshot\030"
+    "\016 \001(\005:\0010\022\027\n\017snapshot_prefix\030\017 \001(\t\022\034\n\rsna"
+    "pshot_diff\030\020 \001(\010:\005false\022\026\n\013solver_mode\030\021"
+    " \001(\005:\0011\022\024\n\tdevice_id\030\022 \001(\005:\0010\022\033\n\014cal_2nd"
+    "_grad\030\023 \001(\010:\005false\022\"\n\023test_data_in_memor"
+    "y\030\024 \001(\010:\005false\"S\n\013SolverState\022\014\n\004iter\030\001 "
+    "\001(\005\022\023\n\013learned_net\030\002 \001(\t\022!\n\007history\030\003 \003("
+    "\0132\020.caffe.BlobProto", 3579);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "caffe.proto", &protobuf_RegisterTypes);
   BlobProto::default_instance_ = new BlobProto();
   BlobProtoVector::default_instance_ = new BlobProtoVector();
+  KeyIndex::default_instance_ = new KeyIndex();
   Datum::default_instance_ = new Datum();
   FillerParameter::_default_type_ =
       new ::std::string("constant", 8);
@@ -514,6 +584,7 @@ void protobuf_AddDesc_caffe_2eproto() {
   SolverState::default_instance_ = new SolverState();
   BlobProto::default_instance_->InitAsDefaultInstance();
   BlobProtoVector::default_instance_->InitAsDefaultInstance();
+  KeyIndex::default_instance_->InitAsDefaultInstance();
   Datum::default_instance_->InitAsDefaultInstance();
   FillerParameter::default_instance_->InitAsDefaultInstance();
   TreeNodeProto::default_instance_->InitAsDefaultInstance();
@@ -1254,6 +1325,292 @@ void BlobProtoVector::Swap(BlobProtoVector* other) {
 }
 
 
+// ===================================================================
+
+#ifndef _MSC_VER
+const int KeyIndex::kStrideFieldNumber;
+const int KeyIndex::kNumRecordsFieldNumber;
+const int KeyIndex::kKeysFieldNumber;
+#endif  // !_MSC_VER
+
+KeyIndex::KeyIndex()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+}
+
+void KeyIndex::InitAsDefaultInstance() {
+}
+
+KeyIndex::KeyIndex(const KeyIndex& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+}
+
+void KeyIndex::SharedCtor() {
+  _cached_size_ = 0;
+  stride_ = 0u;
+  num_records_ = GOOGLE_ULONGLONG(0);
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+KeyIndex::~KeyIndex() {
+  SharedDtor();
+}
+
+void KeyIndex::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void KeyIndex::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* KeyIndex::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return KeyIndex_descriptor_;
+}
+
+const KeyIndex& KeyIndex::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_caffe_2eproto();
+  return *default_instance_;
+}
+
+KeyIndex* KeyIndex::default_instance_ = NULL;
+
+KeyIndex* KeyIndex::New() const {
+  return new KeyIndex;
+}
+
+void KeyIndex::Clear() {
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    stride_ = 0u;
+    num_records_ = GOOGLE_ULONGLONG(0);
+  }
+  keys_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool KeyIndex::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) return false
+  ::google::protobuf::uint32 tag;
+  while ((tag = input->ReadTag()) != 0) {
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // optional uint32 stride = 1;
+      case 1: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &stride_)));
+          set_has_stride();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(16)) goto parse_num_records;
+        break;
+      }
+
+      // optional uint64 num_records = 2;
+      case 2: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_num_records:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &num_records_)));
+          set_has_num_records();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(26)) goto parse_keys;
+        break;
+      }
+
+      // repeated bytes keys = 3;
+      case 3: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_keys:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadBytes(
+                input, this->add_keys()));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(26)) goto parse_keys;
+        if (input->ExpectAtEnd()) return true;
+        break;
+      }
+
+      default: {
+      handle_uninterpreted:
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          return true;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+  return true;
+#undef DO_
+}
+
+void KeyIndex::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // optional uint32 stride = 1;
+  if (has_stride()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(1, this->stride(), output);
+  }
+
+  // optional uint64 num_records = 2;
+  if (has_num_records()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(2, this->num_records(), output);
+  }
+
+  // repeated bytes keys = 3;
+  for (int i = 0; i < this->keys_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteBytes(
+      3, this->keys(i), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+}
+
+::google::protobuf::uint8* KeyIndex::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // optional uint32 stride = 1;
+  if (has_stride()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(1, this->stride(), target);
+  }
+
+  // optional uint64 num_records = 2;
+  if (has_num_records()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(2, this->num_records(), target);
+  }
+
+  // repeated bytes keys = 3;
+  for (int i = 0; i < this->keys_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteBytesToArray(3, this->keys(i), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  return target;
+}
+
+int KeyIndex::ByteSize() const {
+  int total_size = 0;
+
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // optional uint32 stride = 1;
+    if (has_stride()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->stride());
+    }
+
+    // optional uint64 num_records = 2;
+    if (has_num_records()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->num_records());
+    }
+
+  }
+  // repeated bytes keys = 3;
+  total_size += 1 * this->keys_size();
+  for (int i = 0; i < this->keys_size(); i++) {
+    total_size += ::google::protobuf::internal::WireFormatLite::BytesSize(
+      this->keys(i));
+  }
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void KeyIndex::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const KeyIndex* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const KeyIndex*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void KeyIndex::MergeFrom(const KeyIndex& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  keys_.MergeFrom(from.keys_);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_stride()) {
+      set_stride(from.stride());
+    }
+    if (from.has_num_records()) {
+      set_num_records(from.num_records());
+    }
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void KeyIndex::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void KeyIndex::CopyFrom(const KeyIndex& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool KeyIndex::IsInitialized() const {
+
+  return true;
+}
+
+void KeyIndex::Swap(KeyIndex* other) {
+  if (other != this) {
+    std::swap(stride_, other->stride_);
+    std::swap(num_records_, other->num_records_);
+    keys_.Swap(&other->keys_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata KeyIndex::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = KeyIndex_descriptor_;
+  metadata.reflection = KeyIndex_reflection_;
+  return metadata;
+}
+
+
 // ===================================================================
 
 #ifndef _MSC_VER
@@ -1265,6 +1622,10 @@ const int Datum::kLabelFieldNumber;
 const int Datum::kFloatDataFieldNumber;
 const int Datum::kFloatLabelFieldNumber;
 const int Datum::kGroupIdFieldNumber;
+const int Datum::kSparseIndexFieldNumber;
+const int Datum::kSparseValueFieldNumber;
+const int Datum::kSparseDimFieldNumber;
+const int Datum::kHalfDataFieldNumber;
 #endif  // !_MSC_VER
 
 Datum::Datum()
@@ -1289,6 +1650,8 @@ void Datum::SharedCtor() {
   data_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
   label_ = 0;
   group_id_ = 0;
+  sparse_dim_ = 0;
+  half_data_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -1300,6 +1663,9 @@ void Datum::SharedDtor() {
   if (data_ != &::google::protobuf::internal::kEmptyString) {
     delete data_;
   }
+  if (half_data_ != &::google::protobuf::internal::kEmptyString) {
+    delete half_data_;
+  }
   if (this != default_instance_) {
   }
 }
@@ -1338,8 +1704,18 @@ void Datum::Clear() {
     label_ = 0;
     group_id_ = 0;
   }
+  if (_has_bits_[10 / 32] & (0xffu << (10 % 32))) {
+    sparse_dim_ = 0;
+    if (has_half_data()) {
+      if (half_data_ != &::google::protobuf::internal::kEmptyString) {
+        half_data_->clear();
+      }
+    }
+  }
   float_data_.Clear();
   float_label_.Clear();
+  sparse_index_.Clear();
+  sparse_value_.Clear();
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
 }
@@ -1423,50 +1799,48 @@ bool Datum::MergePartialFromCodedStream(
         } else {
           goto handle_uninterpreted;
         }
-        if (input->ExpectTag(53)) goto parse_float_data;
+        if (input->ExpectTag(50)) goto parse_float_data;
         break;
       }
 
-      // repeated float float_data = 6;
+      // repeated float float_data = 6 [packed = true];
       case 6: {
         if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
-            ::google::protobuf::internal::WireFormatLite::WIRETYPE_FIXED32) {
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
          parse_float_data:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitive<
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
                    float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
-                 1, 53, input, this->mutable_float_data())));
+                 input, this->mutable_float_data())));
         } else if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag)
                    == ::google::protobuf::internal::WireFormatLite::
-                      WIRETYPE_LENGTH_DELIMITED) {
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitiveNoInline<
+                      WIRETYPE_FIXED32) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
                    float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
-                 input, this->mutable_float_data())));
+                 1, 50, input, this->mutable_float_data())));
         } else {
           goto handle_uninterpreted;
         }
-        if (input->ExpectTag(53)) goto parse_float_data;
-        if (input->ExpectTag(61)) goto parse_float_label;
+        if (input->ExpectTag(58)) goto parse_float_label;
         break;
       }
 
-      // repeated float float_label = 7;
+      // repeated float float_label = 7 [packed = true];
       case 7: {
         if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
-            ::google::protobuf::internal::WireFormatLite::WIRETYPE_FIXED32) {
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
          parse_float_label:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitive<
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
                    float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
-                 1, 61, input, this->mutable_float_label())));
+                 input, this->mutable_float_label())));
         } else if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag)
                    == ::google::protobuf::internal::WireFormatLite::
-                      WIRETYPE_LENGTH_DELIMITED) {
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitiveNoInline<
+                      WIRETYPE_FIXED32) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
                    float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
-                 input, this->mutable_float_label())));
+                 1, 58, input, this->mutable_float_label())));
         } else {
           goto handle_uninterpreted;
         }
-        if (input->ExpectTag(61)) goto parse_float_label;
         if (input->ExpectTag(64)) goto parse_group_id;
         break;
       }
@@ -1483,6 +1857,78 @@ bool Datum::MergePartialFromCodedStream(
         } else {
           goto handle_uninterpreted;
         }
+        if (input->ExpectTag(74)) goto parse_sparse_index;
+        break;
+      }
+
+      // repeated int32 sparse_index = 9 [packed = true];
+      case 9: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_sparse_index:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, this->mutable_sparse_index())));
+        } else if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag)
+                   == ::google::protobuf::internal::WireFormatLite::
+                      WIRETYPE_VARINT) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 1, 74, input, this->mutable_sparse_index())));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(82)) goto parse_sparse_value;
+        break;
+      }
+
+      // repeated float sparse_value = 10 [packed = true];
+      case 10: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_sparse_value:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
+                   float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
+                 input, this->mutable_sparse_value())));
+        } else if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag)
+                   == ::google::protobuf::internal::WireFormatLite::
+                      WIRETYPE_FIXED32) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
+                   float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
+                 1, 82, input, this->mutable_sparse_value())));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(88)) goto parse_sparse_dim;
+        break;
+      }
+
+      // optional int32 sparse_dim = 11 [default = 0];
+      case 11: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_sparse_dim:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &sparse_dim_)));
+          set_has_sparse_dim();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(98)) goto parse_half_data;
+        break;
+      }
+
+      // optional bytes half_data = 12;
+      case 12: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_half_data:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadBytes(
+                input, this->mutable_half_data()));
+        } else {
+          goto handle_uninterpreted;
+        }
         if (input->ExpectAtEnd()) return true;
         break;
       }
@@ -1531,21 +1977,60 @@ void Datum::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteInt32(5, this->label(), output);
   }
 
-  // repeated float float_data = 6;
+  // repeated float float_data = 6 [packed = true];
+  if (this->float_data_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(6, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_float_data_cached_byte_size_);
+  }
   for (int i = 0; i < this->float_data_size(); i++) {
-    ::google::protobuf::internal::WireFormatLite::WriteFloat(
-      6, this->float_data(i), output);
+    ::google::protobuf::internal::WireFormatLite::WriteFloatNoTag(
+      this->float_data(i), output);
+  }
+
+  // repeated float float_label = 7 [packed = true];
+  if (this->float_label_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(7, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_float_label_cached_byte_size_);
+  }
+  for (int i = 0; i < this->float_label_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteFloatNoTag(
+      this->float_label(i), output);
+  }
+
+  // optional int32 group_id = 8;
+  if (has_group_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(8, this->group_id(), output);
+  }
+
+  // repeated int32 sparse_index = 9 [packed = true];
+  if (this->sparse_index_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(9, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_sparse_index_cached_byte_size_);
+  }
+  for (int i = 0; i < this->sparse_index_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32NoTag(
+      this->sparse_index(i), output);
+  }
+
+  // repeated float sparse_value = 10 [packed = true];
+  if (this->sparse_value_size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteTag(10, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+    output->WriteVarint32(_sparse_value_cached_byte_size_);
+  }
+  for (int i = 0; i < this->sparse_value_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteFloatNoTag(
+      this->sparse_value(i), output);
   }
 
-  // repeated float float_label = 7;
-  for (int i = 0; i < this->float_label_size(); i++) {
-    ::google::protobuf::internal::WireFormatLite::WriteFloat(
-      7, this->float_label(i), output);
+  // optional int32 sparse_dim = 11 [default = 0];
+  if (has_sparse_dim()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(11, this->sparse_dim(), output);
   }
 
-  // optional int32 group_id = 8;
-  if (has_group_id()) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(8, this->group_id(), output);
+  // optional bytes half_data = 12;
+  if (has_half_data()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBytes(
+      12, this->half_data(), output);
   }
 
   if (!unknown_fields().empty()) {
@@ -1583,16 +2068,32 @@ void Datum::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(5, this->label(), target);
   }
 
-  // repeated float float_data = 6;
+  // repeated float float_data = 6 [packed = true];
+  if (this->float_data_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      6,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _float_data_cached_byte_size_, target);
+  }
   for (int i = 0; i < this->float_data_size(); i++) {
     target = ::google::protobuf::internal::WireFormatLite::
-      WriteFloatToArray(6, this->float_data(i), target);
+      WriteFloatNoTagToArray(this->float_data(i), target);
   }
 
-  // repeated float float_label = 7;
+  // repeated float float_label = 7 [packed = true];
+  if (this->float_label_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      7,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _float_label_cached_byte_size_, target);
+  }
   for (int i = 0; i < this->float_label_size(); i++) {
     target = ::google::protobuf::internal::WireFormatLite::
-      WriteFloatToArray(7, this->float_label(i), target);
+      WriteFloatNoTagToArray(this->float_label(i), target);
   }
 
   // optional int32 group_id = 8;
@@ -1600,6 +2101,46 @@ void Datum::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(8, this->group_id(), target);
   }
 
+  // repeated int32 sparse_index = 9 [packed = true];
+  if (this->sparse_index_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      9,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _sparse_index_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->sparse_index_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteInt32NoTagToArray(this->sparse_index(i), target);
+  }
+
+  // repeated float sparse_value = 10 [packed = true];
+  if (this->sparse_value_size() > 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
+      10,
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+      target);
+    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      _sparse_value_cached_byte_size_, target);
+  }
+  for (int i = 0; i < this->sparse_value_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteFloatNoTagToArray(this->sparse_value(i), target);
+  }
+
+  // optional int32 sparse_dim = 11 [default = 0];
+  if (has_sparse_dim()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(11, this->sparse_dim(), target);
+  }
+
+  // optional bytes half_data = 12;
+  if (has_half_data()) {
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteBytesToArray(
+        12, this->half_data(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -1654,18 +2195,79 @@ int Datum::ByteSize() const {
     }
 
   }
-  // repeated float float_data = 6;
+  if (_has_bits_[10 / 32] & (0xffu << (10 % 32))) {
+    // optional int32 sparse_dim = 11 [default = 0];
+    if (has_sparse_dim()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(
+          this->sparse_dim());
+    }
+
+    // optional bytes half_data = 12;
+    if (has_half_data()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::BytesSize(
+          this->half_data());
+    }
+
+  }
+  // repeated float float_data = 6 [packed = true];
   {
     int data_size = 0;
     data_size = 4 * this->float_data_size();
-    total_size += 1 * this->float_data_size() + data_size;
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _float_data_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
   }
 
-  // repeated float float_label = 7;
+  // repeated float float_label = 7 [packed = true];
   {
     int data_size = 0;
     data_size = 4 * this->float_label_size();
-    total_size += 1 * this->float_label_size() + data_size;
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _float_label_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated int32 sparse_index = 9 [packed = true];
+  {
+    int data_size = 0;
+    for (int i = 0; i < this->sparse_index_size(); i++) {
+      data_size += ::google::protobuf::internal::WireFormatLite::
+        Int32Size(this->sparse_index(i));
+    }
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _sparse_index_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
+  }
+
+  // repeated float sparse_value = 10 [packed = true];
+  {
+    int data_size = 0;
+    data_size = 4 * this->sparse_value_size();
+    if (data_size > 0) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+    }
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    _sparse_value_cached_byte_size_ = data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    total_size += data_size;
   }
 
   if (!unknown_fields().empty()) {
@@ -1695,6 +2297,8 @@ void Datum::MergeFrom(const Datum& from) {
   GOOGLE_CHECK_NE(&from, this);
   float_data_.MergeFrom(from.float_data_);
   float_label_.MergeFrom(from.float_label_);
+  sparse_index_.MergeFrom(from.sparse_index_);
+  sparse_value_.MergeFrom(from.sparse_value_);
   if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
     if (from.has_channels()) {
       set_channels(from.channels());
@@ -1715,6 +2319,14 @@ void Datum::MergeFrom(const Datum& from) {
       set_group_id(from.group_id());
     }
   }
+  if (from._has_bits_[10 / 32] & (0xffu << (10 % 32))) {
+    if (from.has_sparse_dim()) {
+      set_sparse_dim(from.sparse_dim());
+    }
+    if (from.has_half_data()) {
+      set_half_data(from.half_data());
+    }
+  }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
 
@@ -1745,6 +2357,10 @@ void Datum::Swap(Datum* other) {
     float_data_.Swap(&other->float_data_);
     float_label_.Swap(&other->float_label_);
     std::swap(group_id_, other->group_id_);
+    sparse_index_.Swap(&other->sparse_index_);
+    sparse_value_.Swap(&other->sparse_value_);
+    std::swap(sparse_dim_, other->sparse_dim_);
+    std::swap(half_data_, other->half_data_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -3500,6 +4116,48 @@ const LayerParameter_PoolMethod LayerParameter::PoolMethod_MIN;
 const LayerParameter_PoolMethod LayerParameter::PoolMethod_MAX;
 const int LayerParameter::PoolMethod_ARRAYSIZE;
 #endif  // _MSC_VER
+const ::google::protobuf::EnumDescriptor* LayerParameter_DataSource_descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return LayerParameter_DataSource_descriptor_;
+}
+bool LayerParameter_DataSource_IsValid(int value) {
+  switch(value) {
+    case 0:
+    case 1:
+      return true;
+    default:
+      return false;
+  }
+}
+
+#ifndef _MSC_VER
+const LayerParameter_DataSource LayerParameter::LEVELDB;
+const LayerParameter_DataSource LayerParameter::DENSE;
+const LayerParameter_DataSource LayerParameter::DataSource_MIN;
+const LayerParameter_DataSource LayerParameter::DataSource_MAX;
+const int LayerParameter::DataSource_ARRAYSIZE;
+#endif  // _MSC_VER
+const ::google::protobuf::EnumDescriptor* LayerParameter_ShardOrder_descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return LayerParameter_ShardOrder_descriptor_;
+}
+bool LayerParameter_ShardOrder_IsValid(int value) {
+  switch(value) {
+    case 0:
+    case 1:
+      return true;
+    default:
+      return false;
+  }
+}
+
+#ifndef _MSC_VER
+const LayerParameter_ShardOrder LayerParameter::ROUND_ROBIN;
+const LayerParameter_ShardOrder LayerParameter::BY_SIZE;
+const LayerParameter_ShardOrder LayerParameter::ShardOrder_MIN;
+const LayerParameter_ShardOrder LayerParameter::ShardOrder_MAX;
+const int LayerParameter::ShardOrder_ARRAYSIZE;
+#endif  // _MSC_VER
 #ifndef _MSC_VER
 const int LayerParameter::kNameFieldNumber;
 const int LayerParameter::kTypeFieldNumber;
@@ -3539,6 +4197,22 @@ const int LayerParameter::kMinObsFieldNumber;
 const int LayerParameter::kMaxLeafNumFieldNumber;
 const int LayerParameter::kLazyPredFieldNumber;
 const int LayerParameter::kCal2NdGradFieldNumber;
+const int LayerParameter::kPrefetchCountFieldNumber;
+const int LayerParameter::kZeroCopyFieldNumber;
+const int LayerParameter::kDecodeThreadsFieldNumber;
+const int LayerParameter::kSourceTypeFieldNumber;
+const int LayerParameter::kQueryBatchingFieldNumber;
+const int LayerParameter::kJumpIndexStrideFieldNumber;
+const int LayerParameter::kJumpIndexFileFieldNumber;
+const int LayerParameter::kShuffleFieldNumber;
+const int LayerParameter::kShuffleWindowFieldNumber;
+const int LayerParameter::kQuantizationFileFieldNumber;
+const int LayerParameter::kInMemoryFieldNumber;
+const int LayerParameter::kShardOrderFieldNumber;
+const int LayerParameter::kStreamingFieldNumber;
+const int LayerParameter::kStreamChunkKbFieldNumber;
+const int LayerParameter::kInMemoryIfSupportedFieldNumber;
+const int LayerParameter::kQueryPaddingFieldNumber;
 const int LayerParameter::kBlobsFieldNumber;
 const int LayerParameter::kBlobsLrFieldNumber;
 const int LayerParameter::kWeightDecayFieldNumber;
@@ -3602,6 +4276,22 @@ void LayerParameter::SharedCtor() {
   max_leaf_num_ = 9999u;
   lazy_pred_ = false;
   cal_2nd_grad_ = false;
+  prefetch_count_ = 3u;
+  zero_copy_ = false;
+  decode_threads_ = 1u;
+  source_type_ = 0;
+  query_batching_ = false;
+  jump_index_stride_ = 256u;
+  jump_index_file_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+  shuffle_ = false;
+  shuffle_window_ = 16u;
+  quantization_file_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+  in_memory_ = false;
+  shard_order_ = 0;
+  streaming_ = false;
+  stream_chunk_kb_ = 65536u;
+  in_memory_if_supported_ = false;
+  query_padding_ = false;
   rand_skip_ = 0u;
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
@@ -3623,6 +4313,12 @@ void LayerParameter::SharedDtor() {
   if (meanfile_ != &::google::protobuf::internal::kEmptyString) {
     delete meanfile_;
   }
+  if (jump_index_file_ != &::google::protobuf::internal::kEmptyString) {
+    delete jump_index_file_;
+  }
+  if (quantization_file_ != &::google::protobuf::internal::kEmptyString) {
+    delete quantization_file_;
+  }
   if (this != default_instance_) {
     delete weight_filler_;
     delete bias_filler_;
@@ -3718,8 +4414,36 @@ void LayerParameter::Clear() {
     max_leaf_num_ = 9999u;
     lazy_pred_ = false;
     cal_2nd_grad_ = false;
+    prefetch_count_ = 3u;
+    zero_copy_ = false;
+  }
+  if (_has_bits_[40 / 32] & (0xffu << (40 % 32))) {
+    decode_threads_ = 1u;
+    source_type_ = 0;
+    query_batching_ = false;
+    jump_index_stride_ = 256u;
+    if (has_jump_index_file()) {
+      if (jump_index_file_ != &::google::protobuf::internal::kEmptyString) {
+        jump_index_file_->clear();
+      }
+    }
+    shuffle_ = false;
+    shuffle_window_ = 16u;
+    if (has_quantization_file()) {
+      if (quantization_file_ != &::google::protobuf::internal::kEmptyString) {
+        quantization_file_->clear();
+      }
+    }
+  }
+  if (_has_bits_[48 / 32] & (0xffu << (48 % 32))) {
+    in_memory_ = false;
+    shard_order_ = 0;
+    streaming_ = false;
+    stream_chunk_kb_ = 65536u;
+    in_memory_if_supported_ = false;
+    query_padding_ = false;
   }
-  if (_has_bits_[41 / 32] & (0xffu << (41 % 32))) {
+  if (_has_bits_[57 / 32] & (0xffu << (57 % 32))) {
     rand_skip_ = 0u;
   }
   blobs_.Clear();
@@ -4296,51 +5020,234 @@ bool LayerParameter::MergePartialFromCodedStream(
         } else {
           goto handle_uninterpreted;
         }
-        if (input->ExpectTag(288)) goto parse_max_leaf_num;
+        if (input->ExpectTag(288)) goto parse_max_leaf_num;
+        break;
+      }
+
+      // optional uint32 max_leaf_num = 36 [default = 9999];
+      case 36: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_max_leaf_num:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &max_leaf_num_)));
+          set_has_max_leaf_num();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(296)) goto parse_lazy_pred;
+        break;
+      }
+
+      // optional bool lazy_pred = 37 [default = false];
+      case 37: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_lazy_pred:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &lazy_pred_)));
+          set_has_lazy_pred();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(304)) goto parse_cal_2nd_grad;
+        break;
+      }
+
+      // optional bool cal_2nd_grad = 38 [default = false];
+      case 38: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_cal_2nd_grad:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &cal_2nd_grad_)));
+          set_has_cal_2nd_grad();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(312)) goto parse_prefetch_count;
+        break;
+      }
+
+      // optional uint32 prefetch_count = 39 [default = 3];
+      case 39: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_prefetch_count:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &prefetch_count_)));
+          set_has_prefetch_count();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(320)) goto parse_zero_copy;
+        break;
+      }
+
+      // optional bool zero_copy = 40 [default = false];
+      case 40: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_zero_copy:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &zero_copy_)));
+          set_has_zero_copy();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(328)) goto parse_decode_threads;
+        break;
+      }
+
+      // optional uint32 decode_threads = 41 [default = 1];
+      case 41: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_decode_threads:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &decode_threads_)));
+          set_has_decode_threads();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(336)) goto parse_source_type;
+        break;
+      }
+
+      // optional .caffe.LayerParameter.DataSource source_type = 42 [default = LEVELDB];
+      case 42: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_source_type:
+          int value;
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   int, ::google::protobuf::internal::WireFormatLite::TYPE_ENUM>(
+                 input, &value)));
+          if (::caffe::LayerParameter_DataSource_IsValid(value)) {
+            set_source_type(static_cast< ::caffe::LayerParameter_DataSource >(value));
+          } else {
+            mutable_unknown_fields()->AddVarint(42, value);
+          }
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(344)) goto parse_query_batching;
+        break;
+      }
+
+      // optional bool query_batching = 43 [default = false];
+      case 43: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_query_batching:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &query_batching_)));
+          set_has_query_batching();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(352)) goto parse_jump_index_stride;
+        break;
+      }
+
+      // optional uint32 jump_index_stride = 44 [default = 256];
+      case 44: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_jump_index_stride:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &jump_index_stride_)));
+          set_has_jump_index_stride();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(362)) goto parse_jump_index_file;
+        break;
+      }
+
+      // optional string jump_index_file = 45;
+      case 45: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_jump_index_file:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadString(
+                input, this->mutable_jump_index_file()));
+          ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+            this->jump_index_file().data(), this->jump_index_file().length(),
+            ::google::protobuf::internal::WireFormat::PARSE);
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(368)) goto parse_shuffle;
+        break;
+      }
+
+      // optional bool shuffle = 46 [default = false];
+      case 46: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_shuffle:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &shuffle_)));
+          set_has_shuffle();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(376)) goto parse_shuffle_window;
         break;
       }
 
-      // optional uint32 max_leaf_num = 36 [default = 9999];
-      case 36: {
+      // optional uint32 shuffle_window = 47 [default = 16];
+      case 47: {
         if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
             ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
-         parse_max_leaf_num:
+         parse_shuffle_window:
           DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
                    ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
-                 input, &max_leaf_num_)));
-          set_has_max_leaf_num();
+                 input, &shuffle_window_)));
+          set_has_shuffle_window();
         } else {
           goto handle_uninterpreted;
         }
-        if (input->ExpectTag(296)) goto parse_lazy_pred;
+        if (input->ExpectTag(386)) goto parse_quantization_file;
         break;
       }
 
-      // optional bool lazy_pred = 37 [default = false];
-      case 37: {
+      // optional string quantization_file = 48;
+      case 48: {
         if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
-            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
-         parse_lazy_pred:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
-                 input, &lazy_pred_)));
-          set_has_lazy_pred();
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_quantization_file:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadString(
+                input, this->mutable_quantization_file()));
+          ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+            this->quantization_file().data(), this->quantization_file().length(),
+            ::google::protobuf::internal::WireFormat::PARSE);
         } else {
           goto handle_uninterpreted;
         }
-        if (input->ExpectTag(304)) goto parse_cal_2nd_grad;
+        if (input->ExpectTag(392)) goto parse_in_memory;
         break;
       }
 
-      // optional bool cal_2nd_grad = 38 [default = false];
-      case 38: {
+      // optional bool in_memory = 49 [default = false];
+      case 49: {
         if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
             ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
-         parse_cal_2nd_grad:
+         parse_in_memory:
           DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
                    bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
-                 input, &cal_2nd_grad_)));
-          set_has_cal_2nd_grad();
+                 input, &in_memory_)));
+          set_has_in_memory();
         } else {
           goto handle_uninterpreted;
         }
@@ -4434,6 +5341,91 @@ bool LayerParameter::MergePartialFromCodedStream(
           goto handle_uninterpreted;
         }
         if (input->ExpectTag(434)) goto parse_forests;
+        if (input->ExpectTag(440)) goto parse_shard_order;
+        break;
+      }
+
+      // optional .caffe.LayerParameter.ShardOrder shard_order = 55 [default = ROUND_ROBIN];
+      case 55: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_shard_order:
+          int value;
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   int, ::google::protobuf::internal::WireFormatLite::TYPE_ENUM>(
+                 input, &value)));
+          if (::caffe::LayerParameter_ShardOrder_IsValid(value)) {
+            set_shard_order(static_cast< ::caffe::LayerParameter_ShardOrder >(value));
+          } else {
+            mutable_unknown_fields()->AddVarint(55, value);
+          }
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(448)) goto parse_streaming;
+        break;
+      }
+
+      // optional bool streaming = 56 [default = false];
+      case 56: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_streaming:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &streaming_)));
+          set_has_streaming();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(456)) goto parse_stream_chunk_kb;
+        break;
+      }
+
+      // optional uint32 stream_chunk_kb = 57 [default = 65536];
+      case 57: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_stream_chunk_kb:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &stream_chunk_kb_)));
+          set_has_stream_chunk_kb();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(464)) goto parse_in_memory_if_supported;
+        break;
+      }
+
+      // optional bool in_memory_if_supported = 58 [default = false];
+      case 58: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_in_memory_if_supported:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &in_memory_if_supported_)));
+          set_has_in_memory_if_supported();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(472)) goto parse_query_padding;
+        break;
+      }
+
+      // optional bool query_padding = 59 [default = false];
+      case 59: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_query_padding:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &query_padding_)));
+          set_has_query_padding();
+        } else {
+          goto handle_uninterpreted;
+        }
         if (input->ExpectAtEnd()) return true;
         break;
       }
@@ -4665,6 +5657,70 @@ void LayerParameter::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteBool(38, this->cal_2nd_grad(), output);
   }
 
+  // optional uint32 prefetch_count = 39 [default = 3];
+  if (has_prefetch_count()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(39, this->prefetch_count(), output);
+  }
+
+  // optional bool zero_copy = 40 [default = false];
+  if (has_zero_copy()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(40, this->zero_copy(), output);
+  }
+
+  // optional uint32 decode_threads = 41 [default = 1];
+  if (has_decode_threads()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(41, this->decode_threads(), output);
+  }
+
+  // optional .caffe.LayerParameter.DataSource source_type = 42 [default = LEVELDB];
+  if (has_source_type()) {
+    ::google::protobuf::internal::WireFormatLite::WriteEnum(
+      42, this->source_type(), output);
+  }
+
+  // optional bool query_batching = 43 [default = false];
+  if (has_query_batching()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(43, this->query_batching(), output);
+  }
+
+  // optional uint32 jump_index_stride = 44 [default = 256];
+  if (has_jump_index_stride()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(44, this->jump_index_stride(), output);
+  }
+
+  // optional string jump_index_file = 45;
+  if (has_jump_index_file()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+      this->jump_index_file().data(), this->jump_index_file().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE);
+    ::google::protobuf::internal::WireFormatLite::WriteString(
+      45, this->jump_index_file(), output);
+  }
+
+  // optional bool shuffle = 46 [default = false];
+  if (has_shuffle()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(46, this->shuffle(), output);
+  }
+
+  // optional uint32 shuffle_window = 47 [default = 16];
+  if (has_shuffle_window()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(47, this->shuffle_window(), output);
+  }
+
+  // optional string quantization_file = 48;
+  if (has_quantization_file()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+      this->quantization_file().data(), this->quantization_file().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE);
+    ::google::protobuf::internal::WireFormatLite::WriteString(
+      48, this->quantization_file(), output);
+  }
+
+  // optional bool in_memory = 49 [default = false];
+  if (has_in_memory()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(49, this->in_memory(), output);
+  }
+
   // repeated .caffe.BlobProto blobs = 50;
   for (int i = 0; i < this->blobs_size(); i++) {
     ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
@@ -4694,6 +5750,32 @@ void LayerParameter::SerializeWithCachedSizes(
       54, this->forests(i), output);
   }
 
+  // optional .caffe.LayerParameter.ShardOrder shard_order = 55 [default = ROUND_ROBIN];
+  if (has_shard_order()) {
+    ::google::protobuf::internal::WireFormatLite::WriteEnum(
+      55, this->shard_order(), output);
+  }
+
+  // optional bool streaming = 56 [default = false];
+  if (has_streaming()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(56, this->streaming(), output);
+  }
+
+  // optional uint32 stream_chunk_kb = 57 [default = 65536];
+  if (has_stream_chunk_kb()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(57, this->stream_chunk_kb(), output);
+  }
+
+  // optional bool in_memory_if_supported = 58 [default = false];
+  if (has_in_memory_if_supported()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(58, this->in_memory_if_supported(), output);
+  }
+
+  // optional bool query_padding = 59 [default = false];
+  if (has_query_padding()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(59, this->query_padding(), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -4917,6 +5999,72 @@ void LayerParameter::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(38, this->cal_2nd_grad(), target);
   }
 
+  // optional uint32 prefetch_count = 39 [default = 3];
+  if (has_prefetch_count()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(39, this->prefetch_count(), target);
+  }
+
+  // optional bool zero_copy = 40 [default = false];
+  if (has_zero_copy()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(40, this->zero_copy(), target);
+  }
+
+  // optional uint32 decode_threads = 41 [default = 1];
+  if (has_decode_threads()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(41, this->decode_threads(), target);
+  }
+
+  // optional .caffe.LayerParameter.DataSource source_type = 42 [default = LEVELDB];
+  if (has_source_type()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteEnumToArray(
+      42, this->source_type(), target);
+  }
+
+  // optional bool query_batching = 43 [default = false];
+  if (has_query_batching()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(43, this->query_batching(), target);
+  }
+
+  // optional uint32 jump_index_stride = 44 [default = 256];
+  if (has_jump_index_stride()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(44, this->jump_index_stride(), target);
+  }
+
+  // optional string jump_index_file = 45;
+  if (has_jump_index_file()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+      this->jump_index_file().data(), this->jump_index_file().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE);
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteStringToArray(
+        45, this->jump_index_file(), target);
+  }
+
+  // optional bool shuffle = 46 [default = false];
+  if (has_shuffle()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(46, this->shuffle(), target);
+  }
+
+  // optional uint32 shuffle_window = 47 [default = 16];
+  if (has_shuffle_window()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(47, this->shuffle_window(), target);
+  }
+
+  // optional string quantization_file = 48;
+  if (has_quantization_file()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+      this->quantization_file().data(), this->quantization_file().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE);
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteStringToArray(
+        48, this->quantization_file(), target);
+  }
+
+  // optional bool in_memory = 49 [default = false];
+  if (has_in_memory()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(49, this->in_memory(), target);
+  }
+
   // repeated .caffe.BlobProto blobs = 50;
   for (int i = 0; i < this->blobs_size(); i++) {
     target = ::google::protobuf::internal::WireFormatLite::
@@ -4948,6 +6096,32 @@ void LayerParameter::SerializeWithCachedSizes(
         54, this->forests(i), target);
   }
 
+  // optional .caffe.LayerParameter.ShardOrder shard_order = 55 [default = ROUND_ROBIN];
+  if (has_shard_order()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteEnumToArray(
+      55, this->shard_order(), target);
+  }
+
+  // optional bool streaming = 56 [default = false];
+  if (has_streaming()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(56, this->streaming(), target);
+  }
+
+  // optional uint32 stream_chunk_kb = 57 [default = 65536];
+  if (has_stream_chunk_kb()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(57, this->stream_chunk_kb(), target);
+  }
+
+  // optional bool in_memory_if_supported = 58 [default = false];
+  if (has_in_memory_if_supported()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(58, this->in_memory_if_supported(), target);
+  }
+
+  // optional bool query_padding = 59 [default = false];
+  if (has_query_padding()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(59, this->query_padding(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -5198,8 +6372,108 @@ int LayerParameter::ByteSize() const {
       total_size += 2 + 1;
     }
 
+    // optional uint32 prefetch_count = 39 [default = 3];
+    if (has_prefetch_count()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->prefetch_count());
+    }
+
+    // optional bool zero_copy = 40 [default = false];
+    if (has_zero_copy()) {
+      total_size += 2 + 1;
+    }
+
+  }
+  if (_has_bits_[40 / 32] & (0xffu << (40 % 32))) {
+    // optional uint32 decode_threads = 41 [default = 1];
+    if (has_decode_threads()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->decode_threads());
+    }
+
+    // optional .caffe.LayerParameter.DataSource source_type = 42 [default = LEVELDB];
+    if (has_source_type()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::EnumSize(this->source_type());
+    }
+
+    // optional bool query_batching = 43 [default = false];
+    if (has_query_batching()) {
+      total_size += 2 + 1;
+    }
+
+    // optional uint32 jump_index_stride = 44 [default = 256];
+    if (has_jump_index_stride()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->jump_index_stride());
+    }
+
+    // optional string jump_index_file = 45;
+    if (has_jump_index_file()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::StringSize(
+          this->jump_index_file());
+    }
+
+    // optional bool shuffle = 46 [default = false];
+    if (has_shuffle()) {
+      total_size += 2 + 1;
+    }
+
+    // optional uint32 shuffle_window = 47 [default = 16];
+    if (has_shuffle_window()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->shuffle_window());
+    }
+
+    // optional string quantization_file = 48;
+    if (has_quantization_file()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::StringSize(
+          this->quantization_file());
+    }
+
+  }
+  if (_has_bits_[48 / 32] & (0xffu << (48 % 32))) {
+    // optional bool in_memory = 49 [default = false];
+    if (has_in_memory()) {
+      total_size += 2 + 1;
+    }
+
+    // optional .caffe.LayerParameter.ShardOrder shard_order = 55 [default = ROUND_ROBIN];
+    if (has_shard_order()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::EnumSize(this->shard_order());
+    }
+
+    // optional bool streaming = 56 [default = false];
+    if (has_streaming()) {
+      total_size += 2 + 1;
+    }
+
+    // optional uint32 stream_chunk_kb = 57 [default = 65536];
+    if (has_stream_chunk_kb()) {
+      total_size += 2 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->stream_chunk_kb());
+    }
+
+    // optional bool in_memory_if_supported = 58 [default = false];
+    if (has_in_memory_if_supported()) {
+      total_size += 2 + 1;
+    }
+
+    // optional bool query_padding = 59 [default = false];
+    if (has_query_padding()) {
+      total_size += 2 + 1;
+    }
+
   }
-  if (_has_bits_[41 / 32] & (0xffu << (41 % 32))) {
+  if (_has_bits_[57 / 32] & (0xffu << (57 % 32))) {
     // optional uint32 rand_skip = 53 [default = 0];
     if (has_rand_skip()) {
       total_size += 2 +
@@ -5390,8 +6664,60 @@ void LayerParameter::MergeFrom(const LayerParameter& from) {
     if (from.has_cal_2nd_grad()) {
       set_cal_2nd_grad(from.cal_2nd_grad());
     }
+    if (from.has_prefetch_count()) {
+      set_prefetch_count(from.prefetch_count());
+    }
+    if (from.has_zero_copy()) {
+      set_zero_copy(from.zero_copy());
+    }
+  }
+  if (from._has_bits_[40 / 32] & (0xffu << (40 % 32))) {
+    if (from.has_decode_threads()) {
+      set_decode_threads(from.decode_threads());
+    }
+    if (from.has_source_type()) {
+      set_source_type(from.source_type());
+    }
+    if (from.has_query_batching()) {
+      set_query_batching(from.query_batching());
+    }
+    if (from.has_jump_index_stride()) {
+      set_jump_index_stride(from.jump_index_stride());
+    }
+    if (from.has_jump_index_file()) {
+      set_jump_index_file(from.jump_index_file());
+    }
+    if (from.has_shuffle()) {
+      set_shuffle(from.shuffle());
+    }
+    if (from.has_shuffle_window()) {
+      set_shuffle_window(from.shuffle_window());
+    }
+    if (from.has_quantization_file()) {
+      set_quantization_file(from.quantization_file());
+    }
+  }
+  if (from._has_bits_[48 / 32] & (0xffu << (48 % 32))) {
+    if (from.has_in_memory()) {
+      set_in_memory(from.in_memory());
+    }
+    if (from.has_shard_order()) {
+      set_shard_order(from.shard_order());
+    }
+    if (from.has_streaming()) {
+      set_streaming(from.streaming());
+    }
+    if (from.has_stream_chunk_kb()) {
+      set_stream_chunk_kb(from.stream_chunk_kb());
+    }
+    if (from.has_in_memory_if_supported()) {
+      set_in_memory_if_supported(from.in_memory_if_supported());
+    }
+    if (from.has_query_padding()) {
+      set_query_padding(from.query_padding());
+    }
   }
-  if (from._has_bits_[41 / 32] & (0xffu << (41 % 32))) {
+  if (from._has_bits_[57 / 32] & (0xffu << (57 % 32))) {
     if (from.has_rand_skip()) {
       set_rand_skip(from.rand_skip());
     }
@@ -5459,6 +6785,22 @@ void LayerParameter::Swap(LayerParameter* other) {
     std::swap(max_leaf_num_, other->max_leaf_num_);
     std::swap(lazy_pred_, other->lazy_pred_);
     std::swap(cal_2nd_grad_, other->cal_2nd_grad_);
+    std::swap(prefetch_count_, other->prefetch_count_);
+    std::swap(zero_copy_, other->zero_copy_);
+    std::swap(decode_threads_, other->decode_threads_);
+    std::swap(source_type_, other->source_type_);
+    std::swap(query_batching_, other->query_batching_);
+    std::swap(jump_index_stride_, other->jump_index_stride_);
+    std::swap(jump_index_file_, other->jump_index_file_);
+    std::swap(shuffle_, other->shuffle_);
+    std::swap(shuffle_window_, other->shuffle_window_);
+    std::swap(quantization_file_, other->quantization_file_);
+    std::swap(in_memory_, other->in_memory_);
+    std::swap(shard_order_, other->shard_order_);
+    std::swap(streaming_, other->streaming_);
+    std::swap(stream_chunk_kb_, other->stream_chunk_kb_);
+    std::swap(in_memory_if_supported_, other->in_memory_if_supported_);
+    std::swap(query_padding_, other->query_padding_);
     blobs_.Swap(&other->blobs_);
     blobs_lr_.Swap(&other->blobs_lr_);
     weight_decay_.Swap(&other->weight_decay_);
@@ -6216,6 +7558,7 @@ const int SolverParameter::kSnapshotDiffFieldNumber;
 const int SolverParameter::kSolverModeFieldNumber;
 const int SolverParameter::kDeviceIdFieldNumber;
 const int SolverParameter::kCal2NdGradFieldNumber;
+const int SolverParameter::kTestDataInMemoryFieldNumber;
 #endif  // !_MSC_VER
 
 SolverParameter::SolverParameter()
@@ -6253,6 +7596,7 @@ void SolverParameter::SharedCtor() {
   solver_mode_ = 1;
   device_id_ = 0;
   cal_2nd_grad_ = false;
+  test_data_in_memory_ = false;
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -6339,6 +7683,7 @@ void SolverParameter::Clear() {
     solver_mode_ = 1;
     device_id_ = 0;
     cal_2nd_grad_ = false;
+    test_data_in_memory_ = false;
   }
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
@@ -6653,6 +7998,22 @@ bool SolverParameter::MergePartialFromCodedStream(
         } else {
           goto handle_uninterpreted;
         }
+        if (input->ExpectTag(160)) goto parse_test_data_in_memory;
+        break;
+      }
+
+      // optional bool test_data_in_memory = 20 [default = false];
+      case 20: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_test_data_in_memory:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &test_data_in_memory_)));
+          set_has_test_data_in_memory();
+        } else {
+          goto handle_uninterpreted;
+        }
         if (input->ExpectAtEnd()) return true;
         break;
       }
@@ -6786,6 +8147,11 @@ void SolverParameter::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteBool(19, this->cal_2nd_grad(), output);
   }
 
+  // optional bool test_data_in_memory = 20 [default = false];
+  if (has_test_data_in_memory()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(20, this->test_data_in_memory(), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -6909,6 +8275,11 @@ void SolverParameter::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(19, this->cal_2nd_grad(), target);
   }
 
+  // optional bool test_data_in_memory = 20 [default = false];
+  if (has_test_data_in_memory()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(20, this->test_data_in_memory(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -7043,6 +8414,11 @@ int SolverParameter::ByteSize() const {
       total_size += 2 + 1;
     }
 
+    // optional bool test_data_in_memory = 20 [default = false];
+    if (has_test_data_in_memory()) {
+      total_size += 2 + 1;
+    }
+
   }
   if (!unknown_fields().empty()) {
     total_size +=
@@ -7131,6 +8507,9 @@ void SolverParameter::MergeFrom(const SolverParameter& from) {
     if (from.has_cal_2nd_grad()) {
       set_cal_2nd_grad(from.cal_2nd_grad());
     }
+    if (from.has_test_data_in_memory()) {
+      set_test_data_in_memory(from.test_data_in_memory());
+    }
   }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
@@ -7173,6 +8552,7 @@ void SolverParameter::Swap(SolverParameter* other) {
     std::swap(solver_mode_, other->solver_mode_);
     std::swap(device_id_, other->device_id_);
     std::swap(cal_2nd_grad_, other->cal_2nd_grad_);
+    std::swap(test_data_in_memory_, other->test_data_in_memory_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -36,6 +36,7 @@ void protobuf_ShutdownFile_caffe_2eproto();
 
 class BlobProto;
 class BlobProtoVector;
+class KeyIndex;
 class Datum;
 class FillerParameter;
 class TreeNodeProto;
@@ -67,6 +68,44 @@ inline bool LayerParameter_PoolMethod_Parse(
   return ::google::protobuf::internal::ParseNamedEnum<LayerParameter_PoolMethod>(
     LayerParameter_PoolMethod_descriptor(), name, value);
 }
+enum LayerParameter_DataSource {
+  LayerParameter_DataSource_LEVELDB = 0,
+  LayerParameter_DataSource_DENSE = 1
+};
+bool LayerParameter_DataSource_IsValid(int value);
+const LayerParameter_DataSource LayerParameter_DataSource_DataSource_MIN = LayerParameter_DataSource_LEVELDB;
+const LayerParameter_DataSource LayerParameter_DataSource_DataSource_MAX = LayerParameter_DataSource_DENSE;
+const int LayerParameter_DataSource_DataSource_ARRAYSIZE = LayerParameter_DataSource_DataSource_MAX + 1;
+
+const ::google::protobuf::EnumDescriptor* LayerParameter_DataSource_descriptor();
+inline const ::std::string& LayerParameter_DataSource_Name(LayerParameter_DataSource value) {
+  return ::google::protobuf::internal::NameOfEnum(
+    LayerParameter_DataSource_descriptor(), value);
+}
+inline bool LayerParameter_DataSource_Parse(
+    const ::std::string& name, LayerParameter_DataSource* value) {
+  return ::google::protobuf::internal::ParseNamedEnum<LayerParameter_DataSource>(
+    LayerParameter_DataSource_descriptor(), name, value);
+}
+enum LayerParameter_ShardOrder {
+  LayerParameter_ShardOrder_ROUND_ROBIN = 0,
+  LayerParameter_ShardOrder_BY_SIZE = 1
+};
+bool LayerParameter_ShardOrder_IsValid(int value);
+const LayerParameter_ShardOrder LayerParameter_ShardOrder_ShardOrder_MIN = LayerParameter_ShardOrder_ROUND_ROBIN;
+const LayerParameter_ShardOrder LayerParameter_ShardOrder_ShardOrder_MAX = LayerParameter_ShardOrder_BY_SIZE;
+const int LayerParameter_ShardOrder_ShardOrder_ARRAYSIZE = LayerParameter_ShardOrder_ShardOrder_MAX + 1;
+
+const ::google::protobuf::EnumDescriptor* LayerParameter_ShardOrder_descriptor();
+inline const ::std::string& LayerParameter_ShardOrder_Name(LayerParameter_ShardOrder value) {
+  return ::google::protobuf::internal::NameOfEnum(
+    LayerParameter_ShardOrder_descriptor(), value);
+}
+inline bool LayerParameter_ShardOrder_Parse(
+    const ::std::string& name, LayerParameter_ShardOrder* value) {
+  return ::google::protobuf::internal::ParseNamedEnum<LayerParameter_ShardOrder>(
+    LayerParameter_ShardOrder_descriptor(), name, value);
+}
 // ===================================================================
 
 class BlobProto : public ::google::protobuf::Message {
@@ -308,6 +347,115 @@ class BlobProtoVector : public ::google::protobuf::Message {
 };
 // -------------------------------------------------------------------
 
+class KeyIndex : public ::google::protobuf::Message {
+ public:
+  KeyIndex();
+  virtual ~KeyIndex();
+
+  KeyIndex(const KeyIndex& from);
+
+  inline KeyIndex& operator=(const KeyIndex& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const KeyIndex& default_instance();
+
+  void Swap(KeyIndex* other);
+
+  // implements Message ----------------------------------------------
+
+  KeyIndex* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const KeyIndex& from);
+  void MergeFrom(const KeyIndex& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // optional uint32 stride = 1;
+  inline bool has_stride() const;
+  inline void clear_stride();
+  static const int kStrideFieldNumber = 1;
+  inline ::google::protobuf::uint32 stride() const;
+  inline void set_stride(::google::protobuf::uint32 value);
+
+  // optional uint64 num_records = 2;
+  inline bool has_num_records() const;
+  inline void clear_num_records();
+  static const int kNumRecordsFieldNumber = 2;
+  inline ::google::protobuf::uint64 num_records() const;
+  inline void set_num_records(::google::protobuf::uint64 value);
+
+  // repeated bytes keys = 3;
+  inline int keys_size() const;
+  inline void clear_keys();
+  static const int kKeysFieldNumber = 3;
+  inline const ::std::string& keys(int index) const;
+  inline ::std::string* mutable_keys(int index);
+  inline void set_keys(int index, const ::std::string& value);
+  inline void set_keys(int index, const char* value);
+  inline void set_keys(int index, const void* value, size_t size);
+  inline ::std::string* add_keys();
+  inline void add_keys(const ::std::string& value);
+  inline void add_keys(const char* value);
+  inline void add_keys(const void* value, size_t size);
+  inline const ::google::protobuf::RepeatedPtrField< ::std::string>& keys() const;
+  inline ::google::protobuf::RepeatedPtrField< ::std::string>* mutable_keys();
+
+  // @@protoc_insertion_point(class_scope:caffe.KeyIndex)
+ private:
+  inline void set_has_stride();
+  inline void clear_has_stride();
+  inline void set_has_num_records();
+  inline void clear_has_num_records();
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint64 num_records_;
+  ::google::protobuf::RepeatedPtrField< ::std::string> keys_;
+  ::google::protobuf::uint32 stride_;
+
+  mutable int _cached_size_;
+  ::google::protobuf::uint32 _has_bits_[(3 + 31) / 32];
+
+  friend void  protobuf_AddDesc_caffe_2eproto();
+  friend void protobuf_AssignDesc_caffe_2eproto();
+  friend void protobuf_ShutdownFile_caffe_2eproto();
+
+  void InitAsDefaultInstance();
+  static KeyIndex* default_instance_;
+};
+// -------------------------------------------------------------------
+
 class Datum : public ::google::protobuf::Message {
  public:
   Datum();
@@ -402,7 +550,7 @@ class Datum : public ::google::protobuf::Message {
   inline ::google::protobuf::int32 label() const;
   inline void set_label(::google::protobuf::int32 value);
 
-  // repeated float float_data = 6;
+  // repeated float float_data = 6 [packed = true];
   inline int float_data_size() const;
   inline void clear_float_data();
   static const int kFloatDataFieldNumber = 6;
@@ -414,7 +562,7 @@ class Datum : public ::google::protobuf::Message {
   inline ::google::protobuf::RepeatedField< float >*
       mutable_float_data();
 
-  // repeated float float_label = 7;
+  // repeated float float_label = 7 [packed = true];
   inline int float_label_size() const;
   inline void clear_float_label();
   static const int kFloatLabelFieldNumber = 7;
@@ -433,6 +581,49 @@ class Datum : public ::google::protobuf::Message {
   inline ::google::protobuf::int32 group_id() const;
   inline void set_group_id(::google::protobuf::int32 value);
 
+  // repeated int32 sparse_index = 9 [packed = true];
+  inline int sparse_index_size() const;
+  inline void clear_sparse_index();
+  static const int kSparseIndexFieldNumber = 9;
+  inline ::google::protobuf::int32 sparse_index(int index) const;
+  inline void set_sparse_index(int index, ::google::protobuf::int32 value);
+  inline void add_sparse_index(::google::protobuf::int32 value);
+  inline const ::google::protobuf::RepeatedField< ::google::protobuf::int32 >&
+      sparse_index() const;
+  inline ::google::protobuf::RepeatedField< ::google::protobuf::int32 >*
+      mutable_sparse_index();
+
+  // repeated float sparse_value = 10 [packed = true];
+  inline int sparse_value_size() const;
+  inline void clear_sparse_value();
+  static const int kSparseValueFieldNumber = 10;
+  inline float sparse_value(int index) const;
+  inline void set_sparse_value(int index, float value);
+  inline void add_sparse_value(float value);
+  inline const ::google::protobuf::RepeatedField< float >&
+      sparse_value() const;
+  inline ::google::protobuf::RepeatedField< float >*
+      mutable_sparse_value();
+
+  // optional int32 sparse_dim = 11 [default = 0];
+  inline bool has_sparse_dim() const;
+  inline void clear_sparse_dim();
+  static const int kSparseDimFieldNumber = 11;
+  inline ::google::protobuf::int32 sparse_dim() const;
+  inline void set_sparse_dim(::google::protobuf::int32 value);
+
+  // optional bytes half_data = 12;
+  inline bool has_half_data() const;
+  inline void clear_half_data();
+  static const int kHalfDataFieldNumber = 12;
+  inline const ::std::string& half_data() const;
+  inline void set_half_data(const ::std::string& value);
+  inline void set_half_data(const char* value);
+  inline void set_half_data(const void* value, size_t size);
+  inline ::std::string* mutable_half_data();
+  inline ::std::string* release_half_data();
+  inline void set_allocated_half_data(::std::string* half_data);
+
   // @@protoc_insertion_point(class_scope:caffe.Datum)
  private:
   inline void set_has_channels();
@@ -447,6 +638,10 @@ class Datum : public ::google::protobuf::Message {
   inline void clear_has_label();
   inline void set_has_group_id();
   inline void clear_has_group_id();
+  inline void set_has_sparse_dim();
+  inline void clear_has_sparse_dim();
+  inline void set_has_half_data();
+  inline void clear_has_half_data();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
@@ -456,11 +651,19 @@ class Datum : public ::google::protobuf::Message {
   ::google::protobuf::int32 width_;
   ::google::protobuf::int32 label_;
   ::google::protobuf::RepeatedField< float > float_data_;
+  mutable int _float_data_cached_byte_size_;
   ::google::protobuf::RepeatedField< float > float_label_;
+  mutable int _float_label_cached_byte_size_;
+  ::google::protobuf::RepeatedField< ::google::protobuf::int32 > sparse_index_;
+  mutable int _sparse_index_cached_byte_size_;
   ::google::protobuf::int32 group_id_;
+  ::google::protobuf::int32 sparse_dim_;
+  ::google::protobuf::RepeatedField< float > sparse_value_;
+  mutable int _sparse_value_cached_byte_size_;
+  ::std::string* half_data_;
 
   mutable int _cached_size_;
-  ::google::protobuf::uint32 _has_bits_[(8 + 31) / 32];
+  ::google::protobuf::uint32 _has_bits_[(12 + 31) / 32];
 
   friend void  protobuf_AddDesc_caffe_2eproto();
   friend void protobuf_AssignDesc_caffe_2eproto();
@@ -1108,6 +1311,54 @@ class LayerParameter : public ::google::protobuf::Message {
     return LayerParameter_PoolMethod_Parse(name, value);
   }
 
+  typedef LayerParameter_DataSource DataSource;
+  static const DataSource LEVELDB = LayerParameter_DataSource_LEVELDB;
+  static const DataSource DENSE = LayerParameter_DataSource_DENSE;
+  static inline bool DataSource_IsValid(int value) {
+    return LayerParameter_DataSource_IsValid(value);
+  }
+  static const DataSource DataSource_MIN =
+    LayerParameter_DataSource_DataSource_MIN;
+  static const DataSource DataSource_MAX =
+    LayerParameter_DataSource_DataSource_MAX;
+  static const int DataSource_ARRAYSIZE =
+    LayerParameter_DataSource_DataSource_ARRAYSIZE;
+  static inline const ::google::protobuf::EnumDescriptor*
+  DataSource_descriptor() {
+    return LayerParameter_DataSource_descriptor();
+  }
+  static inline const ::std::string& DataSource_Name(DataSource value) {
+    return LayerParameter_DataSource_Name(value);
+  }
+  static inline bool DataSource_Parse(const ::std::string& name,
+      DataSource* value) {
+    return LayerParameter_DataSource_Parse(name, value);
+  }
+
+  typedef LayerParameter_ShardOrder ShardOrder;
+  static const ShardOrder ROUND_ROBIN = LayerParameter_ShardOrder_ROUND_ROBIN;
+  static const ShardOrder BY_SIZE = LayerParameter_ShardOrder_BY_SIZE;
+  static inline bool ShardOrder_IsValid(int value) {
+    return LayerParameter_ShardOrder_IsValid(value);
+  }
+  static const ShardOrder ShardOrder_MIN =
+    LayerParameter_ShardOrder_ShardOrder_MIN;
+  static const ShardOrder ShardOrder_MAX =
+    LayerParameter_ShardOrder_ShardOrder_MAX;
+  static const int ShardOrder_ARRAYSIZE =
+    LayerParameter_ShardOrder_ShardOrder_ARRAYSIZE;
+  static inline const ::google::protobuf::EnumDescriptor*
+  ShardOrder_descriptor() {
+    return LayerParameter_ShardOrder_descriptor();
+  }
+  static inline const ::std::string& ShardOrder_Name(ShardOrder value) {
+    return LayerParameter_ShardOrder_Name(value);
+  }
+  static inline bool ShardOrder_Parse(const ::std::string& name,
+      ShardOrder* value) {
+    return LayerParameter_ShardOrder_Parse(name, value);
+  }
+
   // accessors -------------------------------------------------------
 
   // optional string name = 1;
@@ -1400,6 +1651,128 @@ class LayerParameter : public ::google::protobuf::Message {
   inline bool cal_2nd_grad() const;
   inline void set_cal_2nd_grad(bool value);
 
+  // optional uint32 prefetch_count = 39 [default = 3];
+  inline bool has_prefetch_count() const;
+  inline void clear_prefetch_count();
+  static const int kPrefetchCountFieldNumber = 39;
+  inline ::google::protobuf::uint32 prefetch_count() const;
+  inline void set_prefetch_count(::google::protobuf::uint32 value);
+
+  // optional bool zero_copy = 40 [default = false];
+  inline bool has_zero_copy() const;
+  inline void clear_zero_copy();
+  static const int kZeroCopyFieldNumber = 40;
+  inline bool zero_copy() const;
+  inline void set_zero_copy(bool value);
+
+  // optional uint32 decode_threads = 41 [default = 1];
+  inline bool has_decode_threads() const;
+  inline void clear_decode_threads();
+  static const int kDecodeThreadsFieldNumber = 41;
+  inline ::google::protobuf::uint32 decode_threads() const;
+  inline void set_decode_threads(::google::protobuf::uint32 value);
+
+  // optional .caffe.LayerParameter.DataSource source_type = 42 [default = LEVELDB];
+  inline bool has_source_type() const;
+  inline void clear_source_type();
+  static const int kSourceTypeFieldNumber = 42;
+  inline ::caffe::LayerParameter_DataSource source_type() const;
+  inline void set_source_type(::caffe::LayerParameter_DataSource value);
+
+  // optional bool query_batching = 43 [default = false];
+  inline bool has_query_batching() const;
+  inline void clear_query_batching();
+  static const int kQueryBatchingFieldNumber = 43;
+  inline bool query_batching() const;
+  inline void set_query_batching(bool value);
+
+  // optional uint32 jump_index_stride = 44 [default = 256];
+  inline bool has_jump_index_stride() const;
+  inline void clear_jump_index_stride();
+  static const int kJumpIndexStrideFieldNumber = 44;
+  inline ::google::protobuf::uint32 jump_index_stride() const;
+  inline void set_jump_index_stride(::google::protobuf::uint32 value);
+
+  // optional string jump_index_file = 45;
+  inline bool has_jump_index_file() const;
+  inline void clear_jump_index_file();
+  static const int kJumpIndexFileFieldNumber = 45;
+  inline const ::std::string& jump_index_file() const;
+  inline void set_jump_index_file(const ::std::string& value);
+  inline void set_jump_index_file(const char* value);
+  inline void set_jump_index_file(const char* value, size_t size);
+  inline ::std::string* mutable_jump_index_file();
+  inline ::std::string* release_jump_index_file();
+  inline void set_allocated_jump_index_file(::std::string* jump_index_file);
+
+  // optional bool shuffle = 46 [default = false];
+  inline bool has_shuffle() const;
+  inline void clear_shuffle();
+  static const int kShuffleFieldNumber = 46;
+  inline bool shuffle() const;
+  inline void set_shuffle(bool value);
+
+  // optional uint32 shuffle_window = 47 [default = 16];
+  inline bool has_shuffle_window() const;
+  inline void clear_shuffle_window();
+  static const int kShuffleWindowFieldNumber = 47;
+  inline ::google::protobuf::uint32 shuffle_window() const;
+  inline void set_shuffle_window(::google::protobuf::uint32 value);
+
+  // optional string quantization_file = 48;
+  inline bool has_quantization_file() const;
+  inline void clear_quantization_file();
+  static const int kQuantizationFileFieldNumber = 48;
+  inline const ::std::string& quantization_file() const;
+  inline void set_quantization_file(const ::std::string& value);
+  inline void set_quantization_file(const char* value);
+  inline void set_quantization_file(const char* value, size_t size);
+  inline ::std::string* mutable_quantization_file();
+  inline ::std::string* release_quantization_file();
+  inline void set_allocated_quantization_file(::std::string* quantization_file);
+
+  // optional bool in_memory = 49 [default = false];
+  inline bool has_in_memory() const;
+  inline void clear_in_memory();
+  static const int kInMemoryFieldNumber = 49;
+  inline bool in_memory() const;
+  inline void set_in_memory(bool value);
+
+  // optional .caffe.LayerParameter.ShardOrder shard_order = 55 [default = ROUND_ROBIN];
+  inline bool has_shard_order() const;
+  inline void clear_shard_order();
+  static const int kShardOrderFieldNumber = 55;
+  inline ::caffe::LayerParameter_ShardOrder shard_order() const;
+  inline void set_shard_order(::caffe::LayerParameter_ShardOrder value);
+
+  // optional bool streaming = 56 [default = false];
+  inline bool has_streaming() const;
+  inline void clear_streaming();
+  static const int kStreamingFieldNumber = 56;
+  inline bool streaming() const;
+  inline void set_streaming(bool value);
+
+  // optional uint32 stream_chunk_kb = 57 [default = 65536];
+  inline bool has_stream_chunk_kb() const;
+  inline void clear_stream_chunk_kb();
+  static const int kStreamChunkKbFieldNumber = 57;
+  inline ::google::protobuf::uint32 stream_chunk_kb() const;
+  inline void set_stream_chunk_kb(::google::protobuf::uint32 value);
+
+  // optional bool in_memory_if_supported = 58 [default = false];
+  inline bool has_in_memory_if_supported() const;
+  inline void clear_in_memory_if_supported();
+  static const int kInMemoryIfSupportedFieldNumber = 58;
+  inline bool in_memory_if_supported() const;
+  inline void set_in_memory_if_supported(bool value);
+
+  // optional bool query_padding = 59 [default = false];
+  inline bool has_query_padding() const;
+  inline void clear_query_padding();
+  static const int kQueryPaddingFieldNumber = 59;
+  inline bool query_padding() const;
+  inline void set_query_padding(bool value);
+
   // repeated .caffe.BlobProto blobs = 50;
   inline int blobs_size() const;
   inline void clear_blobs();
@@ -1533,6 +1906,38 @@ class LayerParameter : public ::google::protobuf::Message {
   inline void clear_has_lazy_pred();
   inline void set_has_cal_2nd_grad();
   inline void clear_has_cal_2nd_grad();
+  inline void set_has_prefetch_count();
+  inline void clear_has_prefetch_count();
+  inline void set_has_zero_copy();
+  inline void clear_has_zero_copy();
+  inline void set_has_decode_threads();
+  inline void clear_has_decode_threads();
+  inline void set_has_source_type();
+  inline void clear_has_source_type();
+  inline void set_has_query_batching();
+  inline void clear_has_query_batching();
+  inline void set_has_jump_index_stride();
+  inline void clear_has_jump_index_stride();
+  inline void set_has_jump_index_file();
+  inline void clear_has_jump_index_file();
+  inline void set_has_shuffle();
+  inline void clear_has_shuffle();
+  inline void set_has_shuffle_window();
+  inline void clear_has_shuffle_window();
+  inline void set_has_quantization_file();
+  inline void clear_has_quantization_file();
+  inline void set_has_in_memory();
+  inline void clear_has_in_memory();
+  inline void set_has_shard_order();
+  inline void clear_has_shard_order();
+  inline void set_has_streaming();
+  inline void clear_has_streaming();
+  inline void set_has_stream_chunk_kb();
+  inline void clear_has_stream_chunk_kb();
+  inline void set_has_in_memory_if_supported();
+  inline void clear_has_in_memory_if_supported();
+  inline void set_has_query_padding();
+  inline void clear_has_query_padding();
   inline void set_has_rand_skip();
   inline void clear_has_rand_skip();
 
@@ -1574,16 +1979,32 @@ class LayerParameter : public ::google::protobuf::Message {
   float rand_samp_;
   float min_obs_;
   ::google::protobuf::uint32 max_leaf_num_;
+  ::google::protobuf::uint32 prefetch_count_;
   bool lazy_pred_;
   bool cal_2nd_grad_;
+  bool zero_copy_;
+  bool query_batching_;
+  ::google::protobuf::uint32 decode_threads_;
+  int source_type_;
+  ::google::protobuf::uint32 jump_index_stride_;
+  ::std::string* jump_index_file_;
+  ::std::string* quantization_file_;
+  ::google::protobuf::uint32 shuffle_window_;
+  bool shuffle_;
+  bool in_memory_;
+  bool streaming_;
+  bool in_memory_if_supported_;
+  int shard_order_;
+  ::google::protobuf::uint32 stream_chunk_kb_;
   ::google::protobuf::RepeatedPtrField< ::caffe::BlobProto > blobs_;
   ::google::protobuf::RepeatedField< float > blobs_lr_;
+  bool query_padding_;
+  ::google::protobuf::uint32 rand_skip_;
   ::google::protobuf::RepeatedField< float > weight_decay_;
   ::google::protobuf::RepeatedPtrField< ::caffe::ForestProto > forests_;
-  ::google::protobuf::uint32 rand_skip_;
 
   mutable int _cached_size_;
-  ::google::protobuf::uint32 _has_bits_[(43 + 31) / 32];
+  ::google::protobuf::uint32 _has_bits_[(59 + 31) / 32];
 
   friend void  protobuf_AddDesc_caffe_2eproto();
   friend void protobuf_AssignDesc_caffe_2eproto();
@@ -2059,6 +2480,13 @@ class SolverParameter : public ::google::protobuf::Message {
   inline bool cal_2nd_grad() const;
   inline void set_cal_2nd_grad(bool value);
 
+  // optional bool test_data_in_memory = 20 [default = false];
+  inline bool has_test_data_in_memory() const;
+  inline void clear_test_data_in_memory();
+  static const int kTestDataInMemoryFieldNumber = 20;
+  inline bool test_data_in_memory() const;
+  inline void set_test_data_in_memory(bool value);
+
   // @@protoc_insertion_point(class_scope:caffe.SolverParameter)
  private:
   inline void set_has_train_net();
@@ -2099,6 +2527,8 @@ class SolverParameter : public ::google::protobuf::Message {
   inline void clear_has_device_id();
   inline void set_has_cal_2nd_grad();
   inline void clear_has_cal_2nd_grad();
+  inline void set_has_test_data_in_memory();
+  inline void clear_has_test_data_in_memory();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
@@ -2118,12 +2548,13 @@ class SolverParameter : public ::google::protobuf::Message {
   ::std::string* snapshot_prefix_;
   ::google::protobuf::int32 snapshot_;
   ::google::protobuf::int32 solver_mode_;
+  ::google::protobuf::int32 device_id_;
   bool snapshot_diff_;
   bool cal_2nd_grad_;
-  ::google::protobuf::int32 device_id_;
+  bool test_data_in_memory_;
 
   mutable int _cached_size_;
-  ::google::protobuf::uint32 _has_bits_[(19 + 31) / 32];
+  ::google::protobuf::uint32 _has_bits_[(20 + 31) / 32];
 
   friend void  protobuf_AddDesc_caffe_2eproto();
   friend void protobuf_AssignDesc_caffe_2eproto();
@@ -2443,6 +2874,98 @@ BlobProtoVector::mutable_blobs() {
 
 // -------------------------------------------------------------------
 
+// KeyIndex
+
+// optional uint32 stride = 1;
+inline bool KeyIndex::has_stride() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void KeyIndex::set_has_stride() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void KeyIndex::clear_has_stride() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void KeyIndex::clear_stride() {
+  stride_ = 0u;
+  clear_has_stride();
+}
+inline ::google::protobuf::uint32 KeyIndex::stride() const {
+  return stride_;
+}
+inline void KeyIndex::set_stride(::google::protobuf::uint32 value) {
+  set_has_stride();
+  stride_ = value;
+}
+
+// optional uint64 num_records = 2;
+inline bool KeyIndex::has_num_records() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void KeyIndex::set_has_num_records() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void KeyIndex::clear_has_num_records() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void KeyIndex::clear_num_records() {
+  num_records_ = GOOGLE_ULONGLONG(0);
+  clear_has_num_records();
+}
+inline ::google::protobuf::uint64 KeyIndex::num_records() const {
+  return num_records_;
+}
+inline void KeyIndex::set_num_records(::google::protobuf::uint64 value) {
+  set_has_num_records();
+  num_records_ = value;
+}
+
+// repeated bytes keys = 3;
+inline int KeyIndex::keys_size() const {
+  return keys_.size();
+}
+inline void KeyIndex::clear_keys() {
+  keys_.Clear();
+}
+inline const ::std::string& KeyIndex::keys(int index) const {
+  return keys_.Get(index);
+}
+inline ::std::string* KeyIndex::mutable_keys(int index) {
+  return keys_.Mutable(index);
+}
+inline void KeyIndex::set_keys(int index, const ::std::string& value) {
+  keys_.Mutable(index)->assign(value);
+}
+inline void KeyIndex::set_keys(int index, const char* value) {
+  keys_.Mutable(index)->assign(value);
+}
+inline void KeyIndex::set_keys(int index, const void* value, size_t size) {
+  keys_.Mutable(index)->assign(
+    reinterpret_cast<const char*>(value), size);
+}
+inline ::std::string* KeyIndex::add_keys() {
+  return keys_.Add();
+}
+inline void KeyIndex::add_keys(const ::std::string& value) {
+  keys_.Add()->assign(value);
+}
+inline void KeyIndex::add_keys(const char* value) {
+  keys_.Add()->assign(value);
+}
+inline void KeyIndex::add_keys(const void* value, size_t size) {
+  keys_.Add()->assign(reinterpret_cast<const char*>(value), size);
+}
+inline const ::google::protobuf::RepeatedPtrField< ::std::string>&
+KeyIndex::keys() const {
+  return keys_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::std::string>*
+KeyIndex::mutable_keys() {
+  return &keys_;
+}
+
+// -------------------------------------------------------------------
+
 // Datum
 
 // optional int32 channels = 1;
@@ -2603,7 +3126,7 @@ inline void Datum::set_label(::google::protobuf::int32 value) {
   label_ = value;
 }
 
-// repeated float float_data = 6;
+// repeated float float_data = 6 [packed = true];
 inline int Datum::float_data_size() const {
   return float_data_.size();
 }
@@ -2628,7 +3151,7 @@ Datum::mutable_float_data() {
   return &float_data_;
 }
 
-// repeated float float_label = 7;
+// repeated float float_label = 7 [packed = true];
 inline int Datum::float_label_size() const {
   return float_label_.size();
 }
@@ -2675,6 +3198,148 @@ inline void Datum::set_group_id(::google::protobuf::int32 value) {
   group_id_ = value;
 }
 
+// repeated int32 sparse_index = 9 [packed = true];
+inline int Datum::sparse_index_size() const {
+  return sparse_index_.size();
+}
+inline void Datum::clear_sparse_index() {
+  sparse_index_.Clear();
+}
+inline ::google::protobuf::int32 Datum::sparse_index(int index) const {
+  return sparse_index_.Get(index);
+}
+inline void Datum::set_sparse_index(int index, ::google::protobuf::int32 value) {
+  sparse_index_.Set(index, value);
+}
+inline void Datum::add_sparse_index(::google::protobuf::int32 value) {
+  sparse_index_.Add(value);
+}
+inline const ::google::protobuf::RepeatedField< ::google::protobuf::int32 >&
+Datum::sparse_index() const {
+  return sparse_index_;
+}
+inline ::google::protobuf::RepeatedField< ::google::protobuf::int32 >*
+Datum::mutable_sparse_index() {
+  return &sparse_index_;
+}
+
+// repeated float sparse_value = 10 [packed = true];
+inline int Datum::sparse_value_size() const {
+  return sparse_value_.size();
+}
+inline void Datum::clear_sparse_value() {
+  sparse_value_.Clear();
+}
+inline float Datum::sparse_value(int index) const {
+  return sparse_value_.Get(index);
+}
+inline void Datum::set_sparse_value(int index, float value) {
+  sparse_value_.Set(index, value);
+}
+inline void Datum::add_sparse_value(float value) {
+  sparse_value_.Add(value);
+}
+inline const ::google::protobuf::RepeatedField< float >&
+Datum::sparse_value() const {
+  return sparse_value_;
+}
+inline ::google::protobuf::RepeatedField< float >*
+Datum::mutable_sparse_value() {
+  return &sparse_value_;
+}
+
+// optional int32 sparse_dim = 11 [default = 0];
+inline bool Datum::has_sparse_dim() const {
+  return (_has_bits_[0] & 0x00000400u) != 0;
+}
+inline void Datum::set_has_sparse_dim() {
+  _has_bits_[0] |= 0x00000400u;
+}
+inline void Datum::clear_has_sparse_dim() {
+  _has_bits_[0] &= ~0x00000400u;
+}
+inline void Datum::clear_sparse_dim() {
+  sparse_dim_ = 0;
+  clear_has_sparse_dim();
+}
+inline ::google::protobuf::int32 Datum::sparse_dim() const {
+  return sparse_dim_;
+}
+inline void Datum::set_sparse_dim(::google::protobuf::int32 value) {
+  set_has_sparse_dim();
+  sparse_dim_ = value;
+}
+
+// optional bytes half_data = 12;
+inline bool Datum::has_half_data() const {
+  return (_has_bits_[0] & 0x00000800u) != 0;
+}
+inline void Datum::set_has_half_data() {
+  _has_bits_[0] |= 0x00000800u;
+}
+inline void Datum::clear_has_half_data() {
+  _has_bits_[0] &= ~0x00000800u;
+}
+inline void Datum::clear_half_data() {
+  if (half_data_ != &::google::protobuf::internal::kEmptyString) {
+    half_data_->clear();
+  }
+  clear_has_half_data();
+}
+inline const ::std::string& Datum::half_data() const {
+  return *half_data_;
+}
+inline void Datum::set_half_data(const ::std::string& value) {
+  set_has_half_data();
+  if (half_data_ == &::google::protobuf::internal::kEmptyString) {
+    half_data_ = new ::std::string;
+  }
+  half_data_->assign(value);
+}
+inline void Datum::set_half_data(const char* value) {
+  set_has_half_data();
+  if (half_data_ == &::google::protobuf::internal::kEmptyString) {
+    half_data_ = new ::std::string;
+  }
+  half_data_->assign(value);
+}
+inline void Datum::set_half_data(const void* value, size_t size) {
+  set_has_half_data();
+  if (half_data_ == &::google::protobuf::internal::kEmptyString) {
+    half_data_ = new ::std::string;
+  }
+  half_data_->assign(reinterpret_cast<const char*>(value), size);
+}
+inline ::std::string* Datum::mutable_half_data() {
+  set_has_half_data();
+  if (half_data_ == &::google::protobuf::internal::kEmptyString) {
+    half_data_ = new ::std::string;
+  }
+  return half_data_;
+}
+inline ::std::string* Datum::release_half_data() {
+  clear_has_half_data();
+  if (half_data_ == &::google::protobuf::internal::kEmptyString) {
+    return NULL;
+  } else {
+    ::std::string* temp = half_data_;
+    half_data_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+    return temp;
+  }
+}
+inline void Datum::set_allocated_half_data(::std::string* half_data) {
+  if (half_data_ != &::google::protobuf::internal::kEmptyString) {
+    delete half_data_;
+  }
+  if (half_data) {
+    set_has_half_data();
+    half_data_ = half_data;
+  } else {
+    clear_has_half_data();
+    half_data_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+  }
+}
+
 // -------------------------------------------------------------------
 
 // FillerParameter
@@ -4382,6 +5047,456 @@ inline void LayerParameter::set_cal_2nd_grad(bool value) {
   cal_2nd_grad_ = value;
 }
 
+// optional uint32 prefetch_count = 39 [default = 3];
+inline bool LayerParameter::has_prefetch_count() const {
+  return (_has_bits_[1] & 0x00000040u) != 0;
+}
+inline void LayerParameter::set_has_prefetch_count() {
+  _has_bits_[1] |= 0x00000040u;
+}
+inline void LayerParameter::clear_has_prefetch_count() {
+  _has_bits_[1] &= ~0x00000040u;
+}
+inline void LayerParameter::clear_prefetch_count() {
+  prefetch_count_ = 3u;
+  clear_has_prefetch_count();
+}
+inline ::google::protobuf::uint32 LayerParameter::prefetch_count() const {
+  return prefetch_count_;
+}
+inline void LayerParameter::set_prefetch_count(::google::protobuf::uint32 value) {
+  set_has_prefetch_count();
+  prefetch_count_ = value;
+}
+
+// optional bool zero_copy = 40 [default = false];
+inline bool LayerParameter::has_zero_copy() const {
+  return (_has_bits_[1] & 0x00000080u) != 0;
+}
+inline void LayerParameter::set_has_zero_copy() {
+  _has_bits_[1] |= 0x00000080u;
+}
+inline void LayerParameter::clear_has_zero_copy() {
+  _has_bits_[1] &= ~0x00000080u;
+}
+inline void LayerParameter::clear_zero_copy() {
+  zero_copy_ = false;
+  clear_has_zero_copy();
+}
+inline bool LayerParameter::zero_copy() const {
+  return zero_copy_;
+}
+inline void LayerParameter::set_zero_copy(bool value) {
+  set_has_zero_copy();
+  zero_copy_ = value;
+}
+
+// optional uint32 decode_threads = 41 [default = 1];
+inline bool LayerParameter::has_decode_threads() const {
+  return (_has_bits_[1] & 0x00000100u) != 0;
+}
+inline void LayerParameter::set_has_decode_threads() {
+  _has_bits_[1] |= 0x00000100u;
+}
+inline void LayerParameter::clear_has_decode_threads() {
+  _has_bits_[1] &= ~0x00000100u;
+}
+inline void LayerParameter::clear_decode_threads() {
+  decode_threads_ = 1u;
+  clear_has_decode_threads();
+}
+inline ::google::protobuf::uint32 LayerParameter::decode_threads() const {
+  return decode_threads_;
+}
+inline void LayerParameter::set_decode_threads(::google::protobuf::uint32 value) {
+  set_has_decode_threads();
+  decode_threads_ = value;
+}
+
+// optional .caffe.LayerParameter.DataSource source_type = 42 [default = LEVELDB];
+inline bool LayerParameter::has_source_type() const {
+  return (_has_bits_[1] & 0x00000200u) != 0;
+}
+inline void LayerParameter::set_has_source_type() {
+  _has_bits_[1] |= 0x00000200u;
+}
+inline void LayerParameter::clear_has_source_type() {
+  _has_bits_[1] &= ~0x00000200u;
+}
+inline void LayerParameter::clear_source_type() {
+  source_type_ = 0;
+  clear_has_source_type();
+}
+inline ::caffe::LayerParameter_DataSource LayerParameter::source_type() const {
+  return static_cast< ::caffe::LayerParameter_DataSource >(source_type_);
+}
+inline void LayerParameter::set_source_type(::caffe::LayerParameter_DataSource value) {
+  assert(::caffe::LayerParameter_DataSource_IsValid(value));
+  set_has_source_type();
+  source_type_ = value;
+}
+
+// optional bool query_batching = 43 [default = false];
+inline bool LayerParameter::has_query_batching() const {
+  return (_has_bits_[1] & 0x00000400u) != 0;
+}
+inline void LayerParameter::set_has_query_batching() {
+  _has_bits_[1] |= 0x00000400u;
+}
+inline void LayerParameter::clear_has_query_batching() {
+  _has_bits_[1] &= ~0x00000400u;
+}
+inline void LayerParameter::clear_query_batching() {
+  query_batching_ = false;
+  clear_has_query_batching();
+}
+inline bool LayerParameter::query_batching() const {
+  return query_batching_;
+}
+inline void LayerParameter::set_query_batching(bool value) {
+  set_has_query_batching();
+  query_batching_ = value;
+}
+
+// optional uint32 jump_index_stride = 44 [default = 256];
+inline bool LayerParameter::has_jump_index_stride() const {
+  return (_has_bits_[1] & 0x00000800u) != 0;
+}
+inline void LayerParameter::set_has_jump_index_stride() {
+  _has_bits_[1] |= 0x00000800u;
+}
+inline void LayerParameter::clear_has_jump_index_stride() {
+  _has_bits_[1] &= ~0x00000800u;
+}
+inline void LayerParameter::clear_jump_index_stride() {
+  jump_index_stride_ = 256u;
+  clear_has_jump_index_stride();
+}
+inline ::google::protobuf::uint32 LayerParameter::jump_index_stride() const {
+  return jump_index_stride_;
+}
+inline void LayerParameter::set_jump_index_stride(::google::protobuf::uint32 value) {
+  set_has_jump_index_stride();
+  jump_index_stride_ = value;
+}
+
+// optional string jump_index_file = 45;
+inline bool LayerParameter::has_jump_index_file() const {
+  return (_has_bits_[1] & 0x00001000u) != 0;
+}
+inline void LayerParameter::set_has_jump_index_file() {
+  _has_bits_[1] |= 0x00001000u;
+}
+inline void LayerParameter::clear_has_jump_index_file() {
+  _has_bits_[1] &= ~0x00001000u;
+}
+inline void LayerParameter::clear_jump_index_file() {
+  if (jump_index_file_ != &::google::protobuf::internal::kEmptyString) {
+    jump_index_file_->clear();
+  }
+  clear_has_jump_index_file();
+}
+inline const ::std::string& LayerParameter::jump_index_file() const {
+  return *jump_index_file_;
+}
+inline void LayerParameter::set_jump_index_file(const ::std::string& value) {
+  set_has_jump_index_file();
+  if (jump_index_file_ == &::google::protobuf::internal::kEmptyString) {
+    jump_index_file_ = new ::std::string;
+  }
+  jump_index_file_->assign(value);
+}
+inline void LayerParameter::set_jump_index_file(const char* value) {
+  set_has_jump_index_file();
+  if (jump_index_file_ == &::google::protobuf::internal::kEmptyString) {
+    jump_index_file_ = new ::std::string;
+  }
+  jump_index_file_->assign(value);
+}
+inline void LayerParameter::set_jump_index_file(const char* value, size_t size) {
+  set_has_jump_index_file();
+  if (jump_index_file_ == &::google::protobuf::internal::kEmptyString) {
+    jump_index_file_ = new ::std::string;
+  }
+  jump_index_file_->assign(reinterpret_cast<const char*>(value), size);
+}
+inline ::std::string* LayerParameter::mutable_jump_index_file() {
+  set_has_jump_index_file();
+  if (jump_index_file_ == &::google::protobuf::internal::kEmptyString) {
+    jump_index_file_ = new ::std::string;
+  }
+  return jump_index_file_;
+}
+inline ::std::string* LayerParameter::release_jump_index_file() {
+  clear_has_jump_index_file();
+  if (jump_index_file_ == &::google::protobuf::internal::kEmptyString) {
+    return NULL;
+  } else {
+    ::std::string* temp = jump_index_file_;
+    jump_index_file_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+    return temp;
+  }
+}
+inline void LayerParameter::set_allocated_jump_index_file(::std::string* jump_index_file) {
+  if (jump_index_file_ != &::google::protobuf::internal::kEmptyString) {
+    delete jump_index_file_;
+  }
+  if (jump_index_file) {
+    set_has_jump_index_file();
+    jump_index_file_ = jump_index_file;
+  } else {
+    clear_has_jump_index_file();
+    jump_index_file_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+  }
+}
+
+// optional bool shuffle = 46 [default = false];
+inline bool LayerParameter::has_shuffle() const {
+  return (_has_bits_[1] & 0x00002000u) != 0;
+}
+inline void LayerParameter::set_has_shuffle() {
+  _has_bits_[1] |= 0x00002000u;
+}
+inline void LayerParameter::clear_has_shuffle() {
+  _has_bits_[1] &= ~0x00002000u;
+}
+inline void LayerParameter::clear_shuffle() {
+  shuffle_ = false;
+  clear_has_shuffle();
+}
+inline bool LayerParameter::shuffle() const {
+  return shuffle_;
+}
+inline void LayerParameter::set_shuffle(bool value) {
+  set_has_shuffle();
+  shuffle_ = value;
+}
+
+// optional uint32 shuffle_window = 47 [default = 16];
+inline bool LayerParameter::has_shuffle_window() const {
+  return (_has_bits_[1] & 0x00004000u) != 0;
+}
+inline void LayerParameter::set_has_shuffle_window() {
+  _has_bits_[1] |= 0x00004000u;
+}
+inline void LayerParameter::clear_has_shuffle_window() {
+  _has_bits_[1] &= ~0x00004000u;
+}
+inline void LayerParameter::clear_shuffle_window() {
+  shuffle_window_ = 16u;
+  clear_has_shuffle_window();
+}
+inline ::google::protobuf::uint32 LayerParameter::shuffle_window() const {
+  return shuffle_window_;
+}
+inline void LayerParameter::set_shuffle_window(::google::protobuf::uint32 value) {
+  set_has_shuffle_window();
+  shuffle_window_ = value;
+}
+
+// optional string quantization_file = 48;
+inline bool LayerParameter::has_quantization_file() const {
+  return (_has_bits_[1] & 0x00008000u) != 0;
+}
+inline void LayerParameter::set_has_quantization_file() {
+  _has_bits_[1] |= 0x00008000u;
+}
+inline void LayerParameter::clear_has_quantization_file() {
+  _has_bits_[1] &= ~0x00008000u;
+}
+inline void LayerParameter::clear_quantization_file() {
+  if (quantization_file_ != &::google::protobuf::internal::kEmptyString) {
+    quantization_file_->clear();
+  }
+  clear_has_quantization_file();
+}
+inline const ::std::string& LayerParameter::quantization_file() const {
+  return *quantization_file_;
+}
+inline void LayerParameter::set_quantization_file(const ::std::string& value) {
+  set_has_quantization_file();
+  if (quantization_file_ == &::google::protobuf::internal::kEmptyString) {
+    quantization_file_ = new ::std::string;
+  }
+  quantization_file_->assign(value);
+}
+inline void LayerParameter::set_quantization_file(const char* value) {
+  set_has_quantization_file();
+  if (quantization_file_ == &::google::protobuf::internal::kEmptyString) {
+    quantization_file_ = new ::std::string;
+  }
+  quantization_file_->assign(value);
+}
+inline void LayerParameter::set_quantization_file(const char* value, size_t size) {
+  set_has_quantization_file();
+  if (quantization_file_ == &::google::protobuf::internal::kEmptyString) {
+    quantization_file_ = new ::std::string;
+  }
+  quantization_file_->assign(reinterpret_cast<const char*>(value), size);
+}
+inline ::std::string* LayerParameter::mutable_quantization_file() {
+  set_has_quantization_file();
+  if (quantization_file_ == &::google::protobuf::internal::kEmptyString) {
+    quantization_file_ = new ::std::string;
+  }
+  return quantization_file_;
+}
+inline ::std::string* LayerParameter::release_quantization_file() {
+  clear_has_quantization_file();
+  if (quantization_file_ == &::google::protobuf::internal::kEmptyString) {
+    return NULL;
+  } else {
+    ::std::string* temp = quantization_file_;
+    quantization_file_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+    return temp;
+  }
+}
+inline void LayerParameter::set_allocated_quantization_file(::std::string* quantization_file) {
+  if (quantization_file_ != &::google::protobuf::internal::kEmptyString) {
+    delete quantization_file_;
+  }
+  if (quantization_file) {
+    set_has_quantization_file();
+    quantization_file_ = quantization_file;
+  } else {
+    clear_has_quantization_file();
+    quantization_file_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+  }
+}
+
+// optional bool in_memory = 49 [default = false];
+inline bool LayerParameter::has_in_memory() const {
+  return (_has_bits_[1] & 0x00010000u) != 0;
+}
+inline void LayerParameter::set_has_in_memory() {
+  _has_bits_[1] |= 0x00010000u;
+}
+inline void LayerParameter::clear_has_in_memory() {
+  _has_bits_[1] &= ~0x00010000u;
+}
+inline void LayerParameter::clear_in_memory() {
+  in_memory_ = false;
+  clear_has_in_memory();
+}
+inline bool LayerParameter::in_memory() const {
+  return in_memory_;
+}
+inline void LayerParameter::set_in_memory(bool value) {
+  set_has_in_memory();
+  in_memory_ = value;
+}
+
+// optional .caffe.LayerParameter.ShardOrder shard_order = 55 [default = ROUND_ROBIN];
+inline bool LayerParameter::has_shard_order() const {
+  return (_has_bits_[1] & 0x00020000u) != 0;
+}
+inline void LayerParameter::set_has_shard_order() {
+  _has_bits_[1] |= 0x00020000u;
+}
+inline void LayerParameter::clear_has_shard_order() {
+  _has_bits_[1] &= ~0x00020000u;
+}
+inline void LayerParameter::clear_shard_order() {
+  shard_order_ = 0;
+  clear_has_shard_order();
+}
+inline ::caffe::LayerParameter_ShardOrder LayerParameter::shard_order() const {
+  return static_cast< ::caffe::LayerParameter_ShardOrder >(shard_order_);
+}
+inline void LayerParameter::set_shard_order(::caffe::LayerParameter_ShardOrder value) {
+  assert(::caffe::LayerParameter_ShardOrder_IsValid(value));
+  set_has_shard_order();
+  shard_order_ = value;
+}
+
+// optional bool streaming = 56 [default = false];
+inline bool LayerParameter::has_streaming() const {
+  return (_has_bits_[1] & 0x00040000u) != 0;
+}
+inline void LayerParameter::set_has_streaming() {
+  _has_bits_[1] |= 0x00040000u;
+}
+inline void LayerParameter::clear_has_streaming() {
+  _has_bits_[1] &= ~0x00040000u;
+}
+inline void LayerParameter::clear_streaming() {
+  streaming_ = false;
+  clear_has_streaming();
+}
+inline bool LayerParameter::streaming() const {
+  return streaming_;
+}
+inline void LayerParameter::set_streaming(bool value) {
+  set_has_streaming();
+  streaming_ = value;
+}
+
+// optional uint32 stream_chunk_kb = 57 [default = 65536];
+inline bool LayerParameter::has_stream_chunk_kb() const {
+  return (_has_bits_[1] & 0x00080000u) != 0;
+}
+inline void LayerParameter::set_has_stream_chunk_kb() {
+  _has_bits_[1] |= 0x00080000u;
+}
+inline void LayerParameter::clear_has_stream_chunk_kb() {
+  _has_bits_[1] &= ~0x00080000u;
+}
+inline void LayerParameter::clear_stream_chunk_kb() {
+  stream_chunk_kb_ = 65536u;
+  clear_has_stream_chunk_kb();
+}
+inline ::google::protobuf::uint32 LayerParameter::stream_chunk_kb() const {
+  return stream_chunk_kb_;
+}
+inline void LayerParameter::set_stream_chunk_kb(::google::protobuf::uint32 value) {
+  set_has_stream_chunk_kb();
+  stream_chunk_kb_ = value;
+}
+
+// optional bool in_memory_if_supported = 58 [default = false];
+inline bool LayerParameter::has_in_memory_if_supported() const {
+  return (_has_bits_[1] & 0x00100000u) != 0;
+}
+inline void LayerParameter::set_has_in_memory_if_supported() {
+  _has_bits_[1] |= 0x00100000u;
+}
+inline void LayerParameter::clear_has_in_memory_if_supported() {
+  _has_bits_[1] &= ~0x00100000u;
+}
+inline void LayerParameter::clear_in_memory_if_supported() {
+  in_memory_if_supported_ = false;
+  clear_has_in_memory_if_supported();
+}
+inline bool LayerParameter::in_memory_if_supported() const {
+  return in_memory_if_supported_;
+}
+inline void LayerParameter::set_in_memory_if_supported(bool value) {
+  set_has_in_memory_if_supported();
+  in_memory_if_supported_ = value;
+}
+
+// optional bool query_padding = 59 [default = false];
+inline bool LayerParameter::has_query_padding() const {
+  return (_has_bits_[1] & 0x00200000u) != 0;
+}
+inline void LayerParameter::set_has_query_padding() {
+  _has_bits_[1] |= 0x00200000u;
+}
+inline void LayerParameter::clear_has_query_padding() {
+  _has_bits_[1] &= ~0x00200000u;
+}
+inline void LayerParameter::clear_query_padding() {
+  query_padding_ = false;
+  clear_has_query_padding();
+}
+inline bool LayerParameter::query_padding() const {
+  return query_padding_;
+}
+inline void LayerParameter::set_query_padding(bool value) {
+  set_has_query_padding();
+  query_padding_ = value;
+}
+
 // repeated .caffe.BlobProto blobs = 50;
 inline int LayerParameter::blobs_size() const {
   return blobs_.size();
@@ -4459,13 +5574,13 @@ LayerParameter::mutable_weight_decay() {
 
 // optional uint32 rand_skip = 53 [default = 0];
 inline bool LayerParameter::has_rand_skip() const {
-  return (_has_bits_[1] & 0x00000200u) != 0;
+  return (_has_bits_[1] & 0x02000000u) != 0;
 }
 inline void LayerParameter::set_has_rand_skip() {
-  _has_bits_[1] |= 0x00000200u;
+  _has_bits_[1] |= 0x02000000u;
 }
 inline void LayerParameter::clear_has_rand_skip() {
-  _has_bits_[1] &= ~0x00000200u;
+  _has_bits_[1] &= ~0x02000000u;
 }
 inline void LayerParameter::clear_rand_skip() {
   rand_skip_ = 0u;
@@ -5438,6 +6553,28 @@ inline void SolverParameter::set_cal_2nd_grad(bool value) {
   cal_2nd_grad_ = value;
 }
 
+// optional bool test_data_in_memory = 20 [default = false];
+inline bool SolverParameter::has_test_data_in_memory() const {
+  return (_has_bits_[0] & 0x00080000u) != 0;
+}
+inline void SolverParameter::set_has_test_data_in_memory() {
+  _has_bits_[0] |= 0x00080000u;
+}
+inline void SolverParameter::clear_has_test_data_in_memory() {
+  _has_bits_[0] &= ~0x00080000u;
+}
+inline void SolverParameter::clear_test_data_in_memory() {
+  test_data_in_memory_ = false;
+  clear_has_test_data_in_memory();
+}
+inline bool SolverParameter::test_data_in_memory() const {
+  return test_data_in_memory_;
+}
+inline void SolverParameter::set_test_data_in_memory(bool value) {
+  set_has_test_data_in_memory();
+  test_data_in_memory_ = value;
+}
+
 // -------------------------------------------------------------------
 
 // SolverState
@@ -5572,6 +6709,14 @@ template <>
 inline const EnumDescriptor* GetEnumDescriptor< ::caffe::LayerParameter_PoolMethod>() {
   return ::caffe::LayerParameter_PoolMethod_descriptor();
 }
+template <>
+inline const EnumDescriptor* GetEnumDescriptor< ::caffe::LayerParameter_DataSource>() {
+  return ::caffe::LayerParameter_DataSource_descriptor();
+}
+template <>
+inline const EnumDescriptor* GetEnumDescriptor< ::caffe::LayerParameter_ShardOrder>() {
+  return ::caffe::LayerParameter_ShardOrder_descriptor();
+}
 
 }  // namespace google
 }  // namespace protobuf
@@ -11,12 +11,26 @@
 #include "caffe/solver.hpp"
 #include "caffe/util/io.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/vision_layers.hpp"
 
 using std::max;
 using std::min;
 
 namespace caffe {
 
+// Asks the data layers of a test net to keep their data in memory, so that
+// every test pass after the first costs only the forward computation. A
+// layer whose settings or source in_memory does not support reads its source
+// at every test instead.
+static void SetTestDataInMemory(NetParameter* net_param) {
+  for (int i = 0; i < net_param->layers_size(); ++i) {
+    LayerParameter* layer = net_param->mutable_layers(i)->mutable_layer();
+    if (layer->type() == "data" && !layer->in_memory()) {
+      layer->set_in_memory_if_supported(true);
+    }
+  }
+}
+
 template <typename Dtype>
 Solver<Dtype>::Solver(const SolverParameter& param)
     : param_(param), net_(), test_net_() {
@@ -29,6 +43,9 @@ Solver<Dtype>::Solver(const SolverParameter& param)
     LOG(INFO) << "Creating testing net.";
     NetParameter test_net_param;
     ReadProtoFromTextFile(param_.test_net(), &test_net_param);
+    if (param_.test_data_in_memory()) {
+      SetTestDataInMemory(&test_net_param);
+    }
     test_net_.reset(new Net<Dtype>(test_net_param));
     CHECK_GT(param_.test_iter(), 0);
     CHECK_GT(param_.test_interval(), 0);
@@ -37,6 +54,29 @@ Solver<Dtype>::Solver(const SolverParameter& param)
 }
 
 
+// Logs what every data layer of a net did since the last call. A layer that
+// spends a large share of the time waiting keeps the solver I/O-bound.
+template <typename Dtype>
+static void LogDataLayerStats(Net<Dtype>* net) {
+  const vector<shared_ptr<Layer<Dtype> > >& layers = net->layers();
+  for (int i = 0; i < layers.size(); ++i) {
+    DataLayer<Dtype>* layer = dynamic_cast<DataLayer<Dtype>*>(layers[i].get());
+    if (layer == NULL) {
+      continue;
+    }
+    const DataLayerStats stats = layer->stats();
+    layer->ResetStats();
+    const double elapsed = std::max(stats.elapsed_seconds, 1e-9);
+    LOG(INFO) << "Data layer " << net->layer_names()[i] << ": waited "
+        << stats.wait_seconds << " s (" << 100 * stats.wait_seconds / elapsed
+        << "%), " << stats.records / elapsed << " records/s, "
+        << stats.bytes / elapsed / 1048576 << " MB/s; read "
+        << stats.read_seconds << " s, parse " << stats.parse_seconds
+        << " s, normalize " << stats.normalize_seconds << " s, copy "
+        << stats.copy_seconds << " s";
+  }
+}
+
 template <typename Dtype>
 void Solver<Dtype>::Solve(const char* resume_file) {
   Caffe::set_mode(Caffe::Brew(param_.solver_mode()));
@@ -63,6 +103,7 @@ void Solver<Dtype>::Solve(const char* resume_file) {
 
     if (param_.display() && iter_ % param_.display() == 0) {
       LOG(INFO) << "Iteration " << iter_ << ", loss = " << loss;
+      LogDataLayerStats(net_.get());
     }
     if (param_.test_interval() && iter_ % param_.test_interval() == 0) {
       // We need to set phase to test before running.
@@ -140,11 +181,9 @@ void Solver<Dtype>::Snapshot() {
 template <typename Dtype>
 void Solver<Dtype>::Restore(const char* state_file) {
   SolverState state;
-  NetParameter net_param;
   ReadProtoFromBinaryFile(state_file, &state);
   if (state.has_learned_net()) {
-    ReadProtoFromBinaryFile(state.learned_net().c_str(), &net_param);
-    net_->CopyTrainedLayersFrom(net_param);
+    net_->CopyTrainedLayersFrom(state.learned_net());
   }
   iter_ = state.iter();
   RestoreSolverState(state);
@@ -214,6 +253,23 @@ void SGDSolver<Dtype>::ComputeUpdateValue() {
       // Compute the value to history, and then copy them to the blob's diff.
       Dtype local_rate = rate * net_params_lr[param_id];
       Dtype local_decay = weight_decay * net_params_weight_decay[param_id];
+      const vector<int>* columns = net_params[param_id]->diff_columns();
+      if (columns != NULL && momentum == 0 && local_decay == 0 &&
+          !this->param_.cal_2nd_grad()) {
+        // Only the columns with a gradient move, so the update can skip
+        // the rest of the weights.
+        Dtype* param_diff = net_params[param_id]->mutable_cpu_diff();
+        const int width = net_params[param_id]->width();
+        const int rows = net_params[param_id]->count() / width;
+        for (int j = 0; j < columns->size(); ++j) {
+          for (int r = 0; r < rows; ++r) {
+            param_diff[r * width + (*columns)[j]] *= local_rate;
+          }
+        }
+        continue;
+      }
+      // Momentum and weight decay reach every weight.
+      net_params[param_id]->clear_diff_columns();
       caffe_axpby(net_params[param_id]->count(), local_rate,
           net_params[param_id]->cpu_diff(), momentum,
           history_[param_id]->mutable_cpu_data());
@@ -57,4 +57,32 @@ TYPED_TEST(BlobSimpleTest, TestReshape) {
   EXPECT_EQ(this->blob_->count(), 120);
 }
 
+TYPED_TEST(BlobSimpleTest, TestShareData) {
+  Blob<TypeParam> other(2, 3, 4, 5);
+  other.mutable_cpu_data()[7] = 3;
+  this->blob_preshaped_->ShareData(other);
+  EXPECT_EQ(this->blob_preshaped_->cpu_data(), other.cpu_data());
+  EXPECT_EQ(this->blob_preshaped_->cpu_data()[7], 3);
+}
+
+TYPED_TEST(BlobSimpleTest, TestReshapeSparse) {
+  this->blob_->ReshapeSparse(4, 1000, 6);
+  EXPECT_TRUE(this->blob_->sparse());
+  EXPECT_EQ(this->blob_->num(), 4);
+  EXPECT_EQ(this->blob_->channels(), 1000);
+  EXPECT_EQ(this->blob_->count(), 4000);
+  EXPECT_EQ(this->blob_->nnz(), 6);
+  EXPECT_TRUE(this->blob_->mutable_cpu_sparse_values());
+  EXPECT_TRUE(this->blob_->mutable_cpu_sparse_indices());
+  EXPECT_TRUE(this->blob_->mutable_cpu_sparse_ptr());
+  // Shrinking keeps the buffers.
+  const TypeParam* values = this->blob_->cpu_sparse_values();
+  this->blob_->ReshapeSparse(4, 1000, 3);
+  EXPECT_EQ(this->blob_->nnz(), 3);
+  EXPECT_EQ(this->blob_->cpu_sparse_values(), values);
+  this->blob_->Reshape(2, 3, 4, 5);
+  EXPECT_FALSE(this->blob_->sparse());
+  EXPECT_EQ(this->blob_->count(), 120);
+}
+
 }
@@ -72,4 +72,32 @@ TEST_F(CommonTest, TestRandSeedGPU) {
 }
 
 
+TEST_F(CommonTest, TestPhilox) {
+  // Known answers of Philox4x32-10 from the Random123 distribution
+  const uint32_t zero[4] = {0, 0, 0, 0};
+  const uint32_t ones[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+  const uint32_t expected_zero[4] =
+      {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+  const uint32_t expected_ones[4] =
+      {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd};
+  uint32_t out[4];
+  philox4x32(zero, zero, out);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(expected_zero[i], out[i]);
+  }
+  philox4x32(ones, ones, out);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(expected_ones[i], out[i]);
+  }
+}
+
+TEST_F(CommonTest, TestRngStreams) {
+  Caffe::set_random_seed(1701);
+  EXPECT_EQ(1701, Caffe::rng_seed());
+  EXPECT_EQ(0, Caffe::NewRngStream());
+  EXPECT_EQ(1, Caffe::NewRngStream());
+  Caffe::set_random_seed(1701);
+  EXPECT_EQ(0, Caffe::NewRngStream());
+}
+
 }  // namespace caffe
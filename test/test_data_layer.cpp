@@ -2,8 +2,15 @@
 
 #include <cuda_runtime.h>
 #include <leveldb/db.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
 
+#include <algorithm>
+#include <functional>
+#include <set>
 #include <string>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 
@@ -13,10 +20,13 @@
 #include "caffe/filler.hpp"
 #include "caffe/vision_layers.hpp"
 #include "caffe/proto/caffe.pb.h"
+#include "caffe/util/dequantize.hpp"
+#include "caffe/util/io.hpp"
 #include "caffe/test/test_caffe_main.hpp"
 
 using std::string;
 using std::stringstream;
+using google::protobuf::internal::WireFormatLite;
 
 namespace caffe {
 
@@ -38,13 +48,7 @@ class DataLayerTest : public ::testing::Test {
 	sprintf(file_path,"../tmp/%s",tmpnam(NULL));// get temp name
     filename = file_path; 
     LOG(INFO) << "Using temporary leveldb " << filename;
-    leveldb::DB* db;
-    leveldb::Options options;
-    options.error_if_exists = true;
-    options.create_if_missing = true;
-    leveldb::Status status = leveldb::DB::Open(options, filename, &db);
-    CHECK(status.ok());
-    for (int i = 0; i < 5; ++i) {
+    WriteLeveldb(filename, 5, [](int i) {
       Datum datum;
       datum.set_label(i);
       datum.set_channels(2);
@@ -54,12 +58,86 @@ class DataLayerTest : public ::testing::Test {
       for (int j = 0; j < 24; ++j) {
         data->push_back((uint8_t)i);
       }
+      return datum.SerializeAsString();
+    });
+  };
+
+  // Removes the leveldbs the test wrote. The layers reading them are gone by
+  // now and no longer hold their locks.
+  virtual void TearDown() {
+    for (int i = 0; i < leveldbs_.size(); ++i) {
+      leveldb::DestroyDB(leveldbs_[i], leveldb::Options());
+    }
+  }
+
+  // Writes a new leveldb of num records, record i under the zero padded key
+  // i with the value value_fn(i). It is compacted into a table, so that its
+  // size on disk is known, and destroyed at the end of the test.
+  void WriteLeveldb(const string& name, const int num,
+      const std::function<string(int)>& value_fn) {
+    leveldb::DB* db;
+    leveldb::Options options;
+    options.error_if_exists = true;
+    options.create_if_missing = true;
+    CHECK(leveldb::DB::Open(options, name, &db).ok());
+    leveldbs_.push_back(name);
+    for (int i = 0; i < num; ++i) {
       stringstream ss;
-      ss << i;
-      db->Put(leveldb::WriteOptions(), ss.str(), datum.SerializeAsString());
+      ss << std::setw(8) << std::setfill('0') << i;
+      db->Put(leveldb::WriteOptions(), ss.str(), value_fn(i));
     }
+    db->CompactRange(NULL, NULL);
     delete db;
-  };
+  }
+
+  // Writes num records like the ones of the leveldb to a dense dataset, in
+  // two groups {7: 0-1, 9: 2-}, with the features stored as feature_type.
+  void WriteDenseDataset(const string& dense_filename,
+      const uint32_t feature_type = DENSE_FLOAT32, const int num = 5) {
+    DenseDatasetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kDenseDatasetMagic, sizeof(header.magic));
+    header.num = num;
+    header.channels = 2;
+    header.height = 3;
+    header.width = 4;
+    header.label_dim = 1;
+    header.num_groups = 2;
+    header.feature_type = feature_type;
+    header.feature_offset = sizeof(header);
+    const size_t feature_bytes = num * 24 * DenseFeatureBytes(header);
+    header.label_offset = header.feature_offset + feature_bytes;
+    header.group_id_offset = header.label_offset + num * sizeof(float);
+    header.group_offset = header.group_id_offset + 2 * sizeof(int32_t);
+    vector<float> features(num * 24);
+    vector<uint8_t> bytes(num * 24);
+    vector<uint16_t> halves(num * 24);
+    vector<float> labels(num);
+    for (int i = 0; i < num; ++i) {
+      labels[i] = i;
+      for (int j = 0; j < 24; ++j) {
+        features[i * 24 + j] = i;
+        bytes[i * 24 + j] = i;
+        halves[i * 24 + j] = caffe_float_to_half(i);
+      }
+    }
+    int32_t group_ids[2] = {7, 9};
+    uint32_t group_offsets[3] = {0, 2, static_cast<uint32_t>(num)};
+    FILE* file = fopen(dense_filename.c_str(), "wb");
+    CHECK(file);
+    fwrite(&header, sizeof(header), 1, file);
+    if (feature_type == DENSE_UINT8) {
+      fwrite(&bytes[0], feature_bytes, 1, file);
+    } else if (feature_type == DENSE_FLOAT16) {
+      fwrite(&halves[0], feature_bytes, 1, file);
+    } else {
+      fwrite(&features[0], feature_bytes, 1, file);
+    }
+    fwrite(&labels[0], sizeof(float) * num, 1, file);
+    fwrite(group_ids, sizeof(group_ids), 1, file);
+    fwrite(group_offsets, sizeof(group_offsets), 1, file);
+    fclose(file);
+  }
 
   virtual ~DataLayerTest() { delete blob_top_data_; delete blob_top_label_; }
 
@@ -68,6 +146,7 @@ class DataLayerTest : public ::testing::Test {
   Blob<Dtype>* const blob_top_label_;
   vector<Blob<Dtype>*> blob_bottom_vec_;
   vector<Blob<Dtype>*> blob_top_vec_;
+  vector<string> leveldbs_;
 };
 
 typedef ::testing::Types<float, double> Dtypes;
@@ -102,4 +181,736 @@ TYPED_TEST(DataLayerTest, TestRead) {
   }
 }
 
+TYPED_TEST(DataLayerTest, TestReadPrefetchRing) {
+  LayerParameter param;
+  param.set_batchsize(2);
+  param.set_source(this->filename);
+  param.set_random_jump(false);
+  param.set_prefetch_count(4);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  EXPECT_EQ(this->blob_top_data_->num(), 2);
+  EXPECT_EQ(this->blob_top_label_->num(), 2);
+  // The batches should walk through the 5 records in order and wrap around
+  int expected = 0;
+  for (int iter = 0; iter < 20; ++iter) {
+    layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_EQ(expected, this->blob_top_label_->cpu_data()[i]);
+      for (int j = 0; j < 24; ++j) {
+        EXPECT_EQ(expected, this->blob_top_data_->cpu_data()[i * 24 + j])
+            << "debug: iter " << iter << " i " << i << " j " << j;
+      }
+      expected = (expected + 1) % 5;
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadOnce) {
+  LayerParameter param;
+  param.set_batchsize(2);
+  param.set_source(this->filename);
+  param.set_random_jump(false);
+  param.set_batch_read(false);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  // Without batch_read the first batch is served on every iteration
+  for (int iter = 0; iter < 5; ++iter) {
+    layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_EQ(i, this->blob_top_label_->cpu_data()[i]);
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadZeroCopy) {
+  LayerParameter param;
+  param.set_batchsize(2);
+  param.set_source(this->filename);
+  param.set_random_jump(false);
+  param.set_zero_copy(true);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  int expected = 0;
+  for (int iter = 0; iter < 20; ++iter) {
+    layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_EQ(expected, this->blob_top_label_->cpu_data()[i]);
+      for (int j = 0; j < 24; ++j) {
+        EXPECT_EQ(expected, this->blob_top_data_->cpu_data()[i * 24 + j])
+            << "debug: iter " << iter << " i " << i << " j " << j;
+      }
+      expected = (expected + 1) % 5;
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadDecodeThreads) {
+  LayerParameter param;
+  param.set_batchsize(5);
+  param.set_source(this->filename);
+  param.set_random_jump(false);
+  param.set_decode_threads(3);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  for (int iter = 0; iter < 20; ++iter) {
+    layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_EQ(i, this->blob_top_label_->cpu_data()[i]);
+      for (int j = 0; j < 24; ++j) {
+        EXPECT_EQ(i, this->blob_top_data_->cpu_data()[i * 24 + j])
+            << "debug: iter " << iter << " i " << i << " j " << j;
+      }
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadDense) {
+  string dense_filename = string(this->filename) + ".dense";
+  this->WriteDenseDataset(dense_filename);
+
+  Blob<TypeParam> blob_top_qid;
+  this->blob_top_vec_.push_back(&blob_top_qid);
+  LayerParameter param;
+  param.set_batchsize(3);
+  param.set_source(dense_filename);
+  param.set_source_type(LayerParameter_DataSource_DENSE);
+  param.set_random_jump(false);
+  {
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    EXPECT_EQ(this->blob_top_data_->num(), 3);
+    EXPECT_EQ(this->blob_top_data_->channels(), 2);
+    EXPECT_EQ(this->blob_top_data_->height(), 3);
+    EXPECT_EQ(this->blob_top_data_->width(), 4);
+    for (int iter = 0; iter < 10; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int i = 0; i < 3; ++i) {
+        const int record = (iter * 3 + i) % 5;
+        EXPECT_EQ(record, this->blob_top_label_->cpu_data()[i]);
+        EXPECT_EQ(record < 2 ? 7 : 9, blob_top_qid.cpu_data()[i]);
+        for (int j = 0; j < 24; ++j) {
+          EXPECT_EQ(record, this->blob_top_data_->cpu_data()[i * 24 + j])
+              << "debug: iter " << iter << " i " << i << " j " << j;
+        }
+      }
+    }
+  }
+  // A scaled read takes the normalizing path.
+  param.set_scale(0.5);
+  param.set_decode_threads(2);
+  {
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int iter = 0; iter < 10; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int i = 0; i < 3; ++i) {
+        const int record = (iter * 3 + i) % 5;
+        EXPECT_EQ(record, this->blob_top_label_->cpu_data()[i]);
+        for (int j = 0; j < 24; ++j) {
+          EXPECT_EQ(record * 0.5, this->blob_top_data_->cpu_data()[i * 24 + j]);
+        }
+      }
+    }
+  }
+  remove(dense_filename.c_str());
+}
+
+TYPED_TEST(DataLayerTest, TestReadSparse) {
+  // Record i has the i + 1 nonzeros (10 * j + i, j) for j = 1 ... i + 1.
+  string sparse_filename = string(this->filename) + "_sparse";
+  this->WriteLeveldb(sparse_filename, 5, [](int i) {
+    Datum datum;
+    datum.set_label(i);
+    datum.set_sparse_dim(100);
+    for (int j = 1; j <= i + 1; ++j) {
+      datum.add_sparse_index(10 * j + i);
+      datum.add_sparse_value(j);
+    }
+    return datum.SerializeAsString();
+  });
+
+  LayerParameter param;
+  param.set_batchsize(3);
+  param.set_source(sparse_filename);
+  param.set_random_jump(false);
+  param.set_scale(2);
+  // in_memory_if_supported reads a sparse source as usual.
+  for (int if_supported = 0; if_supported < 2; ++if_supported) {
+    param.set_in_memory_if_supported(if_supported);
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    EXPECT_TRUE(this->blob_top_data_->sparse());
+    EXPECT_EQ(this->blob_top_data_->num(), 3);
+    EXPECT_EQ(this->blob_top_data_->channels(), 100);
+    for (int iter = 0; iter < 10; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      const int* ptr = this->blob_top_data_->cpu_sparse_ptr();
+      const int* indices = this->blob_top_data_->cpu_sparse_indices();
+      const TypeParam* values = this->blob_top_data_->cpu_sparse_values();
+      EXPECT_EQ(ptr[0], 0);
+      for (int i = 0; i < 3; ++i) {
+        const int record = (iter * 3 + i) % 5;
+        EXPECT_EQ(record, this->blob_top_label_->cpu_data()[i]);
+        ASSERT_EQ(ptr[i + 1] - ptr[i], record + 1);
+        for (int j = 1; j <= record + 1; ++j) {
+          EXPECT_EQ(indices[ptr[i] + j - 1], 10 * j + record);
+          EXPECT_EQ(values[ptr[i] + j - 1], 2 * j);
+        }
+      }
+      EXPECT_EQ(this->blob_top_data_->nnz(), ptr[3]);
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadQueryBatching) {
+  // Seven records in the queries {10: 0-2, 11: 3-4, 12: 5, 13: 6}.
+  const int group_ids[7] = {10, 10, 10, 11, 11, 12, 13};
+  string query_filename = string(this->filename) + "_query";
+  this->WriteLeveldb(query_filename, 7, [&](int i) {
+    Datum datum;
+    datum.set_label(i);
+    datum.set_group_id(group_ids[i]);
+    datum.set_channels(1);
+    datum.set_height(1);
+    datum.set_width(2);
+    datum.add_float_data(i);
+    datum.add_float_data(i);
+    return datum.SerializeAsString();
+  });
+
+  Blob<TypeParam> blob_top_qid;
+  Blob<TypeParam> blob_top_offsets;
+  this->blob_top_vec_.push_back(&blob_top_qid);
+  this->blob_top_vec_.push_back(&blob_top_offsets);
+  LayerParameter param;
+  param.set_batchsize(4);
+  param.set_source(query_filename);
+  param.set_random_jump(false);
+  param.set_query_batching(true);
+  param.set_decode_threads(2);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  EXPECT_EQ(blob_top_offsets.count(), 5);
+  // The second query does not fit after the first, so the batches alternate
+  // between these two.
+  const int records[2][4] = {{0, 1, 2, -1}, {3, 4, 5, 6}};
+  const int offsets[2][5] = {{0, 3, -1, -1, -1}, {0, 2, 3, 4, -1}};
+  for (int iter = 0; iter < 6; ++iter) {
+    layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int i = 0; i < 4; ++i) {
+      const int record = records[iter % 2][i];
+      const int qid = record < 0 ? -1 : group_ids[record];
+      const int value = record < 0 ? 0 : record;
+      EXPECT_EQ(qid, blob_top_qid.cpu_data()[i]);
+      EXPECT_EQ(value, this->blob_top_label_->cpu_data()[i]);
+      EXPECT_EQ(value, this->blob_top_data_->cpu_data()[i * 2]);
+      EXPECT_EQ(value, this->blob_top_data_->cpu_data()[i * 2 + 1]);
+    }
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_EQ(offsets[iter % 2][i], blob_top_offsets.cpu_data()[i])
+          << "debug: iter " << iter << " i " << i;
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadRandomJump) {
+  string index_filename = string(this->filename) + ".index";
+  LayerParameter param;
+  param.set_batchsize(3);
+  param.set_source(this->filename);
+  param.set_random_jump(true);
+  param.set_jump_index_stride(2);
+  param.set_jump_index_file(index_filename);
+  Caffe::set_phase(Caffe::TRAIN);
+  // The first layer writes the index and the second one reads it.
+  for (int pass = 0; pass < 2; ++pass) {
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    KeyIndex index;
+    ReadProtoFromBinaryFile(index_filename.c_str(), &index);
+    EXPECT_EQ(index.stride(), 2);
+    EXPECT_EQ(index.num_records(), 5);
+    ASSERT_EQ(index.keys_size(), 3);
+    EXPECT_EQ(index.keys(0), "00000000");
+    EXPECT_EQ(index.keys(1), "00000002");
+    EXPECT_EQ(index.keys(2), "00000004");
+    vector<int> seen(5, 0);
+    for (int iter = 0; iter < 50; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      // Every batch is a run of records that starts anywhere.
+      const int first = this->blob_top_label_->cpu_data()[0];
+      ++seen[first];
+      for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ((first + i) % 5, this->blob_top_label_->cpu_data()[i]);
+        EXPECT_EQ((first + i) % 5, this->blob_top_data_->cpu_data()[i * 24]);
+      }
+    }
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_GT(seen[i], 0) << "debug: record " << i << " never drawn";
+    }
+  }
+  remove(index_filename.c_str());
+}
+
+TYPED_TEST(DataLayerTest, TestReadShuffle) {
+  string dense_filename = string(this->filename) + ".dense";
+  this->WriteDenseDataset(dense_filename);
+  Caffe::set_phase(Caffe::TRAIN);
+  // A leveldb read in blocks of two records, two blocks at a time, and the
+  // dense dataset. With five records per batch every batch is one epoch.
+  for (int source = 0; source < 2; ++source) {
+    LayerParameter param;
+    param.set_batchsize(5);
+    param.set_shuffle(true);
+    if (source == 0) {
+      param.set_source(this->filename);
+      param.set_jump_index_stride(2);
+      param.set_shuffle_window(2);
+    } else {
+      param.set_source(dense_filename);
+      param.set_source_type(LayerParameter_DataSource_DENSE);
+    }
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    std::set<vector<int> > orders;
+    for (int iter = 0; iter < 20; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      vector<int> order(5);
+      for (int i = 0; i < 5; ++i) {
+        order[i] = this->blob_top_label_->cpu_data()[i];
+        EXPECT_EQ(order[i], this->blob_top_data_->cpu_data()[i * 24 + 23]);
+      }
+      orders.insert(order);
+      std::sort(order.begin(), order.end());
+      for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(i, order[i]) << "debug: source " << source << " iter "
+            << iter;
+      }
+    }
+    EXPECT_GT(orders.size(), 1);
+  }
+  remove(dense_filename.c_str());
+}
+
+TYPED_TEST(DataLayerTest, TestReadQuantized) {
+  // Feature j of record i, stored as uint8 i, stands for i * (j + 1) - j.
+  string quant_filename = string(this->filename) + ".quant";
+  BlobProto quantization;
+  quantization.set_num(2);
+  quantization.set_channels(2);
+  quantization.set_height(3);
+  quantization.set_width(4);
+  for (int j = 0; j < 24; ++j) {
+    quantization.add_data(j + 1);
+  }
+  for (int j = 0; j < 24; ++j) {
+    quantization.add_data(-j);
+  }
+  WriteProtoToBinaryFile(quantization, quant_filename);
+  string dense_filename = string(this->filename) + ".dense";
+  this->WriteDenseDataset(dense_filename, DENSE_UINT8);
+
+  LayerParameter param;
+  param.set_batchsize(3);
+  param.set_random_jump(false);
+  param.set_quantization_file(quant_filename);
+  param.set_scale(2);
+  for (int dense = 0; dense < 2; ++dense) {
+    param.set_source(dense ? dense_filename : string(this->filename));
+    param.set_source_type(dense ? LayerParameter_DataSource_DENSE :
+        LayerParameter_DataSource_LEVELDB);
+    param.set_decode_threads(dense + 1);
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int iter = 0; iter < 5; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int i = 0; i < 3; ++i) {
+        const int record = (iter * 3 + i) % 5;
+        EXPECT_EQ(record, this->blob_top_label_->cpu_data()[i]);
+        for (int j = 0; j < 24; ++j) {
+          EXPECT_EQ(2 * (record * (j + 1) - j),
+              this->blob_top_data_->cpu_data()[i * 24 + j])
+              << "debug: dense " << dense << " i " << i << " j " << j;
+        }
+      }
+    }
+  }
+  remove(quant_filename.c_str());
+  remove(dense_filename.c_str());
+
+  // Feature j of record i stored as fp16 i + j / 4
+  string half_filename = string(this->filename) + "_half";
+  this->WriteLeveldb(half_filename, 5, [](int i) {
+    Datum datum;
+    datum.set_label(i);
+    datum.set_channels(2);
+    datum.set_height(3);
+    datum.set_width(4);
+    string* data = datum.mutable_half_data();
+    for (int j = 0; j < 24; ++j) {
+      const uint16_t half = caffe_float_to_half(i + j / 4.f);
+      EXPECT_EQ(i + j / 4.f, caffe_half_to_float(half));
+      data->push_back(static_cast<char>(half & 0xff));
+      data->push_back(static_cast<char>(half >> 8));
+    }
+    return datum.SerializeAsString();
+  });
+  param.clear_quantization_file();
+  param.set_scale(1);
+  param.set_source(half_filename);
+  param.set_source_type(LayerParameter_DataSource_LEVELDB);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  for (int iter = 0; iter < 5; ++iter) {
+    layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int i = 0; i < 3; ++i) {
+      const int record = (iter * 3 + i) % 5;
+      for (int j = 0; j < 24; ++j) {
+        EXPECT_EQ(record + j / 4.,
+            this->blob_top_data_->cpu_data()[i * 24 + j]);
+      }
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadCropMirror) {
+  LayerParameter param;
+  param.set_batchsize(5);
+  param.set_source(this->filename);
+  param.set_random_jump(false);
+  param.set_cropsize(2);
+  param.set_mirror(true);
+  param.set_scale(3);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  EXPECT_EQ(this->blob_top_data_->num(), 5);
+  EXPECT_EQ(this->blob_top_data_->channels(), 2);
+  EXPECT_EQ(this->blob_top_data_->height(), 2);
+  EXPECT_EQ(this->blob_top_data_->width(), 2);
+  for (int iter = 0; iter < 3; ++iter) {
+    layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_EQ(i, this->blob_top_label_->cpu_data()[i]);
+      for (int j = 0; j < 8; ++j) {
+        EXPECT_EQ(3 * i, this->blob_top_data_->cpu_data()[i * 8 + j]);
+      }
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadInMemory) {
+  string dense_filename = string(this->filename) + ".dense";
+  this->WriteDenseDataset(dense_filename, DENSE_UINT8);
+
+  Blob<TypeParam> blob_top_qid;
+  this->blob_top_vec_.push_back(&blob_top_qid);
+  LayerParameter param;
+  param.set_batchsize(3);
+  param.set_random_jump(false);
+  param.set_scale(0.5);
+  param.set_decode_threads(2);
+  for (int dense = 0; dense < 2; ++dense) {
+    // in_memory_if_supported serves a dense leveldb from memory too.
+    param.set_in_memory(dense);
+    param.set_in_memory_if_supported(!dense);
+    param.set_source(dense ? dense_filename : string(this->filename));
+    param.set_source_type(dense ? LayerParameter_DataSource_DENSE :
+        LayerParameter_DataSource_LEVELDB);
+    // Sequential reads wrap around at the end.
+    param.set_shuffle(false);
+    {
+      DataLayer<TypeParam> layer(param);
+      layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int iter = 0; iter < 10; ++iter) {
+        layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+        for (int i = 0; i < 3; ++i) {
+          const int record = (iter * 3 + i) % 5;
+          EXPECT_EQ(record, this->blob_top_label_->cpu_data()[i]);
+          EXPECT_EQ(dense ? (record < 2 ? 7 : 9) : 0,
+              blob_top_qid.cpu_data()[i]);
+          for (int j = 0; j < 24; ++j) {
+            EXPECT_EQ(record * 0.5,
+                this->blob_top_data_->cpu_data()[i * 24 + j]);
+          }
+        }
+      }
+    }
+    // A shuffled epoch of batchsize 5 holds every record once.
+    param.set_shuffle(true);
+    param.set_batchsize(5);
+    {
+      DataLayer<TypeParam> layer(param);
+      layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int iter = 0; iter < 5; ++iter) {
+        layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+        std::set<int> records;
+        for (int i = 0; i < 5; ++i) {
+          const int record = this->blob_top_label_->cpu_data()[i];
+          records.insert(record);
+          EXPECT_EQ(record * 0.5, this->blob_top_data_->cpu_data()[i * 24]);
+        }
+        EXPECT_EQ(records.size(), 5);
+      }
+    }
+    param.set_batchsize(3);
+  }
+  remove(dense_filename.c_str());
+}
+
+TYPED_TEST(DataLayerTest, TestReadShards) {
+  // A second shard of 15 records labeled 100 + i, next to the fixture's 5
+  string shard_filename = string(this->filename) + "_shard1";
+  this->WriteLeveldb(shard_filename, 15, [](int i) {
+    Datum datum;
+    datum.set_label(100 + i);
+    datum.set_channels(2);
+    datum.set_height(3);
+    datum.set_width(4);
+    datum.mutable_data()->assign(24, static_cast<char>(i));
+    return datum.SerializeAsString();
+  });
+
+  LayerParameter param;
+  param.set_batchsize(5);
+  param.set_random_jump(false);
+  param.set_source(string(this->filename) + "," + this->filename + "_shard*");
+  {
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    EXPECT_EQ(this->blob_top_data_->num(), 5);
+    EXPECT_EQ(this->blob_top_data_->channels(), 2);
+    for (int iter = 0; iter < 6; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int i = 0; i < 5; ++i) {
+        const int label = iter % 2 ? 100 + (iter / 2 * 5 + i) % 15 : i;
+        EXPECT_EQ(label, this->blob_top_label_->cpu_data()[i]);
+      }
+    }
+  }
+  // By size the larger shard serves more batches.
+  param.set_shard_order(LayerParameter_ShardOrder_BY_SIZE);
+  {
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    int large = 0;
+    for (int iter = 0; iter < 20; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      const bool from_large = this->blob_top_label_->cpu_data()[0] >= 100;
+      for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(from_large, this->blob_top_label_->cpu_data()[i] >= 100);
+      }
+      large += from_large;
+    }
+    EXPECT_GT(large, 10);
+    EXPECT_LT(large, 20);
+  }
+  // Without batch_read the first batch of the first shard stays put.
+  param.set_shard_order(LayerParameter_ShardOrder_ROUND_ROBIN);
+  param.set_batch_read(false);
+  {
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int iter = 0; iter < 4; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(i, this->blob_top_label_->cpu_data()[i]);
+      }
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReadStreaming) {
+  // 300 records of 96 bytes span several 4 KB chunks.
+  string dense_filename = string(this->filename) + ".dense";
+  this->WriteDenseDataset(dense_filename, DENSE_FLOAT32, 300);
+
+  LayerParameter param;
+  param.set_batchsize(7);
+  param.set_source(dense_filename);
+  param.set_source_type(LayerParameter_DataSource_DENSE);
+  param.set_streaming(true);
+  param.set_stream_chunk_kb(4);
+  // The plain copy path, then the normalizing path
+  for (int scaled = 0; scaled < 2; ++scaled) {
+    param.set_scale(scaled ? 0.5 : 1);
+    param.set_decode_threads(scaled + 1);
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int iter = 0; iter < 100; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int i = 0; i < 7; ++i) {
+        const int record = (iter * 7 + i) % 300;
+        EXPECT_EQ(record, this->blob_top_label_->cpu_data()[i]);
+        for (int j = 0; j < 24; ++j) {
+          EXPECT_EQ(record * param.scale(),
+              this->blob_top_data_->cpu_data()[i * 24 + j]);
+        }
+      }
+    }
+  }
+  remove(dense_filename.c_str());
+
+  // A leveldb is read in order around the block cache.
+  param.set_batchsize(3);
+  param.set_source(this->filename);
+  param.set_source_type(LayerParameter_DataSource_LEVELDB);
+  param.set_random_jump(true);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  for (int iter = 0; iter < 10; ++iter) {
+    layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ((iter * 3 + i) % 5, this->blob_top_label_->cpu_data()[i]);
+    }
+  }
+}
+
+TYPED_TEST(DataLayerTest, TestReproducibleAugmentation) {
+  // Feature j of record i is 24 * i + j, so every crop and mirror differs.
+  string varied_filename = string(this->filename) + "_varied";
+  this->WriteLeveldb(varied_filename, 5, [](int i) {
+    Datum datum;
+    datum.set_label(i);
+    datum.set_channels(2);
+    datum.set_height(3);
+    datum.set_width(4);
+    std::string* data = datum.mutable_data();
+    for (int j = 0; j < 24; ++j) {
+      data->push_back((uint8_t)(24 * i + j));
+    }
+    return datum.SerializeAsString();
+  });
+
+  LayerParameter param;
+  param.set_batchsize(5);
+  param.set_source(varied_filename);
+  param.set_random_jump(false);
+  param.set_cropsize(2);
+  param.set_mirror(true);
+  param.set_jitter_rate(0.1);
+  // The same seed gives the same batches for any number of decode workers,
+  // and another seed gives other batches.
+  const int seeds[3] = {1701, 1701, 1702};
+  const int threads[3] = {1, 3, 1};
+  vector<vector<TypeParam> > outputs(3);
+  for (int run = 0; run < 3; ++run) {
+    Caffe::set_random_seed(seeds[run]);
+    param.set_decode_threads(threads[run]);
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int iter = 0; iter < 4; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      const TypeParam* data = this->blob_top_data_->cpu_data();
+      outputs[run].insert(outputs[run].end(), data,
+          data + this->blob_top_data_->count());
+    }
+  }
+  EXPECT_TRUE(outputs[0] == outputs[1]);
+  EXPECT_FALSE(outputs[0] == outputs[2]);
+}
+
+TYPED_TEST(DataLayerTest, TestStats) {
+  // Without batch_read exactly one batch is ever loaded.
+  LayerParameter param;
+  param.set_batchsize(5);
+  param.set_source(this->filename);
+  param.set_random_jump(false);
+  param.set_batch_read(false);
+  param.set_decode_threads(2);
+  DataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+  Datum datum;
+  datum.set_label(0);
+  datum.set_channels(2);
+  datum.set_height(3);
+  datum.set_width(4);
+  datum.set_data(string(24, 0));
+  DataLayerStats stats = layer.stats();
+  EXPECT_EQ(1, stats.batches);
+  EXPECT_EQ(5, stats.records);
+  EXPECT_EQ(5 * datum.ByteSize(), stats.bytes);
+  EXPECT_GE(stats.wait_seconds, 0);
+  EXPECT_GE(stats.read_seconds, 0);
+  EXPECT_GE(stats.parse_seconds, 0);
+  EXPECT_GE(stats.normalize_seconds, 0);
+  EXPECT_GE(stats.copy_seconds, 0);
+  EXPECT_GE(stats.elapsed_seconds, stats.wait_seconds);
+  layer.ResetStats();
+  stats = layer.stats();
+  EXPECT_EQ(0, stats.batches);
+  EXPECT_EQ(0, stats.records);
+  EXPECT_EQ(0, stats.bytes);
+  EXPECT_EQ(0, stats.wait_seconds);
+}
+
+TYPED_TEST(DataLayerTest, TestReadPackedFloats) {
+  // Feature j of record i is i + j / 8 and its regression target 2 * i. The
+  // odd records are written the way the unpacked fields used to be, one tag
+  // per value.
+  string float_filename = string(this->filename) + "_float";
+  this->WriteLeveldb(float_filename, 5, [](int i) {
+    string value;
+    if (i % 2 == 0) {
+      Datum datum;
+      datum.set_channels(2);
+      datum.set_height(3);
+      datum.set_width(4);
+      for (int j = 0; j < 24; ++j) {
+        datum.add_float_data(i + j / 8.f);
+      }
+      datum.add_float_label(2 * i);
+      datum.set_group_id(i < 2 ? 7 : 9);
+      value = datum.SerializeAsString();
+    } else {
+      google::protobuf::io::StringOutputStream stream(&value);
+      google::protobuf::io::CodedOutputStream output(&stream);
+      WireFormatLite::WriteInt32(Datum::kChannelsFieldNumber, 2, &output);
+      WireFormatLite::WriteInt32(Datum::kHeightFieldNumber, 3, &output);
+      WireFormatLite::WriteInt32(Datum::kWidthFieldNumber, 4, &output);
+      for (int j = 0; j < 24; ++j) {
+        WireFormatLite::WriteFloat(Datum::kFloatDataFieldNumber, i + j / 8.f,
+            &output);
+      }
+      WireFormatLite::WriteFloat(Datum::kFloatLabelFieldNumber, 2 * i,
+          &output);
+      WireFormatLite::WriteInt32(Datum::kGroupIdFieldNumber,
+          i < 2 ? 7 : 9, &output);
+    }
+    Datum datum;
+    EXPECT_TRUE(datum.ParseFromString(value));
+    EXPECT_EQ(24, datum.float_data_size());
+    return value;
+  });
+
+  Blob<TypeParam> blob_top_qid;
+  this->blob_top_vec_.push_back(&blob_top_qid);
+  LayerParameter param;
+  param.set_batchsize(3);
+  param.set_source(float_filename);
+  param.set_random_jump(false);
+  // Read as they are, then normalized by the parallel decode.
+  for (int scaled = 0; scaled < 2; ++scaled) {
+    SCOPED_TRACE(scaled ? "scaled on two decode threads" : "copied as is");
+    param.set_scale(scaled ? 0.5 : 1);
+    param.set_decode_threads(scaled + 1);
+    DataLayer<TypeParam> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, &this->blob_top_vec_);
+    for (int iter = 0; iter < 5; ++iter) {
+      layer.Forward(this->blob_bottom_vec_, &this->blob_top_vec_);
+      for (int i = 0; i < 3; ++i) {
+        const int record = (iter * 3 + i) % 5;
+        EXPECT_EQ(2 * record, this->blob_top_label_->cpu_data()[i]);
+        EXPECT_EQ(record < 2 ? 7 : 9, blob_top_qid.cpu_data()[i]);
+        for (int j = 0; j < 24; ++j) {
+          EXPECT_EQ((record + j / 8.) * (scaled ? 0.5 : 1),
+              this->blob_top_data_->cpu_data()[i * 24 + j]);
+        }
+      }
+    }
+  }
+}
+
 }
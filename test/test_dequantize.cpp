@@ -0,0 +1,213 @@
+#include <stdint.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+#include "gtest/gtest.h"
+#include "caffe/common.hpp"
+#include "caffe/util/dequantize.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+typedef ::testing::Types<float, double> Dtypes;
+
+static float FloatFromBits(const uint32_t bits) {
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static uint32_t BitsFromFloat(const float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+class HalfTest : public ::testing::Test {
+ protected:
+  HalfTest() : state_(1) {}
+
+  uint32_t Random() {
+    state_ = state_ * 1664525 + 1013904223;
+    return state_;
+  }
+
+  uint32_t state_;
+};
+
+TEST_F(HalfTest, TestHalfToFloat) {
+  EXPECT_EQ(0u, BitsFromFloat(caffe_half_to_float(0x0000)));
+  EXPECT_EQ(0x80000000u, BitsFromFloat(caffe_half_to_float(0x8000)));
+  EXPECT_EQ(1, caffe_half_to_float(0x3c00));
+  EXPECT_EQ(-2, caffe_half_to_float(0xc000));
+  EXPECT_EQ(65504, caffe_half_to_float(0x7bff));
+  EXPECT_EQ(std::ldexp(1.f, -14), caffe_half_to_float(0x0400));
+  EXPECT_EQ(std::ldexp(1.f, -24), caffe_half_to_float(0x0001));
+  EXPECT_EQ(std::ldexp(1023.f, -24), caffe_half_to_float(0x03ff));
+  EXPECT_TRUE(std::isinf(caffe_half_to_float(0x7c00)));
+  EXPECT_TRUE(std::isinf(caffe_half_to_float(0xfc00)));
+  for (int h = 0; h < 65536; ++h) {
+    const float f = caffe_half_to_float(h);
+    if ((h & 0x7c00) == 0x7c00 && (h & 0x3ff)) {
+      // A nan keeps its sign and payload, signaling or not. F16C quiets
+      // signaling nans, so they are not compared with it.
+      const uint32_t nan = static_cast<uint32_t>(h & 0x8000) << 16 |
+          0x7f800000 | static_cast<uint32_t>(h & 0x3ff) << 13;
+      EXPECT_EQ(nan, BitsFromFloat(f)) << "debug: h " << h;
+      continue;
+    }
+    // Every other half converts exactly and back.
+    EXPECT_EQ(h, caffe_float_to_half(f)) << "debug: h " << h;
+#ifdef __F16C__
+    EXPECT_EQ(BitsFromFloat(_cvtsh_ss(h)), BitsFromFloat(f))
+        << "debug: h " << h;
+#endif
+  }
+}
+
+TEST_F(HalfTest, TestFloatToHalf) {
+  EXPECT_EQ(0x3c00, caffe_float_to_half(1));
+  EXPECT_EQ(0x8000, caffe_float_to_half(-0.f));
+  // Halfway cases round to even.
+  EXPECT_EQ(0x3c00, caffe_float_to_half(1 + std::ldexp(1.f, -11)));
+  EXPECT_EQ(0x3c02, caffe_float_to_half(1 + 3 * std::ldexp(1.f, -11)));
+  EXPECT_EQ(0x0000, caffe_float_to_half(std::ldexp(1.f, -25)));
+  EXPECT_EQ(0x0002, caffe_float_to_half(3 * std::ldexp(1.f, -25)));
+  // Subnormal halves round to nearest too.
+  EXPECT_EQ(0x0001, caffe_float_to_half(std::ldexp(1.4f, -24)));
+  EXPECT_EQ(0x0002, caffe_float_to_half(std::ldexp(1.6f, -24)));
+  // Past the largest half is inf.
+  EXPECT_EQ(0x7bff, caffe_float_to_half(65519));
+  EXPECT_EQ(0x7c00, caffe_float_to_half(65520));
+  EXPECT_EQ(0xfc00, caffe_float_to_half(-1e10));
+  EXPECT_EQ(0x7c00, caffe_float_to_half(INFINITY));
+  EXPECT_EQ(0x7e00, caffe_float_to_half(NAN));
+  // Random floats of every exponent that a half reaches
+  for (int i = 0; i < 100000; ++i) {
+    const uint32_t bits = Random();
+    const int exponent = 100 + (bits >> 8) % 45;
+    const float f = FloatFromBits((bits & 0x807fffff) | exponent << 23);
+    const uint16_t h = caffe_float_to_half(f);
+    // The nearest half: neither neighbour lies closer to f.
+    const float back = caffe_half_to_float(h);
+    if (!std::isinf(back)) {
+      if (h & 0x7fff) {
+        const float smaller = caffe_half_to_float(h - 1);
+        EXPECT_LE(std::fabs(back - f), std::fabs(smaller - f)) << f;
+      }
+      if ((h & 0x7fff) != 0x7bff) {
+        const float larger = caffe_half_to_float(h + 1);
+        EXPECT_LE(std::fabs(back - f), std::fabs(larger - f)) << f;
+      }
+    }
+#ifdef __F16C__
+    EXPECT_EQ(_cvtss_sh(f, 0), h) << "debug: f " << f;
+#endif
+  }
+}
+
+template <typename Dtype>
+class DequantizeTest : public ::testing::Test {
+ protected:
+  DequantizeTest() : state_(1) {}
+
+  // A pseudo-random number in [0, 1)
+  float Uniform() {
+    state_ = state_ * 1664525 + 1013904223;
+    return (state_ >> 8) / 16777216.f;
+  }
+
+  // Random scales and shifts for n features
+  void MakeNormalization(const int n) {
+    scale_.resize(n);
+    shift_.resize(n);
+    for (int j = 0; j < n; ++j) {
+      scale_[j] = Uniform() * 4 - 2;
+      shift_[j] = Uniform() * 10 - 5;
+    }
+  }
+
+  uint32_t state_;
+  vector<Dtype> scale_;
+  vector<Dtype> shift_;
+};
+
+TYPED_TEST_CASE(DequantizeTest, Dtypes);
+
+// n is not a multiple of 8, so that the vector loops, where the build has
+// them, leave a tail to the scalar ones. Every feature is checked against a
+// call on it alone, which always takes the scalar path.
+const int kDequantizeFeatures = 8 * 5 + 5;
+
+TYPED_TEST(DequantizeTest, TestUint8) {
+  const int n = kDequantizeFeatures;
+  this->MakeNormalization(n);
+  vector<uint8_t> x(n);
+  for (int j = 0; j < n; ++j) {
+    x[j] = j == 0 ? 0 : j == 1 ? 255 : this->Uniform() * 256;
+  }
+  vector<TypeParam> y(n);
+  caffe_dequantize_uint8(n, &x[0], &this->scale_[0], &this->shift_[0],
+      &y[0]);
+  for (int j = 0; j < n; ++j) {
+    TypeParam scalar;
+    caffe_dequantize_uint8(1, &x[j], &this->scale_[j], &this->shift_[j],
+        &scalar);
+    EXPECT_NEAR(x[j] * this->scale_[j] + this->shift_[j], scalar, 1e-5);
+    EXPECT_FLOAT_EQ(scalar, y[j]) << "debug: j " << j;
+  }
+}
+
+TYPED_TEST(DequantizeTest, TestHalf) {
+  const int n = kDequantizeFeatures;
+  this->MakeNormalization(n);
+  vector<uint16_t> x(n);
+  for (int j = 0; j < n; ++j) {
+    x[j] = caffe_float_to_half((this->Uniform() - 0.5) * 1000);
+  }
+  // The extremes of the finite halves, and a subnormal
+  x[0] = 0x7bff;
+  x[1] = 0xfbff;
+  x[2] = 0x0001;
+  vector<TypeParam> y(n);
+  caffe_dequantize_half(n, &x[0], &this->scale_[0], &this->shift_[0],
+      &y[0]);
+  for (int j = 0; j < n; ++j) {
+    TypeParam scalar;
+    caffe_dequantize_half(1, &x[j], &this->scale_[j], &this->shift_[j],
+        &scalar);
+    const TypeParam expected =
+        caffe_half_to_float(x[j]) * this->scale_[j] + this->shift_[j];
+    EXPECT_NEAR(expected, scalar, 1e-6 * std::fabs(expected) + 1e-6);
+    EXPECT_FLOAT_EQ(scalar, y[j]) << "debug: j " << j;
+  }
+}
+
+TYPED_TEST(DequantizeTest, TestFloat) {
+  const int n = kDequantizeFeatures;
+  this->MakeNormalization(n);
+  vector<float> x(n);
+  for (int j = 0; j < n; ++j) {
+    x[j] = (this->Uniform() - 0.5) * 100;
+  }
+  vector<TypeParam> y(n);
+  caffe_dequantize_float(n, &x[0], &this->scale_[0], &this->shift_[0],
+      &y[0]);
+  for (int j = 0; j < n; ++j) {
+    TypeParam scalar;
+    caffe_dequantize_float(1, &x[j], &this->scale_[j], &this->shift_[j],
+        &scalar);
+    const TypeParam expected = x[j] * this->scale_[j] + this->shift_[j];
+    EXPECT_NEAR(expected, scalar, 1e-6 * std::fabs(expected) + 1e-6);
+    EXPECT_FLOAT_EQ(scalar, y[j]) << "debug: j " << j;
+  }
+}
+
+}  // namespace caffe
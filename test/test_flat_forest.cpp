@@ -0,0 +1,234 @@
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/compiled_forest.hpp"
+#include "caffe/util/flat_forest.hpp"
+#include "caffe/util/forest_to_cpp.hpp"
+#include "caffe/util/quick_scorer.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+typedef ::testing::Types<float, double> Dtypes;
+
+template <typename Dtype>
+class FlatForestTest : public ::testing::Test {
+ protected:
+  FlatForestTest() : state_(1) {}
+
+  // A pseudo-random number in [0, 1)
+  float Uniform() {
+    state_ = state_ * 1664525 + 1013904223;
+    return (state_ >> 8) / 16777216.f;
+  }
+
+  // Appends a random subtree of at most the given depth to tree, depth
+  // first, and returns the index of its root. A node is a leaf above that
+  // depth with probability stop.
+  int AddRandomTree(const int depth, const int dim, const float stop,
+      TreeProto* tree) {
+    const int index = tree->tree_nodes_size();
+    TreeNodeProto* node = tree->add_tree_nodes();
+    node->set_feature_split(0);
+    node->set_value_split(0);
+    node->set_leaf(true);
+    node->set_nsamples(1);
+    node->set_left_child(0);
+    node->set_right_child(0);
+    node->set_ini_error(0);
+    node->set_best_error(0);
+    node->set_pred(Uniform() - 0.5);
+    if (depth == 0 || Uniform() < stop) {
+      return index;
+    }
+    const int feature = Uniform() * dim;
+    // Thresholds on a grid that the features hit exactly now and then
+    const float threshold = static_cast<int>(Uniform() * 8) / 8.f;
+    const int left = AddRandomTree(depth - 1, dim, stop, tree);
+    const int right = AddRandomTree(depth - 1, dim, stop, tree);
+    node = tree->mutable_tree_nodes(index);
+    node->set_leaf(false);
+    node->set_feature_split(feature);
+    node->set_value_split(threshold);
+    node->set_left_child(left);
+    node->set_right_child(right);
+    return index;
+  }
+
+  void MakeForest(const int num_trees, const int depth, const int dim,
+      ForestProto* forest) {
+    forest->set_init_pred(0.25);
+    forest->set_dim(dim);
+    forest->set_learning_rate(0.1);
+    forest->set_max_depth(depth);
+    forest->set_min_leaf_n(1);
+    forest->set_rand_feat(1);
+    forest->set_rand_samp(1);
+    forest->set_min_obs(0);
+    forest->set_max_leaf_num(1 << depth);
+    for (int t = 0; t < num_trees; ++t) {
+      AddRandomTree(depth, dim, 0.2, forest->add_trees());
+    }
+  }
+
+  void MakeData(const int num, const int dim, vector<Dtype>* data) {
+    data->resize(num * dim);
+    for (int i = 0; i < num * dim; ++i) {
+      (*data)[i] = static_cast<int>(Uniform() * 16) / 16.;
+    }
+  }
+
+  // The score of a forest for the features x, walking the TreeProtos
+  Dtype PredictForest(const ForestProto& forest, const Dtype* x) {
+    float sum = 0;
+    for (int t = 0; t < forest.trees_size(); ++t) {
+      const TreeProto& tree = forest.trees(t);
+      int n = 0;
+      while (!tree.tree_nodes(n).leaf()) {
+        const TreeNodeProto& node = tree.tree_nodes(n);
+        n = x[node.feature_split()] <= node.value_split() ?
+            node.left_child() : node.right_child();
+      }
+      sum += tree.tree_nodes(n).pred();
+    }
+    return forest.init_pred() + forest.learning_rate() * sum;
+  }
+
+  uint32_t state_;
+};
+
+TYPED_TEST_CASE(FlatForestTest, Dtypes);
+
+TYPED_TEST(FlatForestTest, TestPredict) {
+  const int num = 150;
+  const int dim = 5;
+  ForestProto forest;
+  this->MakeForest(20, 6, dim, &forest);
+  vector<TypeParam> data;
+  this->MakeData(num, dim, &data);
+  FlatForest flat;
+  flat.Build(forest);
+  EXPECT_EQ(20, flat.num_trees());
+  EXPECT_EQ(12, sizeof(FlatTreeNode));
+  vector<TypeParam> out(num);
+  flat.Predict(&data[0], num, dim, &out[0]);
+  for (int i = 0; i < num; ++i) {
+    EXPECT_NEAR(this->PredictForest(forest, &data[i * dim]), out[i], 1e-5)
+        << "debug: i " << i;
+  }
+
+  // Trees added one at a time score the same.
+  FlatForest grown;
+  ForestProto first = forest;
+  first.clear_trees();
+  grown.Build(first);
+  for (int t = 0; t < forest.trees_size(); ++t) {
+    grown.AddTree(forest.trees(t));
+  }
+  vector<TypeParam> grown_out(num);
+  grown.Predict(&data[0], num, dim, &grown_out[0]);
+  for (int i = 0; i < num; ++i) {
+    EXPECT_EQ(out[i], grown_out[i]);
+  }
+}
+
+TYPED_TEST(FlatForestTest, TestQuickScorer) {
+  const int num = 150;
+  const int dim = 5;
+  ForestProto forest;
+  this->MakeForest(30, 6, dim, &forest);
+  // Full trees of 32 and 64 leaves fit in a bitvector, one of 128 does not.
+  this->AddRandomTree(5, dim, 0, forest.add_trees());
+  this->AddRandomTree(6, dim, 0, forest.add_trees());
+  this->AddRandomTree(7, dim, 0, forest.add_trees());
+  vector<TypeParam> data;
+  this->MakeData(num, dim, &data);
+  QuickScorer scorer;
+  scorer.Build(forest);
+  EXPECT_EQ(32, scorer.num_quick_trees());
+  EXPECT_EQ(1, scorer.num_large_trees());
+  vector<TypeParam> out(num);
+  scorer.Predict(&data[0], num, dim, &out[0]);
+  for (int i = 0; i < num; ++i) {
+    EXPECT_NEAR(this->PredictForest(forest, &data[i * dim]), out[i], 1e-5)
+        << "debug: i " << i;
+  }
+}
+
+#ifndef _WIN32
+TYPED_TEST(FlatForestTest, TestCompiledForest) {
+  const int num = 150;
+  const int dim = 5;
+  LayerParameter layer;
+  layer.set_name("forest");
+  this->MakeForest(30, 6, dim, layer.add_forests());
+  this->MakeForest(10, 3, dim, layer.add_forests());
+  char filename[256];
+  sprintf(filename, "../tmp/%s", tmpnam(NULL));
+  const string source = string(filename) + ".cpp";
+  const string library = string(filename) + ".so";
+  FILE* file = fopen(source.c_str(), "w");
+  ASSERT_TRUE(file != NULL);
+  WriteForests(file, "test", layer);
+  ASSERT_EQ(0, fclose(file));
+  const string command = "c++ -O1 -shared -fPIC " + source + " -o " + library;
+  const int status = system(command.c_str());
+  remove(source.c_str());
+  if (status != 0) {
+    LOG(ERROR) << "Skipping the test, cannot run " << command;
+    return;
+  }
+  CompiledForest compiled;
+  compiled.Load(library);
+  EXPECT_EQ(dim, compiled.num_features());
+  EXPECT_EQ(2, compiled.num_outputs());
+  // A compiled forest only scores float rows.
+  vector<TypeParam> typed_data;
+  this->MakeData(num, dim, &typed_data);
+  vector<float> data(typed_data.begin(), typed_data.end());
+  vector<float> out(num * 2);
+  compiled.Predict(&data[0], num, dim, &out[0]);
+  // The same float arithmetic as FlatForest, in the same order
+  for (int f = 0; f < 2; ++f) {
+    FlatForest flat;
+    flat.Build(layer.forests(f));
+    vector<float> flat_out(num);
+    flat.Predict(&data[0], num, dim, &flat_out[0]);
+    for (int i = 0; i < num; ++i) {
+      EXPECT_EQ(flat_out[i], out[i * 2 + f]) << "debug: f " << f << " i "
+          << i;
+    }
+  }
+
+  // score() is score_rows() for one row.
+  void* handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+  ASSERT_TRUE(handle != NULL);
+  typedef void (*ScoreFunction)(const float* x, float* out);
+  ScoreFunction score = reinterpret_cast<ScoreFunction>(
+      dlsym(handle, "score"));
+  ASSERT_TRUE(score != NULL);
+  float row_out[2];
+  for (int i = 0; i < num; ++i) {
+    score(&data[i * dim], row_out);
+    EXPECT_EQ(out[i * 2], row_out[0]);
+    EXPECT_EQ(out[i * 2 + 1], row_out[1]);
+  }
+  dlclose(handle);
+  compiled.Unload();
+  remove(library.c_str());
+}
+#endif
+
+}  // namespace caffe
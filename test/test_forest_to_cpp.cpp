@@ -0,0 +1,162 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/forest_to_cpp.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class ForestToCppTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    file_ = tmpfile();
+    ASSERT_TRUE(file_ != NULL);
+  }
+
+  virtual void TearDown() {
+    fclose(file_);
+  }
+
+  // Everything written to file_ so far
+  string Written() {
+    string text;
+    rewind(file_);
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file_)) > 0) {
+      text.append(buffer, size);
+    }
+    return text;
+  }
+
+  void SetLeaf(const float pred, TreeNodeProto* node) {
+    node->set_feature_split(0);
+    node->set_value_split(0);
+    node->set_leaf(true);
+    node->set_nsamples(1);
+    node->set_left_child(0);
+    node->set_right_child(0);
+    node->set_ini_error(0);
+    node->set_best_error(0);
+    node->set_pred(pred);
+  }
+
+  void SetSplit(const int feature, const float threshold, const int left,
+      const int right, TreeNodeProto* node) {
+    SetLeaf(0, node);
+    node->set_leaf(false);
+    node->set_feature_split(feature);
+    node->set_value_split(threshold);
+    node->set_left_child(left);
+    node->set_right_child(right);
+  }
+
+  // x[2] <= 0.25 ? 1.5 : (x[0] <= -1 ? 0.1 : -3), children after parents
+  void MakeTree(TreeProto* tree) {
+    SetSplit(2, 0.25, 1, 2, tree->add_tree_nodes());
+    SetLeaf(1.5, tree->add_tree_nodes());
+    SetSplit(0, -1, 3, 4, tree->add_tree_nodes());
+    SetLeaf(0.1, tree->add_tree_nodes());
+    SetLeaf(-3, tree->add_tree_nodes());
+  }
+
+  FILE* file_;
+};
+
+TEST_F(ForestToCppTest, TestFloatLiteral) {
+  EXPECT_EQ("1.f", FloatLiteral(1));
+  EXPECT_EQ("-3.f", FloatLiteral(-3));
+  EXPECT_EQ("0.f", FloatLiteral(0));
+  EXPECT_EQ("0.5f", FloatLiteral(0.5));
+  EXPECT_EQ("0.100000001f", FloatLiteral(0.1f));
+  EXPECT_EQ("1.00000002e+20f", FloatLiteral(1e20f));
+  // Every literal reads back as the same float.
+  unsigned int state = 1;
+  for (int i = 0; i < 10000; ++i) {
+    state = state * 1664525 + 1013904223;
+    const float value = (static_cast<int>(state) / 65536.f) /
+        (1 << (state % 24));
+    const string literal = FloatLiteral(value);
+    ASSERT_EQ('f', literal[literal.size() - 1]);
+    EXPECT_EQ(value, strtof(literal.c_str(), NULL)) << literal;
+  }
+}
+
+TEST_F(ForestToCppTest, TestWriteTreeNode) {
+  TreeProto tree;
+  MakeTree(&tree);
+  WriteTreeNode(file_, tree, 0, 0, 3);
+  EXPECT_EQ(
+      "  if (x[2] <= 0.25f) {\n"
+      "    return 1.5f;\n"
+      "  } else {\n"
+      "    if (x[0] <= -1.f) {\n"
+      "      return 0.100000001f;\n"
+      "    } else {\n"
+      "      return -3.f;\n"
+      "    }\n"
+      "  }\n", Written());
+}
+
+TEST_F(ForestToCppTest, TestWriteForests) {
+  LayerParameter layer;
+  layer.set_name("forest");
+  for (int f = 0; f < 2; ++f) {
+    ForestProto* forest = layer.add_forests();
+    forest->set_init_pred(0.5 + f);
+    forest->set_dim(3);
+    forest->set_learning_rate(0.1);
+    forest->set_max_depth(2);
+    forest->set_min_leaf_n(1);
+    forest->set_rand_feat(1);
+    forest->set_rand_samp(1);
+    forest->set_min_obs(0);
+    forest->set_max_leaf_num(3);
+    MakeTree(forest->add_trees());
+    SetLeaf(2, forest->add_trees()->add_tree_nodes());
+  }
+  WriteForests(file_, "net", layer);
+  const string text = Written();
+  EXPECT_EQ(0, text.find("// Generated by forest_to_cpp from layer forest "
+      "of net.\n"));
+  // A single leaf does not read x.
+  EXPECT_NE(string::npos, text.find(
+      "\nstatic float forest1_tree1(const float* x) {\n"
+      "  (void)x;\n"
+      "  return 2.f;\n"
+      "}\n"));
+  EXPECT_NE(string::npos, text.find(
+      "\nstatic float forest1_tree0(const float* x) {\n"
+      "  if (x[2] <= 0.25f) {\n"));
+  EXPECT_NE(string::npos, text.find(
+      "\nstatic const TreeFunction forest1_trees[] = {\n"
+      "  forest1_tree0,\n"
+      "  forest1_tree1,\n"
+      "};\n"));
+  EXPECT_NE(string::npos, text.find(
+      "\nFOREST_EXPORT int score_num_features() {\n"
+      "  return 3;\n"
+      "}\n"));
+  EXPECT_NE(string::npos, text.find(
+      "\nFOREST_EXPORT int score_num_outputs() {\n"
+      "  return 2;\n"
+      "}\n"));
+  EXPECT_NE(string::npos, text.find(
+      "out[i * 2 + 0] = 0.5f + 0.100000001f * sums[i - begin];\n"));
+  EXPECT_NE(string::npos, text.find(
+      "out[i * 2 + 1] = 1.5f + 0.100000001f * sums[i - begin];\n"));
+  // Only the two single leaves
+  int num_unused = 0;
+  for (size_t pos = text.find("(void)x;"); pos != string::npos;
+      pos = text.find("(void)x;", pos + 1)) {
+    ++num_unused;
+  }
+  EXPECT_EQ(2, num_unused);
+}
+
+}  // namespace caffe
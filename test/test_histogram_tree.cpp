@@ -0,0 +1,192 @@
+#include <stdint.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/histogram_tree.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+typedef ::testing::Types<float, double> Dtypes;
+
+template <typename Dtype>
+class HistogramTreeTest : public ::testing::Test {
+ protected:
+  // The prediction of a tree for the features x.
+  float PredictTree(const TreeProto& tree, const Dtype* x) {
+    int n = 0;
+    while (!tree.tree_nodes(n).leaf()) {
+      const TreeNodeProto& node = tree.tree_nodes(n);
+      n = x[node.feature_split()] <= node.value_split() ? node.left_child() :
+          node.right_child();
+    }
+    return tree.tree_nodes(n).pred();
+  }
+};
+
+TYPED_TEST_CASE(HistogramTreeTest, Dtypes);
+
+TYPED_TEST(HistogramTreeTest, TestFitBins) {
+  // Feature 0 takes 4 values, feature 1 takes 100.
+  const int num = 100;
+  vector<TypeParam> data(num * 2);
+  for (int i = 0; i < num; ++i) {
+    data[i * 2] = i % 4;
+    data[i * 2 + 1] = num - 1 - i;
+  }
+  vector<vector<float> > bounds;
+  FitFeatureBins(&data[0], num, 2, 4, &bounds);
+  ASSERT_EQ(2, bounds.size());
+  ASSERT_EQ(3, bounds[0].size());
+  for (int b = 0; b < 3; ++b) {
+    EXPECT_EQ(b, bounds[0][b]);
+  }
+  ASSERT_EQ(3, bounds[1].size());
+  EXPECT_EQ(25, bounds[1][0]);
+  EXPECT_EQ(50, bounds[1][1]);
+  EXPECT_EQ(75, bounds[1][2]);
+
+  const TypeParam x[4] = {2.5, 25, -1, 99};
+  uint8_t bins[4];
+  BinFeatures(x, 2, 2, bounds, bins);
+  EXPECT_EQ(3, bins[0]);
+  EXPECT_EQ(0, bins[1]);
+  EXPECT_EQ(0, bins[2]);
+  EXPECT_EQ(3, bins[3]);
+}
+
+TYPED_TEST(HistogramTreeTest, TestGrowTree) {
+  // The target is a step function of feature 1: 1 up to 99, 3 up to 149
+  // and 5 beyond. Feature 0 is noise and feature 2 constant.
+  const int num = 200;
+  const int dim = 3;
+  vector<TypeParam> data(num * dim);
+  vector<TypeParam> target(num);
+  vector<TypeParam> grad(num);
+  for (int i = 0; i < num; ++i) {
+    data[i * dim] = (i * 7) % 13;
+    data[i * dim + 1] = i;
+    data[i * dim + 2] = 1;
+    target[i] = i < 100 ? 1 : i < 150 ? 3 : 5;
+    // The gradient of the squared error at a prediction of 0
+    grad[i] = -target[i];
+  }
+  vector<vector<float> > bounds;
+  FitFeatureBins(&data[0], num, dim, kMaxFeatureBins, &bounds);
+  vector<uint8_t> bins(num * dim);
+  BinFeatures(&data[0], num, dim, bounds, &bins[0]);
+  vector<int> features;
+  for (int j = 0; j < dim; ++j) {
+    features.push_back(j);
+  }
+
+  LayerParameter param;
+  param.set_max_depth(3);
+  param.set_max_leaf_num(3);
+  vector<int> samples(num);
+  for (int i = 0; i < num; ++i) {
+    samples[i] = i;
+  }
+  HistogramPool pool(param.max_leaf_num());
+  TreeProto tree;
+  GrowHistogramTree(param, &bins[0], dim, bounds, features, &grad[0],
+      static_cast<TypeParam*>(NULL), &samples, &pool, &tree);
+  ASSERT_EQ(5, tree.tree_nodes_size());
+  const TreeNodeProto& root = tree.tree_nodes(0);
+  EXPECT_FALSE(root.leaf());
+  EXPECT_EQ(1, root.feature_split());
+  EXPECT_EQ(99, root.value_split());
+  EXPECT_EQ(num, root.nsamples());
+  EXPECT_LT(root.best_error(), root.ini_error());
+  EXPECT_EQ(100, tree.tree_nodes(root.left_child()).nsamples());
+  for (int i = 0; i < num; ++i) {
+    EXPECT_NEAR(target[i], this->PredictTree(tree, &data[i * dim]), 1e-5)
+        << "debug: i " << i;
+  }
+
+  // A single level splits once, and a constant target not at all.
+  param.set_max_depth(1);
+  GrowHistogramTree(param, &bins[0], dim, bounds, features, &grad[0],
+      static_cast<TypeParam*>(NULL), &samples, &pool, &tree);
+  EXPECT_EQ(3, tree.tree_nodes_size());
+  for (int i = 0; i < num; ++i) {
+    grad[i] = -1;
+  }
+  GrowHistogramTree(param, &bins[0], dim, bounds, features, &grad[0],
+      static_cast<TypeParam*>(NULL), &samples, &pool, &tree);
+  ASSERT_EQ(1, tree.tree_nodes_size());
+  EXPECT_TRUE(tree.tree_nodes(0).leaf());
+  EXPECT_NEAR(1, tree.tree_nodes(0).pred(), 1e-5);
+}
+
+TYPED_TEST(HistogramTreeTest, TestHistogramSubtraction) {
+  // Pseudo-random features and gradients grow a deep, irregular tree.
+  const int num = 1000;
+  const int dim = 4;
+  vector<TypeParam> data(num * dim);
+  vector<TypeParam> grad(num);
+  vector<TypeParam> hess(num);
+  uint32_t state = 1;
+  for (int i = 0; i < num * dim + 2 * num; ++i) {
+    state = state * 1664525 + 1013904223;
+    const TypeParam value = (state >> 8) / 16777216.;
+    if (i < num * dim) {
+      data[i] = value;
+    } else if (i < num * dim + num) {
+      grad[i - num * dim] = value - 0.5;
+    } else {
+      hess[i - num * dim - num] = 0.5 + value;
+    }
+  }
+  vector<vector<float> > bounds;
+  FitFeatureBins(&data[0], num, dim, 32, &bounds);
+  vector<uint8_t> bins(num * dim);
+  BinFeatures(&data[0], num, dim, bounds, &bins[0]);
+  vector<int> features;
+  features.push_back(0);
+  features.push_back(2);
+  features.push_back(3);
+  LayerParameter param;
+  param.set_max_depth(8);
+  param.set_max_leaf_num(40);
+  param.set_min_leaf_n(5);
+
+  // The same tree whether the pool has room for every open leaf, so that
+  // all but the root are subtracted, or for none, so that all are built.
+  TreeProto trees[3];
+  const int capacities[3] = {40, 3, 0};
+  for (int t = 0; t < 3; ++t) {
+    vector<int> samples(num);
+    for (int i = 0; i < num; ++i) {
+      samples[i] = i;
+    }
+    HistogramPool pool(capacities[t]);
+    GrowHistogramTree(param, &bins[0], dim, bounds, features, &grad[0],
+        &hess[0], &samples, &pool, &trees[t]);
+    EXPECT_LE(pool.num_histograms(), capacities[t]);
+    // A second tree reuses the histograms of the first.
+    const int num_histograms = pool.num_histograms();
+    GrowHistogramTree(param, &bins[0], dim, bounds, features, &grad[0],
+        &hess[0], &samples, &pool, &trees[t]);
+    EXPECT_EQ(num_histograms, pool.num_histograms());
+  }
+  EXPECT_EQ(2 * 40 - 1, trees[0].tree_nodes_size());
+  for (int t = 1; t < 3; ++t) {
+    ASSERT_EQ(trees[0].tree_nodes_size(), trees[t].tree_nodes_size());
+    for (int n = 0; n < trees[0].tree_nodes_size(); ++n) {
+      const TreeNodeProto& expected = trees[0].tree_nodes(n);
+      const TreeNodeProto& node = trees[t].tree_nodes(n);
+      EXPECT_EQ(expected.leaf(), node.leaf());
+      EXPECT_EQ(expected.feature_split(), node.feature_split());
+      EXPECT_EQ(expected.value_split(), node.value_split());
+      EXPECT_EQ(expected.nsamples(), node.nsamples());
+      EXPECT_NEAR(expected.pred(), node.pred(), 1e-6);
+    }
+  }
+}
+
+}  // namespace caffe
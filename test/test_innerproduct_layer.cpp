@@ -121,4 +121,91 @@ TYPED_TEST(InnerProductLayerTest, TestGPUGradient) {
   }
 }
 
+TYPED_TEST(InnerProductLayerTest, TestSparseCPU) {
+  // The same inputs as a dense and as a CSR blob, with a nonzero in every
+  // seventh column.
+  const int num = 2;
+  const int dim = 60;
+  Blob<TypeParam> dense_bottom(num, dim, 1, 1);
+  TypeParam* dense_data = dense_bottom.mutable_cpu_data();
+  vector<int> indices;
+  vector<TypeParam> values;
+  vector<int> ptr(1, 0);
+  for (int i = 0; i < num; ++i) {
+    for (int k = i; k < dim; k += 7) {
+      dense_data[i * dim + k] = this->blob_bottom_->cpu_data()[i * dim + k];
+      indices.push_back(k);
+      values.push_back(dense_data[i * dim + k]);
+    }
+    ptr.push_back(indices.size());
+  }
+  Blob<TypeParam> sparse_bottom;
+  sparse_bottom.ReshapeSparse(num, dim, indices.size());
+  memcpy(sparse_bottom.mutable_cpu_sparse_indices(), &indices[0],
+      sizeof(int) * indices.size());
+  memcpy(sparse_bottom.mutable_cpu_sparse_values(), &values[0],
+      sizeof(TypeParam) * values.size());
+  memcpy(sparse_bottom.mutable_cpu_sparse_ptr(), &ptr[0],
+      sizeof(int) * ptr.size());
+
+  LayerParameter layer_param;
+  Caffe::set_mode(Caffe::CPU);
+  layer_param.set_num_output(10);
+  layer_param.mutable_weight_filler()->set_type("gaussian");
+  layer_param.mutable_bias_filler()->set_type("gaussian");
+  vector<Blob<TypeParam>*> dense_bottom_vec(1, &dense_bottom);
+  vector<Blob<TypeParam>*> sparse_bottom_vec(1, &sparse_bottom);
+  Blob<TypeParam> sparse_top;
+  vector<Blob<TypeParam>*> sparse_top_vec(1, &sparse_top);
+  InnerProductLayer<TypeParam> dense_layer(layer_param);
+  dense_layer.SetUp(dense_bottom_vec, &(this->blob_top_vec_));
+  InnerProductLayer<TypeParam> sparse_layer(layer_param);
+  sparse_layer.SetUp(sparse_bottom_vec, &sparse_top_vec);
+  for (int i = 0; i < 2; ++i) {
+    sparse_layer.blobs()[i]->CopyFrom(*dense_layer.blobs()[i]);
+  }
+
+  dense_layer.Forward(dense_bottom_vec, &(this->blob_top_vec_));
+  sparse_layer.Forward(sparse_bottom_vec, &sparse_top_vec);
+  for (int i = 0; i < sparse_top.count(); ++i) {
+    EXPECT_NEAR(this->blob_top_->cpu_data()[i], sparse_top.cpu_data()[i],
+        1e-4);
+  }
+
+  for (int i = 0; i < sparse_top.count(); ++i) {
+    this->blob_top_->mutable_cpu_diff()[i] = i % 3 - 1;
+    sparse_top.mutable_cpu_diff()[i] = i % 3 - 1;
+  }
+  dense_layer.Backward(this->blob_top_vec_, true, &dense_bottom_vec);
+  sparse_layer.Backward(sparse_top_vec, true, &sparse_bottom_vec);
+  for (int i = 0; i < 2; ++i) {
+    const Blob<TypeParam>& dense_param = *dense_layer.blobs()[i];
+    const Blob<TypeParam>& sparse_param = *sparse_layer.blobs()[i];
+    for (int j = 0; j < dense_param.count(); ++j) {
+      EXPECT_NEAR(dense_param.cpu_diff()[j], sparse_param.cpu_diff()[j], 1e-4);
+    }
+  }
+  // Only the columns holding a nonzero have a gradient.
+  const vector<int>* columns = sparse_layer.blobs()[0]->diff_columns();
+  ASSERT_TRUE(columns != NULL);
+  EXPECT_EQ(columns->size(), indices.size());
+
+  // A dense Update only moves the weights of those columns.
+  Blob<TypeParam>& weight = *sparse_layer.blobs()[0];
+  Blob<TypeParam> old_weight;
+  old_weight.CopyFrom(weight, false, true);
+  weight.Update();
+  for (int n = 0; n < 10; ++n) {
+    for (int k = 0; k < dim; ++k) {
+      const int j = n * dim + k;
+      EXPECT_NEAR(weight.cpu_data()[j],
+          old_weight.cpu_data()[j] - dense_layer.blobs()[0]->cpu_diff()[j],
+          1e-4);
+      if (k % 7 > 1) {
+        EXPECT_EQ(weight.cpu_data()[j], old_weight.cpu_data()[j]);
+      }
+    }
+  }
+}
+
 }
@@ -0,0 +1,131 @@
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/io.hpp"
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class IOTest : public ::testing::Test {};
+
+TEST_F(IOTest, TestReadCsvLine) {
+  Datum datum;
+  EXPECT_TRUE(ReadTextLineToDatum("2,17,0.5,-1,3e2\r\n", TEXT_CSV, 0, false,
+      &datum));
+  EXPECT_FALSE(datum.has_label());
+  ASSERT_EQ(1, datum.float_label_size());
+  EXPECT_EQ(2, datum.float_label(0));
+  EXPECT_EQ(17, datum.group_id());
+  EXPECT_EQ(3, datum.channels());
+  EXPECT_EQ(1, datum.height());
+  EXPECT_EQ(1, datum.width());
+  ASSERT_EQ(3, datum.float_data_size());
+  EXPECT_EQ(0.5, datum.float_data(0));
+  EXPECT_EQ(-1, datum.float_data(1));
+  EXPECT_EQ(300, datum.float_data(2));
+
+  // Fractional labels are stored the same way as integral ones.
+  EXPECT_TRUE(ReadTextLineToDatum("0.25\t3\t1\t2", TEXT_TSV, 2, false,
+      &datum));
+  EXPECT_FALSE(datum.has_label());
+  ASSERT_EQ(1, datum.float_label_size());
+  EXPECT_EQ(0.25, datum.float_label(0));
+  EXPECT_EQ(2, datum.float_data_size());
+
+  EXPECT_FALSE(ReadTextLineToDatum("label,qid,f1", TEXT_CSV, 0, false,
+      &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1,2,3,x", TEXT_CSV, 0, false, &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1,2,3,4", TEXT_CSV, 3, false, &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1,2", TEXT_CSV, 0, false, &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1\t2\t3", TEXT_CSV, 0, false, &datum));
+  // A query id must fit the int32 group_id.
+  EXPECT_TRUE(ReadTextLineToDatum("1,-2147483648,3", TEXT_CSV, 0, false,
+      &datum));
+  EXPECT_EQ(INT_MIN, datum.group_id());
+  EXPECT_FALSE(ReadTextLineToDatum("1,2147483648,3", TEXT_CSV, 0, false,
+      &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1,99999999999999999999,3", TEXT_CSV, 0,
+      false, &datum));
+}
+
+TEST_F(IOTest, TestReadLibsvmLine) {
+  const char* line = "3 qid:42 1:0.5 4:-2 # doc 7";
+  Datum datum;
+  EXPECT_TRUE(ReadTextLineToDatum(line, TEXT_LIBSVM, 5, false, &datum));
+  ASSERT_EQ(1, datum.float_label_size());
+  EXPECT_EQ(3, datum.float_label(0));
+  EXPECT_EQ(42, datum.group_id());
+  EXPECT_EQ(5, datum.channels());
+  ASSERT_EQ(5, datum.float_data_size());
+  const float expected[5] = {0.5, 0, 0, -2, 0};
+  for (int j = 0; j < 5; ++j) {
+    EXPECT_EQ(expected[j], datum.float_data(j));
+  }
+
+  EXPECT_TRUE(ReadTextLineToDatum(line, TEXT_LIBSVM, 5, true, &datum));
+  EXPECT_EQ(5, datum.sparse_dim());
+  EXPECT_EQ(0, datum.float_data_size());
+  ASSERT_EQ(2, datum.sparse_index_size());
+  EXPECT_EQ(0, datum.sparse_index(0));
+  EXPECT_EQ(3, datum.sparse_index(1));
+  EXPECT_EQ(0.5, datum.sparse_value(0));
+  EXPECT_EQ(-2, datum.sparse_value(1));
+
+  EXPECT_TRUE(ReadTextLineToDatum("0", TEXT_LIBSVM, 5, false, &datum));
+  EXPECT_FALSE(datum.has_group_id());
+  EXPECT_FALSE(ReadTextLineToDatum(line, TEXT_LIBSVM, 3, false, &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1 0:1", TEXT_LIBSVM, 5, false, &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1 2:", TEXT_LIBSVM, 5, false, &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1 qid:a", TEXT_LIBSVM, 5, false,
+      &datum));
+  EXPECT_FALSE(ReadTextLineToDatum("1 qid:4294967338 1:1", TEXT_LIBSVM, 5,
+      false, &datum));
+}
+
+TEST_F(IOTest, TestReadRepeatedProto) {
+  char filename[256];
+  sprintf(filename, "../tmp/%s", tmpnam(NULL));
+  NetParameter param;
+  param.set_name("net");
+  // Layer i has one blob of i + 1 values, the first of which is i.
+  for (int i = 0; i < 3; ++i) {
+    LayerConnection* layer_connection = param.add_layers();
+    layer_connection->mutable_layer()->set_name(i == 1 ? "b" : "a");
+    layer_connection->add_top("top");
+    BlobProto* blob = layer_connection->mutable_layer()->add_blobs();
+    blob->set_num(i + 1);
+    for (int j = 0; j <= i; ++j) {
+      blob->add_data(i + j);
+    }
+  }
+  param.add_input("data");
+  WriteProtoToBinaryFile(param, filename);
+
+  LayerConnection layer_connection;
+  std::vector<std::string> names;
+  std::vector<int> sizes;
+  std::vector<float> first;
+  ReadRepeatedProtoFromBinaryFile(filename, NetParameter::kLayersFieldNumber,
+      &layer_connection, [&]() {
+        names.push_back(layer_connection.layer().name());
+        EXPECT_EQ(1, layer_connection.top_size());
+        ASSERT_EQ(1, layer_connection.layer().blobs_size());
+        const BlobProto& blob = layer_connection.layer().blobs(0);
+        sizes.push_back(blob.data_size());
+        first.push_back(blob.data(0));
+      });
+  ASSERT_EQ(3, names.size());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i == 1 ? "b" : "a", names[i]);
+    EXPECT_EQ(i + 1, sizes[i]);
+    EXPECT_EQ(i, first[i]);
+  }
+  remove(filename);
+}
+
+}  // namespace caffe
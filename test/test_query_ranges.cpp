@@ -0,0 +1,61 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/util/query_ranges.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+typedef ::testing::Types<float, double> Dtypes;
+
+template <typename Dtype>
+class QueryRangesTest : public ::testing::Test {};
+
+TYPED_TEST_CASE(QueryRangesTest, Dtypes);
+
+TYPED_TEST(QueryRangesTest, TestFromQid) {
+  // Negative query ids are queries of their own without padding.
+  const TypeParam qid[] = {3, 3, -1, -1, -7, 5, 5, 5, -1};
+  vector<int> start;
+  vector<int> num;
+  QueryRangesFromQid(qid, 9, false, &start, &num);
+  ASSERT_EQ(5, start.size());
+  const int expected_start[] = {0, 2, 4, 5, 8};
+  const int expected_num[] = {2, 2, 1, 3, 1};
+  for (int q = 0; q < 5; ++q) {
+    EXPECT_EQ(expected_start[q], start[q]);
+    EXPECT_EQ(expected_num[q], num[q]);
+  }
+  // With padding only -1 is dropped.
+  QueryRangesFromQid(qid, 9, true, &start, &num);
+  ASSERT_EQ(3, start.size());
+  EXPECT_EQ(0, start[0]);
+  EXPECT_EQ(2, num[0]);
+  EXPECT_EQ(4, start[1]);
+  EXPECT_EQ(1, num[1]);
+  EXPECT_EQ(5, start[2]);
+  EXPECT_EQ(3, num[2]);
+}
+
+TYPED_TEST(QueryRangesTest, TestFromOffsets) {
+  Blob<TypeParam> offsets(6, 1, 1, 1);
+  const TypeParam data[] = {0, 2, 5, 6, -1, -1};
+  for (int i = 0; i < 6; ++i) {
+    offsets.mutable_cpu_data()[i] = data[i];
+  }
+  vector<int> start;
+  vector<int> num;
+  QueryRangesFromOffsets(offsets, &start, &num);
+  ASSERT_EQ(3, start.size());
+  EXPECT_EQ(0, start[0]);
+  EXPECT_EQ(2, num[0]);
+  EXPECT_EQ(2, start[1]);
+  EXPECT_EQ(3, num[1]);
+  EXPECT_EQ(5, start[2]);
+  EXPECT_EQ(1, num[2]);
+}
+
+}  // namespace caffe
@@ -0,0 +1,338 @@
+// Computes the per-feature mean of a dataset, for the meanfile parameter of
+// the data layer, and optionally the per-feature variance.
+// Usage:
+//    compute_mean input mean_file [variance_file [quantization_file]]
+//
+// input is a leveldb of Datum records or a dense dataset file. Both files
+// are BlobProtos of shape 1 x channels x height x width; the variance is the
+// population variance. Features are averaged as the data layer sees them
+// before mean subtraction: uint8 features are dequantized with the given
+// quantization_file when there is one, fp16 features are widened.
+//
+// The data is read in one pass. A leveldb is read on the main thread in
+// chunks of records that a pool of threads parses; a dense dataset is cut
+// into one contiguous range of records per thread, each streamed with its
+// own reader. Every thread keeps Kahan-compensated sums in double, merged
+// once at the end. The sums are taken about the first record to keep the
+// variance accurate when the mean is far from zero. Do not build this with
+// -ffast-math, which would optimize the compensation away.
+
+#include <glog/logging.h>
+#include <leveldb/db.h>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/dequantize.hpp"
+#include "caffe/util/io.hpp"
+
+using caffe::BlobProto;
+using caffe::BlockingQueue;
+using caffe::Datum;
+using caffe::DenseDatasetHeader;
+using std::string;
+using std::vector;
+
+const int kChunkRecords = 1024;
+const size_t kStreamChunkBytes = 16 << 20;
+
+// Adds value to a compensated sum.
+inline void KahanAdd(const double value, double* sum, double* compensation) {
+  const double y = value - *compensation;
+  const double t = *sum + y;
+  *compensation = (t - *sum) - y;
+  *sum = t;
+}
+
+// Compensated per-feature sums of x - origin and (x - origin)^2.
+class MomentSums {
+ public:
+  MomentSums(const int size, const bool squares)
+      : count_(0), squares_(squares), sum_(size), sum_c_(size),
+        sq_(squares ? size : 0), sq_c_(squares ? size : 0) {}
+
+  void Add(const float* x, const float* origin) {
+    const int size = sum_.size();
+    for (int j = 0; j < size; ++j) {
+      const double d = static_cast<double>(x[j]) - origin[j];
+      KahanAdd(d, &sum_[j], &sum_c_[j]);
+      if (squares_) {
+        KahanAdd(d * d, &sq_[j], &sq_c_[j]);
+      }
+    }
+    ++count_;
+  }
+
+  void Merge(const MomentSums& other) {
+    for (int j = 0; j < sum_.size(); ++j) {
+      KahanAdd(other.sum_[j], &sum_[j], &sum_c_[j]);
+      KahanAdd(-other.sum_c_[j], &sum_[j], &sum_c_[j]);
+      if (squares_) {
+        KahanAdd(other.sq_[j], &sq_[j], &sq_c_[j]);
+        KahanAdd(-other.sq_c_[j], &sq_[j], &sq_c_[j]);
+      }
+    }
+    count_ += other.count_;
+  }
+
+  int64_t count() const { return count_; }
+
+  double Mean(const int j, const float origin) const {
+    return origin + sum_[j] / count_;
+  }
+
+  double Variance(const int j) const {
+    const double mean = sum_[j] / count_;
+    return std::max(0., sq_[j] / count_ - mean * mean);
+  }
+
+ private:
+  int64_t count_;
+  bool squares_;
+  vector<double> sum_;
+  vector<double> sum_c_;
+  vector<double> sq_;
+  vector<double> sq_c_;
+};
+
+// How the stored features of a record turn into the values to average.
+struct FeatureDecoder {
+  int size;
+  vector<float> scale;
+  vector<float> shift;
+
+  void DecodeDatum(const Datum& datum, float* out) const {
+    CHECK_EQ(datum.sparse_dim(), 0) << "Sparse records have no mean file";
+    const string& data = datum.data();
+    const string& half_data = datum.half_data();
+    if (data.size()) {
+      CHECK_EQ(data.size(), size);
+      caffe::caffe_dequantize_uint8(size,
+          reinterpret_cast<const uint8_t*>(data.data()), &scale[0], &shift[0],
+          out);
+    } else if (half_data.size()) {
+      CHECK_EQ(half_data.size(), 2 * size);
+      caffe::caffe_dequantize_half(size,
+          reinterpret_cast<const uint16_t*>(half_data.data()), &scale[0],
+          &shift[0], out);
+    } else {
+      CHECK_EQ(datum.float_data_size(), size);
+      memcpy(out, datum.float_data().data(), sizeof(float) * size);
+    }
+  }
+
+  void DecodeRow(const uint32_t feature_type, const char* row,
+      float* out) const {
+    if (feature_type == caffe::DENSE_UINT8) {
+      caffe::caffe_dequantize_uint8(size,
+          reinterpret_cast<const uint8_t*>(row), &scale[0], &shift[0], out);
+    } else if (feature_type == caffe::DENSE_FLOAT16) {
+      caffe::caffe_dequantize_half(size,
+          reinterpret_cast<const uint16_t*>(row), &scale[0], &shift[0], out);
+    } else {
+      memcpy(out, row, sizeof(float) * size);
+    }
+  }
+};
+
+// A chunk of raw leveldb records.
+struct Chunk {
+  int num_records;
+  vector<string> records;
+};
+
+bool IsDenseDataset(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+  char magic[sizeof(caffe::kDenseDatasetMagic)];
+  const bool dense = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+      memcmp(magic, caffe::kDenseDatasetMagic, sizeof(magic)) == 0;
+  fclose(file);
+  return dense;
+}
+
+void SetShape(const int channels, const int height, const int width,
+    BlobProto* blob) {
+  blob->set_num(1);
+  blob->set_channels(channels);
+  blob->set_height(height);
+  blob->set_width(width);
+}
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  if (argc < 3 || argc > 5) {
+    LOG(ERROR) << "Usage: compute_mean input mean_file "
+        << "[variance_file [quantization_file]]";
+    return 1;
+  }
+  const bool variance = argc > 3;
+  const int num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // The shape and the first record, which is the origin of the sums
+  FeatureDecoder decoder;
+  BlobProto mean;
+  vector<float> origin;
+  vector<MomentSums> sums;
+  const bool dense = IsDenseDataset(argv[1]);
+  DenseDatasetHeader header;
+  leveldb::DB* db = NULL;
+  leveldb::Iterator* iter = NULL;
+  Datum datum;
+  if (dense) {
+    size_t file_size;
+    const char* map = caffe::MapFileReadOnly(argv[1], &file_size);
+    memcpy(&header, map, sizeof(header));
+    caffe::CheckDenseDatasetHeader(header, file_size);
+    SetShape(header.channels, header.height, header.width, &mean);
+    decoder.size = header.channels * header.height * header.width;
+    caffe::UnmapFile(map, file_size);
+  } else {
+    leveldb::Options options;
+    options.create_if_missing = false;
+    leveldb::Status status = leveldb::DB::Open(options, argv[1], &db);
+    CHECK(status.ok()) << "Failed to open leveldb " << argv[1] << std::endl
+        << status.ToString();
+    // A single pass, so keep the blocks out of the cache.
+    leveldb::ReadOptions read_options;
+    read_options.fill_cache = false;
+    iter = db->NewIterator(read_options);
+    iter->SeekToFirst();
+    CHECK(iter->Valid()) << "Empty leveldb " << argv[1];
+    CHECK(datum.ParseFromArray(iter->value().data(), iter->value().size()));
+    SetShape(datum.channels(), datum.height(), datum.width(), &mean);
+    decoder.size = datum.channels() * datum.height() * datum.width();
+  }
+  const int size = decoder.size;
+  decoder.scale.assign(size, 1);
+  decoder.shift.assign(size, 0);
+  if (argc > 4) {
+    BlobProto quantization;
+    caffe::ReadProtoFromBinaryFile(argv[4], &quantization);
+    CHECK_EQ(quantization.num(), 2);
+    CHECK_EQ(quantization.data_size(), 2 * size)
+        << "The quantization does not match the features";
+    for (int j = 0; j < size; ++j) {
+      decoder.scale[j] = quantization.data(j);
+      decoder.shift[j] = quantization.data(size + j);
+    }
+  }
+  origin.resize(size);
+  sums.assign(num_threads, MomentSums(size, variance));
+
+  LOG(INFO) << "Computing the mean of " << size << " features on "
+      << num_threads << " threads";
+  vector<std::thread> threads;
+  // For a leveldb, the main thread reads chunks of records that the threads
+  // parse. A ring of chunks bounds the memory.
+  vector<Chunk> chunks(dense ? 0 : 2 * num_threads + 2);
+  BlockingQueue<Chunk*> free_queue;
+  BlockingQueue<Chunk*> work_queue;
+  if (dense) {
+    // Each thread streams its own range of records.
+    const size_t row_bytes = caffe::DenseFeatureBytes(header) * size;
+    {
+      caffe::SequentialFileReader reader(argv[1], header.feature_offset,
+          header.feature_offset + row_bytes, kStreamChunkBytes);
+      vector<char> row(row_bytes);
+      reader.Read(0, row_bytes, &row[0]);
+      decoder.DecodeRow(header.feature_type, &row[0], &origin[0]);
+    }
+    for (int t = 0; t < num_threads; ++t) {
+      const uint64_t begin = static_cast<uint64_t>(header.num) * t /
+          num_threads;
+      const uint64_t end = static_cast<uint64_t>(header.num) * (t + 1) /
+          num_threads;
+      if (begin == end) {
+        continue;
+      }
+      threads.push_back(std::thread([&, t, begin, end]() {
+        caffe::SequentialFileReader reader(argv[1],
+            header.feature_offset + begin * row_bytes,
+            header.feature_offset + end * row_bytes, kStreamChunkBytes);
+        vector<char> row(row_bytes);
+        vector<float> x(size);
+        for (uint64_t i = 0; i < end - begin; ++i) {
+          reader.Read(i * row_bytes, row_bytes, &row[0]);
+          decoder.DecodeRow(header.feature_type, &row[0], &x[0]);
+          sums[t].Add(&x[0], &origin[0]);
+        }
+      }));
+    }
+  } else {
+    decoder.DecodeDatum(datum, &origin[0]);
+    for (int i = 0; i < chunks.size(); ++i) {
+      chunks[i].records.resize(kChunkRecords);
+      free_queue.push(&chunks[i]);
+    }
+    for (int t = 0; t < num_threads; ++t) {
+      threads.push_back(std::thread([&, t]() {
+        Datum datum;
+        vector<float> x(size);
+        for (Chunk* chunk = work_queue.pop(); chunk != NULL;
+            chunk = work_queue.pop()) {
+          for (int i = 0; i < chunk->num_records; ++i) {
+            const string& record = chunk->records[i];
+            CHECK(datum.ParseFromArray(record.data(), record.size()));
+            decoder.DecodeDatum(datum, &x[0]);
+            sums[t].Add(&x[0], &origin[0]);
+          }
+          free_queue.push(chunk);
+        }
+      }));
+    }
+    int64_t count = 0;
+    while (iter->Valid()) {
+      Chunk* chunk = free_queue.pop();
+      int n = 0;
+      for (; n < kChunkRecords && iter->Valid(); ++n, iter->Next()) {
+        const leveldb::Slice value = iter->value();
+        chunk->records[n].assign(value.data(), value.size());
+      }
+      chunk->num_records = n;
+      work_queue.push(chunk);
+      count += n;
+      if (count % (100 * kChunkRecords) == 0) {
+        LOG(INFO) << "Read " << count << " records";
+      }
+    }
+    for (int t = 0; t < num_threads; ++t) {
+      work_queue.push(NULL);
+    }
+  }
+  for (int i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  delete iter;
+  delete db;
+
+  for (int t = 1; t < num_threads; ++t) {
+    sums[0].Merge(sums[t]);
+  }
+  const MomentSums& total = sums[0];
+  BlobProto variance_blob;
+  SetShape(mean.channels(), mean.height(), mean.width(), &variance_blob);
+  for (int j = 0; j < size; ++j) {
+    mean.add_data(total.Mean(j, origin[j]));
+    if (variance) {
+      variance_blob.add_data(total.Variance(j));
+    }
+  }
+  caffe::WriteProtoToBinaryFile(mean, argv[2]);
+  LOG(INFO) << "Wrote the mean of " << total.count() << " records to "
+      << argv[2];
+  if (variance) {
+    caffe::WriteProtoToBinaryFile(variance_blob, argv[3]);
+    LOG(INFO) << "Wrote the variance to " << argv[3];
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+// Converts a leveldb of Datum records into a dense dataset file that the
+// data layer can memory-map (source_type: DENSE).
+// Usage:
+//    convert_leveldb_to_dense input_leveldb output_file
+//
+// The file starts with a DenseDatasetHeader (see util/io.hpp) followed by
+// these sections, all little endian:
+//    features   [num][channels * height * width], record major, starting
+//               at feature_offset (a multiple of 4096). They are stored as
+//               the records hold them: uint8 (data), fp16 (half_data) or
+//               float (float_data), as given by feature_type.
+//    labels     float[num][label_dim], starting at label_offset
+//    group ids  int32[num_groups], starting at group_id_offset
+//    groups     uint32[num_groups + 1] record offsets, starting at
+//               group_offset; group i spans records
+//               [groups[i], groups[i + 1])
+// A group is a run of consecutive records sharing a group_id. The group
+// sections are empty (num_groups == 0) when no record carries a group_id;
+// either every record carries one or none does.
+
+#include <glog/logging.h>
+#include <leveldb/db.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/io.hpp"
+
+#ifdef _WIN32
+#define fseeko _fseeki64
+#endif
+
+using caffe::Datum;
+using caffe::DenseDatasetHeader;
+using std::string;
+using std::vector;
+
+const uint64_t kDenseAlignment = 4096;
+
+uint64_t AlignUp(const uint64_t offset) {
+  return (offset + kDenseAlignment - 1) / kDenseAlignment * kDenseAlignment;
+}
+
+void WriteAt(FILE* file, const uint64_t offset, const void* data,
+    const size_t size) {
+  CHECK_EQ(fseeko(file, offset, SEEK_SET), 0);
+  CHECK_EQ(fwrite(data, 1, size, file), size) << "Failed to write";
+}
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  if (argc != 3) {
+    LOG(ERROR) << "Usage: convert_leveldb_to_dense input_leveldb output_file";
+    return 1;
+  }
+
+  leveldb::DB* db;
+  leveldb::Options options;
+  options.create_if_missing = false;
+  leveldb::Status status = leveldb::DB::Open(options, argv[1], &db);
+  CHECK(status.ok()) << "Failed to open leveldb " << argv[1];
+
+  FILE* file = fopen(argv[2], "wb");
+  CHECK(file) << "Failed to open " << argv[2];
+
+  DenseDatasetHeader header;
+  memset(&header, 0, sizeof(header));
+  header.feature_offset = AlignUp(sizeof(header));
+  // The header is rewritten once the sizes are known.
+  WriteAt(file, 0, &header, sizeof(header));
+
+  vector<float> labels;
+  vector<int32_t> group_ids;
+  vector<uint32_t> group_offsets;
+  bool has_group_ids = false;
+  Datum datum;
+  uint64_t offset = header.feature_offset;
+  CHECK_EQ(fseeko(file, offset, SEEK_SET), 0);
+  leveldb::Iterator* iter = db->NewIterator(leveldb::ReadOptions());
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    CHECK(datum.ParseFromArray(iter->value().data(), iter->value().size()));
+    CHECK_EQ(datum.sparse_dim(), 0)
+        << "sparse records cannot be stored densely";
+    const int label_dim = datum.has_label() ? 1 : datum.float_label_size();
+    const string& data = datum.data();
+    const string& half_data = datum.half_data();
+    const uint32_t feature_type = data.size() ? caffe::DENSE_UINT8 :
+        half_data.size() ? caffe::DENSE_FLOAT16 : caffe::DENSE_FLOAT32;
+    if (header.num == 0) {
+      header.channels = datum.channels();
+      header.height = datum.height();
+      header.width = datum.width();
+      header.label_dim = label_dim;
+      header.feature_type = feature_type;
+      has_group_ids = datum.has_group_id();
+    }
+    CHECK_EQ(datum.channels(), header.channels);
+    CHECK_EQ(datum.height(), header.height);
+    CHECK_EQ(datum.width(), header.width);
+    CHECK_EQ(label_dim, header.label_dim);
+    CHECK_EQ(feature_type, header.feature_type)
+        << "All records must store their features the same way";
+    CHECK_EQ(datum.has_group_id(), has_group_ids)
+        << "Either all records or none must have a group_id, record "
+        << header.num << " differs";
+
+    const int size = datum.channels() * datum.height() * datum.width();
+    const void* features;
+    if (feature_type == caffe::DENSE_UINT8) {
+      CHECK_EQ(data.size(), size);
+      features = data.data();
+    } else if (feature_type == caffe::DENSE_FLOAT16) {
+      CHECK_EQ(half_data.size(), 2 * size);
+      features = half_data.data();
+    } else {
+      CHECK_EQ(datum.float_data_size(), size);
+      features = datum.float_data().data();
+    }
+    const size_t feature_bytes = caffe::DenseFeatureBytes(header);
+    CHECK_EQ(fwrite(features, feature_bytes, size, file), size)
+        << "Failed to write";
+
+    if (datum.has_label()) {
+      labels.push_back(datum.label());
+    } else {
+      labels.insert(labels.end(), datum.float_label().begin(),
+          datum.float_label().end());
+    }
+    if (has_group_ids &&
+        (group_ids.empty() || group_ids.back() != datum.group_id())) {
+      group_ids.push_back(datum.group_id());
+      group_offsets.push_back(header.num);
+    }
+    if (++header.num % 10000 == 0) {
+      LOG(INFO) << "Converted " << header.num << " records";
+    }
+  }
+  delete iter;
+  delete db;
+  CHECK_GT(header.num, 0) << "Empty leveldb " << argv[1];
+  offset += static_cast<uint64_t>(header.num) * header.channels *
+      header.height * header.width * caffe::DenseFeatureBytes(header);
+
+  header.label_offset = AlignUp(offset);
+  WriteAt(file, header.label_offset, &labels[0],
+      sizeof(float) * labels.size());
+  offset = header.label_offset + sizeof(float) * labels.size();
+
+  if (!group_ids.empty()) {
+    header.num_groups = group_ids.size();
+    group_offsets.push_back(header.num);
+    header.group_id_offset = AlignUp(offset);
+    WriteAt(file, header.group_id_offset, &group_ids[0],
+        sizeof(int32_t) * group_ids.size());
+    offset = header.group_id_offset + sizeof(int32_t) * group_ids.size();
+    header.group_offset = AlignUp(offset);
+    WriteAt(file, header.group_offset, &group_offsets[0],
+        sizeof(uint32_t) * group_offsets.size());
+  }
+
+  memcpy(header.magic, caffe::kDenseDatasetMagic, sizeof(header.magic));
+  WriteAt(file, 0, &header, sizeof(header));
+  CHECK_EQ(fclose(file), 0) << "Failed to write " << argv[2];
+  LOG(INFO) << "Wrote " << header.num << " records in " << header.num_groups
+      << " groups to " << argv[2];
+  return 0;
+}
@@ -0,0 +1,255 @@
+// Converts a text ranking dataset into a leveldb of Datum records.
+// Usage:
+//    convert_text_to_leveldb csv|tsv input_file output_leveldb [num_features]
+//    convert_text_to_leveldb libsvm input_file output_leveldb num_features
+//        [sparse]
+//
+// csv and tsv lines are label,qid,f1,f2,... with commas or tabs; a first
+// record line that does not parse is taken for a header and skipped. libsvm
+// lines are label qid:q index:value ... with 1-based indices, optionally
+// followed by a # comment. Features are stored as float_data of
+// num_features channels, or with sparse as sparse_index/sparse_value of
+// sparse_dim num_features. The label goes to float_label and the query id,
+// which has to fit an int32, to group_id. Blank lines and lines starting
+// with # are skipped; any other line that does not parse is an error.
+//
+// The input is read in chunks of lines that a pool of threads parses and
+// serializes into one leveldb::WriteBatch each. The batches are written in
+// input order under zero padded line numbers, so the keys come in sorted and
+// the query groups stay contiguous for the data layer.
+
+#include <glog/logging.h>
+#include <leveldb/db.h>
+#include <leveldb/write_batch.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/io.hpp"
+
+using caffe::BlockingQueue;
+using caffe::Datum;
+using std::string;
+using std::vector;
+
+const int kChunkLines = 10000;
+
+// A run of input lines, and the write batch they turn into.
+struct Chunk {
+  int64_t index;
+  int64_t first_line;
+  int num_lines;
+  // The last chunk of the input, maybe empty
+  bool last;
+  vector<string> lines;
+  leveldb::WriteBatch batch;
+  int num_records;
+};
+
+// Parsed chunks wait here until all the chunks before them are written.
+class ChunkSequencer {
+ public:
+  ChunkSequencer() : next_(0) {}
+
+  void push(Chunk* chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_[chunk->index] = chunk;
+    lock.unlock();
+    condition_.notify_all();
+  }
+
+  // Waits for the next chunk in input order.
+  Chunk* pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return done_.count(next_) > 0; });
+    Chunk* chunk = done_[next_];
+    done_.erase(next_++);
+    return chunk;
+  }
+
+ private:
+  std::map<int64_t, Chunk*> done_;
+  int64_t next_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+};
+
+bool SkipLine(const string& line) {
+  const size_t first = line.find_first_not_of(" \t\r\n");
+  return first == string::npos || line[first] == '#';
+}
+
+void MakeKey(const int64_t line, char* key) {
+  snprintf(key, 16, "%012lld", static_cast<long long>(line));
+}
+
+// Parses chunks until it pops a NULL.
+void ParseChunks(const caffe::TextDatasetFormat format,
+    const int num_features, const bool sparse,
+    BlockingQueue<Chunk*>* parse_queue, ChunkSequencer* sequencer) {
+  Datum datum;
+  string value;
+  char key[16];
+  for (Chunk* chunk = parse_queue->pop(); chunk != NULL;
+      chunk = parse_queue->pop()) {
+    chunk->batch.Clear();
+    chunk->num_records = 0;
+    for (int i = 0; i < chunk->num_lines; ++i) {
+      const string& line = chunk->lines[i];
+      if (SkipLine(line)) {
+        continue;
+      }
+      const int64_t line_number = chunk->first_line + i;
+      CHECK(caffe::ReadTextLineToDatum(line.c_str(), format, num_features,
+          sparse, &datum)) << "Malformed line " << line_number + 1 << ": "
+          << line;
+      datum.SerializeToString(&value);
+      MakeKey(line_number, key);
+      chunk->batch.Put(key, value);
+      ++chunk->num_records;
+    }
+    sequencer->push(chunk);
+  }
+}
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  caffe::TextDatasetFormat format = caffe::TEXT_CSV;
+  bool known_format = argc >= 4 && argc <= 6;
+  if (known_format && strcmp(argv[1], "tsv") == 0) {
+    format = caffe::TEXT_TSV;
+  } else if (known_format && strcmp(argv[1], "libsvm") == 0) {
+    format = caffe::TEXT_LIBSVM;
+  } else if (!known_format || strcmp(argv[1], "csv") != 0) {
+    known_format = false;
+  }
+  const int num_features = argc > 4 ? atoi(argv[4]) : 0;
+  const bool sparse = argc > 5 && strcmp(argv[5], "sparse") == 0;
+  if (!known_format || (format == caffe::TEXT_LIBSVM && num_features <= 0) ||
+      (argc > 5 && (!sparse || format != caffe::TEXT_LIBSVM))) {
+    LOG(ERROR) << "Usage: convert_text_to_leveldb csv|tsv|libsvm input_file "
+        << "output_leveldb [num_features] [sparse]" << std::endl
+        << "libsvm needs num_features, and only libsvm can be sparse";
+    return 1;
+  }
+
+  std::ifstream input(argv[2]);
+  CHECK(input) << "Failed to open " << argv[2];
+  // Look for the first record. A csv or tsv file without num_features takes
+  // its width.
+  int width = num_features;
+  int64_t first_line = 0;
+  bool header = false;
+  string first_record;
+  Datum datum;
+  while (std::getline(input, first_record)) {
+    if (SkipLine(first_record)) {
+      ++first_line;
+      continue;
+    }
+    if (!caffe::ReadTextLineToDatum(first_record.c_str(), format, width,
+        sparse, &datum)) {
+      CHECK(!header && format != caffe::TEXT_LIBSVM) << "Malformed line "
+          << first_line + 1 << ": " << first_record;
+      LOG(INFO) << "Skipping the header " << first_record;
+      header = true;
+      ++first_line;
+      continue;
+    }
+    if (!sparse && !width) {
+      width = datum.channels();
+    }
+    break;
+  }
+  CHECK(input) << "No records in " << argv[2];
+
+  leveldb::DB* db;
+  leveldb::Options options;
+  options.create_if_missing = true;
+  options.error_if_exists = true;
+  options.write_buffer_size = 268435456;
+  leveldb::Status status = leveldb::DB::Open(options, argv[3], &db);
+  CHECK(status.ok()) << "Failed to open leveldb " << argv[3] << std::endl
+      << status.ToString();
+
+  const int num_threads =
+      std::max(1u, std::thread::hardware_concurrency());
+  LOG(INFO) << "Parsing on " << num_threads << " threads";
+  // Enough chunks in flight to keep every parser and the writer busy.
+  vector<Chunk> chunks(2 * num_threads + 2);
+  BlockingQueue<Chunk*> free_queue;
+  BlockingQueue<Chunk*> parse_queue;
+  ChunkSequencer sequencer;
+  for (int i = 0; i < chunks.size(); ++i) {
+    chunks[i].lines.resize(kChunkLines);
+    free_queue.push(&chunks[i]);
+  }
+  vector<std::thread> parsers;
+  for (int i = 0; i < num_threads; ++i) {
+    parsers.push_back(std::thread(ParseChunks, format, width, sparse,
+        &parse_queue, &sequencer));
+  }
+
+  // The writer commits the chunks in input order.
+  int64_t num_records = 0;
+  std::thread writer([&]() {
+    for (int64_t index = 1; ; ++index) {
+      Chunk* chunk = sequencer.pop();
+      leveldb::Status status = db->Write(leveldb::WriteOptions(),
+          &chunk->batch);
+      CHECK(status.ok()) << "Failed to write: " << status.ToString();
+      num_records += chunk->num_records;
+      if (chunk->last) {
+        return;
+      }
+      if (index % 100 == 0) {
+        LOG(INFO) << "Converted " << num_records << " records";
+      }
+      free_queue.push(chunk);
+    }
+  });
+
+  // Read the input, starting with the first record.
+  int64_t line_number = first_line;
+  for (int64_t index = 0; ; ++index) {
+    Chunk* chunk = free_queue.pop();
+    chunk->index = index;
+    chunk->first_line = line_number;
+    int n = 0;
+    if (index == 0) {
+      chunk->lines[n++].swap(first_record);
+    }
+    while (n < kChunkLines && std::getline(input, chunk->lines[n])) {
+      ++n;
+    }
+    chunk->num_lines = n;
+    chunk->last = n < kChunkLines;
+    line_number += n;
+    parse_queue.push(chunk);
+    if (chunk->last) {
+      break;
+    }
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    parse_queue.push(NULL);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    parsers[i].join();
+  }
+  writer.join();
+  delete db;
+  LOG(INFO) << "Converted " << num_records << " records from " << argv[2]
+      << " to " << argv[3];
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Drives a data layer on its own to measure how fast it can serve batches,
+// for sizing decode_threads, prefetch_count and the number of shards (one
+// reader thread each) before a training run.
+// Usage:
+//    data_layer_benchmark layer_param [iterations [decode_threads
+//        [compute_ms]]]
+//
+// layer_param is a text LayerParameter of a data layer, as it appears in a
+// net definition. decode_threads is a comma separated list of pool sizes to
+// try, 1,2,4,8 by default. compute_ms makes every iteration also sleep that
+// long after Forward, to stand in for the rest of a training step: if the
+// layer still waits on prefetch then, training at that speed is I/O-bound.
+// Every run starts with a few warm-up batches that are not counted.
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/io.hpp"
+#include "caffe/vision_layers.hpp"
+
+using caffe::Blob;
+using caffe::Caffe;
+using caffe::DataLayer;
+using caffe::DataLayerStats;
+using caffe::LayerParameter;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock bench_clock;
+
+vector<int> ParseThreadList(const string& list) {
+  vector<int> threads;
+  std::istringstream stream(list);
+  string item;
+  while (std::getline(stream, item, ',')) {
+    threads.push_back(atoi(item.c_str()));
+    CHECK_GT(threads.back(), 0) << "Bad decode_threads " << item;
+  }
+  return threads;
+}
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  if (argc < 2 || argc > 5) {
+    LOG(ERROR) << "Usage: data_layer_benchmark layer_param "
+        << "[iterations [decode_threads [compute_ms]]]";
+    return 1;
+  }
+  LayerParameter param;
+  caffe::ReadProtoFromTextFile(argv[1], &param);
+  const int iterations = argc > 2 ? atoi(argv[2]) : 1000;
+  const vector<int> thread_counts = ParseThreadList(argc > 3 ? argv[3] :
+      "1,2,4,8");
+  const int compute_ms = argc > 4 ? atoi(argv[4]) : 0;
+  CHECK_GT(iterations, 0);
+  const int warm_up = std::max(1, std::min(10, iterations / 10));
+  Caffe::set_mode(Caffe::CPU);
+  Caffe::set_phase(Caffe::TRAIN);
+
+  LOG(INFO) << "Benchmarking " << param.source() << " for " << iterations
+      << " batches of " << param.batchsize() << ", " << compute_ms
+      << " ms of compute per step";
+  for (int t = 0; t < thread_counts.size(); ++t) {
+    param.set_decode_threads(thread_counts[t]);
+    // The query id top is needed by query_batching.
+    const int num_tops = param.query_batching() ? 3 : 2;
+    vector<Blob<float>*> bottom;
+    vector<Blob<float>*> top;
+    for (int i = 0; i < num_tops; ++i) {
+      top.push_back(new Blob<float>());
+    }
+    {
+      DataLayer<float> layer(param);
+      layer.SetUp(bottom, &top);
+      for (int i = 0; i < warm_up; ++i) {
+        layer.Forward(bottom, &top);
+      }
+      layer.ResetStats();
+      const bench_clock::time_point start = bench_clock::now();
+      for (int i = 0; i < iterations; ++i) {
+        layer.Forward(bottom, &top);
+        if (compute_ms) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(compute_ms));
+        }
+      }
+      const double seconds = std::chrono::duration<double>(
+          bench_clock::now() - start).count();
+      // The prefetch thread may have loaded a few batches more than were
+      // served, so the per batch times use its own count.
+      const DataLayerStats stats = layer.stats();
+      const double batches = std::max<int64_t>(stats.batches, 1);
+      LOG(INFO) << "decode_threads " << thread_counts[t] << ": "
+          << iterations / seconds << " batches/s, "
+          << stats.records / seconds << " records/s, "
+          << stats.bytes / seconds / 1048576 << " MB/s, waited "
+          << 100 * stats.wait_seconds / seconds << "% of the time";
+      LOG(INFO) << "    per batch: read "
+          << 1e3 * stats.read_seconds / batches << " ms, parse "
+          << 1e3 * stats.parse_seconds / batches << " ms, normalize "
+          << 1e3 * stats.normalize_seconds / batches << " ms (summed over "
+          << "workers), copy " << 1e3 * stats.copy_seconds / iterations
+          << " ms";
+    }
+    for (int i = 0; i < num_tops; ++i) {
+      delete top[i];
+    }
+  }
+  return 0;
+}
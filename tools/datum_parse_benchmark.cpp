@@ -0,0 +1,82 @@
+// Measures how fast Datum records can be parsed out of a leveldb, comparing
+// the old path that copies every value into a temporary string and parses
+// it into a fresh Datum with parsing straight from the leveldb slice into a
+// reused Datum, as the data layer does now.
+// Usage:
+//    datum_parse_benchmark input_leveldb [max_records]
+
+#include <glog/logging.h>
+#include <leveldb/db.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "caffe/proto/caffe.pb.h"
+
+using caffe::Datum;
+using std::string;
+
+typedef std::chrono::steady_clock bench_clock;
+
+// Returns the number of records parsed. The checksum keeps the compiler from
+// dropping the parse.
+template <bool kFromSlice>
+long ParseRecords(leveldb::DB* db, const long max_records, double* checksum) {
+  leveldb::Iterator* iter = db->NewIterator(leveldb::ReadOptions());
+  Datum reused_datum;
+  long count = 0;
+  for (iter->SeekToFirst(); iter->Valid() && count < max_records;
+      iter->Next(), ++count) {
+    if (kFromSlice) {
+      CHECK(reused_datum.ParseFromArray(iter->value().data(),
+          iter->value().size()));
+      *checksum += reused_datum.float_data_size() + reused_datum.data().size();
+    } else {
+      Datum datum;
+      datum.ParseFromString(iter->value().ToString());
+      *checksum += datum.float_data_size() + datum.data().size();
+    }
+  }
+  delete iter;
+  return count;
+}
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  if (argc < 2 || argc > 3) {
+    LOG(ERROR) << "Usage: datum_parse_benchmark input_leveldb [max_records]";
+    return 0;
+  }
+  const long max_records = (argc == 3) ? atol(argv[2]) : 1000000;
+
+  leveldb::DB* db;
+  leveldb::Options options;
+  options.create_if_missing = false;
+  LOG(INFO) << "Opening leveldb " << argv[1];
+  leveldb::Status status = leveldb::DB::Open(options, argv[1], &db);
+  CHECK(status.ok()) << "Failed to open leveldb " << argv[1];
+
+  double checksum = 0;
+  // Warm the block cache so both passes read from memory.
+  ParseRecords<true>(db, max_records, &checksum);
+
+  bench_clock::time_point start = bench_clock::now();
+  const long copied = ParseRecords<false>(db, max_records, &checksum);
+  const double copy_seconds = std::chrono::duration<double>(
+      bench_clock::now() - start).count();
+
+  start = bench_clock::now();
+  const long sliced = ParseRecords<true>(db, max_records, &checksum);
+  const double slice_seconds = std::chrono::duration<double>(
+      bench_clock::now() - start).count();
+
+  LOG(INFO) << "ToString + ParseFromString: " << copied << " records, "
+      << copied / copy_seconds << " records/sec";
+  LOG(INFO) << "ParseFromArray, reused Datum: " << sliced << " records, "
+      << sliced / slice_seconds << " records/sec";
+  LOG(INFO) << "Speedup: " << copy_seconds / slice_seconds << "x"
+      << " (checksum " << checksum << ")";
+  delete db;
+  return 0;
+}
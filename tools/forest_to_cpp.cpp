@@ -0,0 +1,75 @@
+// Writes the trained forests of a forest layer as a C++ source file, every
+// tree a function of nested comparisons against constant thresholds, so
+// that the compiler sees the whole model.
+// Usage:
+//    forest_to_cpp trained_net output_cpp [layer_name]
+//
+// trained_net is a binary NetParameter snapshot. Without layer_name it has
+// to hold a single layer with forests. Built as a shared library, e.g.
+//    g++ -O2 -shared -fPIC output_cpp -o forest.so
+// the source exports, as extern "C":
+//    void score(const float* features, float* out)
+//        out[f] = the score of forest f for one row of features
+//    void score_rows(const float* features, int num, int dim, float* out)
+//        the same for num rows dim apart, out[i * num_outputs + f]
+//    int score_num_features()
+//    int score_num_outputs()
+// which util/compiled_forest.cpp loads.
+// score_rows runs each tree over a block of rows before the next, so that
+// the code of a tree stays in the instruction cache: the code of a large
+// forest is megabytes.
+//
+// A row goes left at a node when x[feature_split] <= value_split, and the
+// score of a forest is init_pred + learning_rate * the sum of the leaf
+// predictions of its trees, as in the other engines.
+
+#include <glog/logging.h>
+
+#include <cstdio>
+
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/forest_to_cpp.hpp"
+#include "caffe/util/io.hpp"
+
+using caffe::LayerConnection;
+using caffe::LayerParameter;
+using caffe::NetParameter;
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  if (argc != 3 && argc != 4) {
+    LOG(ERROR) << "Usage: forest_to_cpp trained_net output_cpp [layer_name]";
+    return 1;
+  }
+  // The layers are read one at a time, keeping only the one to write.
+  LayerConnection connection;
+  LayerParameter layer;
+  int num_forest_layers = 0;
+  caffe::ReadRepeatedProtoFromBinaryFile(argv[1],
+      NetParameter::kLayersFieldNumber, &connection, [&]() {
+    const LayerParameter& param = connection.layer();
+    if (argc == 4 ? param.name() == argv[3] : param.forests_size() > 0) {
+      ++num_forest_layers;
+      layer.Swap(connection.mutable_layer());
+    }
+  });
+  if (argc == 4) {
+    CHECK_EQ(num_forest_layers, 1) << "No single layer " << argv[3];
+  } else {
+    CHECK_EQ(num_forest_layers, 1) << "Found " << num_forest_layers
+        << " layers with forests, give the layer_name to write";
+  }
+  CHECK_GT(layer.forests_size(), 0) << "No forests in layer " << layer.name();
+
+  FILE* file = fopen(argv[2], "w");
+  CHECK(file) << "Cannot write " << argv[2];
+  caffe::WriteForests(file, argv[1], layer);
+  CHECK_EQ(fclose(file), 0) << "Cannot write " << argv[2];
+  int num_trees = 0;
+  for (int f = 0; f < layer.forests_size(); ++f) {
+    num_trees += layer.forests(f).trees_size();
+  }
+  LOG(INFO) << "Wrote " << layer.forests_size() << " forests of " << num_trees
+      << " trees in layer " << layer.name() << " to " << argv[2];
+  return 0;
+}
@@ -0,0 +1,153 @@
+// Rewrites a leveldb of float Datum records with quantized features.
+// Usage:
+//    quantize_leveldb input_leveldb output_leveldb uint8 quantization_file
+//    quantize_leveldb input_leveldb output_leveldb fp16
+//    quantize_leveldb input_leveldb output_leveldb fp32
+//
+// uint8 maps every feature linearly onto [0, 255] between its smallest and
+// largest value over the whole leveldb, and writes the per-feature scale and
+// offset to quantization_file, to be given to the data layer with the
+// quantization_file parameter. fp16 stores every feature as a half float in
+// half_data and needs no side file. fp32 keeps the features as they are and
+// only rewrites the records with float_data packed, which datasets written
+// before it was are not; the data layer copies packed features straight into
+// its batches. Keys, labels and group ids are kept.
+
+#include <glog/logging.h>
+#include <leveldb/db.h>
+#include <leveldb/write_batch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/dequantize.hpp"
+#include "caffe/util/io.hpp"
+
+using caffe::BlobProto;
+using caffe::Datum;
+using std::string;
+using std::vector;
+
+const int kWriteBatchSize = 1000;
+
+leveldb::DB* OpenLevelDB(const char* path, const bool create) {
+  leveldb::DB* db;
+  leveldb::Options options;
+  options.create_if_missing = create;
+  options.error_if_exists = create;
+  options.write_buffer_size = 268435456;
+  leveldb::Status status = leveldb::DB::Open(options, path, &db);
+  CHECK(status.ok()) << "Failed to open leveldb " << path << std::endl
+      << status.ToString();
+  return db;
+}
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  const bool uint8 = argc == 5 && strcmp(argv[3], "uint8") == 0;
+  const bool fp16 = argc == 4 && strcmp(argv[3], "fp16") == 0;
+  const bool fp32 = argc == 4 && strcmp(argv[3], "fp32") == 0;
+  if (!uint8 && !fp16 && !fp32) {
+    LOG(ERROR) << "Usage: quantize_leveldb input_leveldb output_leveldb "
+        << "uint8 quantization_file | fp16 | fp32";
+    return 1;
+  }
+
+  leveldb::DB* input = OpenLevelDB(argv[1], false);
+  leveldb::Iterator* iter = input->NewIterator(leveldb::ReadOptions());
+  Datum datum;
+  int size = 0;
+  vector<float> scale;
+  vector<float> offset;
+  if (uint8) {
+    // The range of every feature
+    vector<float> low;
+    vector<float> high;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      CHECK(datum.ParseFromArray(iter->value().data(), iter->value().size()));
+      if (low.empty()) {
+        size = datum.channels() * datum.height() * datum.width();
+        low.assign(datum.float_data().begin(), datum.float_data().end());
+        high = low;
+      }
+      CHECK_EQ(datum.float_data_size(), size) << "Expected float features";
+      for (int j = 0; j < size; ++j) {
+        low[j] = std::min(low[j], datum.float_data(j));
+        high[j] = std::max(high[j], datum.float_data(j));
+      }
+    }
+    CHECK(size) << "Empty leveldb " << argv[1];
+    scale.resize(size);
+    offset = low;
+    for (int j = 0; j < size; ++j) {
+      scale[j] = high[j] > low[j] ? (high[j] - low[j]) / 255 : 1;
+    }
+
+    BlobProto quantization;
+    quantization.set_num(2);
+    quantization.set_channels(datum.channels());
+    quantization.set_height(datum.height());
+    quantization.set_width(datum.width());
+    for (int j = 0; j < size; ++j) {
+      quantization.add_data(scale[j]);
+    }
+    for (int j = 0; j < size; ++j) {
+      quantization.add_data(offset[j]);
+    }
+    caffe::WriteProtoToBinaryFile(quantization, argv[4]);
+    LOG(INFO) << "Wrote the quantization of " << size << " features to "
+        << argv[4];
+  }
+
+  leveldb::DB* output = OpenLevelDB(argv[2], true);
+  leveldb::WriteBatch* batch = new leveldb::WriteBatch();
+  string value;
+  string features;
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    CHECK(datum.ParseFromArray(iter->value().data(), iter->value().size()));
+    if (!size) {
+      size = datum.channels() * datum.height() * datum.width();
+    }
+    CHECK_EQ(datum.float_data_size(), size) << "Expected float features";
+    if (uint8) {
+      features.resize(size);
+      for (int j = 0; j < size; ++j) {
+        const float q = floor((datum.float_data(j) - offset[j]) / scale[j]
+            + 0.5f);
+        features[j] = static_cast<char>(std::min(255.f, std::max(0.f, q)));
+      }
+      datum.set_data(features);
+    } else if (fp16) {
+      features.resize(2 * size);
+      for (int j = 0; j < size; ++j) {
+        const uint16_t half = caffe::caffe_float_to_half(datum.float_data(j));
+        features[2 * j] = static_cast<char>(half & 0xff);
+        features[2 * j + 1] = static_cast<char>(half >> 8);
+      }
+      datum.set_half_data(features);
+    }
+    if (!fp32) {
+      datum.clear_float_data();
+    }
+    datum.SerializeToString(&value);
+    batch->Put(iter->key(), value);
+    if (++count % kWriteBatchSize == 0) {
+      output->Write(leveldb::WriteOptions(), batch);
+      delete batch;
+      batch = new leveldb::WriteBatch();
+      LOG(INFO) << "Quantized " << count << " records";
+    }
+  }
+  output->Write(leveldb::WriteOptions(), batch);
+  delete batch;
+  delete iter;
+  delete output;
+  delete input;
+  LOG(INFO) << "Quantized " << count << " records to " << argv[2];
+  return 0;
+}
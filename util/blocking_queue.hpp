@@ -0,0 +1,39 @@
+#ifndef CAFFE_UTIL_BLOCKING_QUEUE_H_
+#define CAFFE_UTIL_BLOCKING_QUEUE_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+
+namespace caffe {
+
+// A simple blocking queue. pop() waits until some other thread has pushed.
+template <typename T>
+class BlockingQueue {
+ public:
+  void push(const T& t) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push(t);
+    lock.unlock();
+    condition_.notify_one();
+  }
+
+  T pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (queue_.empty()) {
+      condition_.wait(lock);
+    }
+    T t = queue_.front();
+    queue_.pop();
+    return t;
+  }
+
+ private:
+  std::queue<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_BLOCKING_QUEUE_H_
@@ -0,0 +1,88 @@
+// A forest compiled to native code: a shared library built from the source
+// that tools/forest_to_cpp writes, loaded at run time. Its score_rows()
+// takes rows of float features and writes one score per forest and row, so
+// only float rows can be scored. Like QuickScorer it waits for the forest
+// layer, which is not part of this tree, to load it; nothing in the net or
+// solver does yet.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include <string>
+
+#include "caffe/common.hpp"
+#include "caffe/util/compiled_forest.hpp"
+
+namespace caffe {
+
+CompiledForest::CompiledForest()
+    : library_(NULL), score_rows_(NULL), num_features_(0), num_outputs_(0) {}
+
+CompiledForest::~CompiledForest() {
+  Unload();
+}
+
+void CompiledForest::Unload() {
+  if (library_) {
+#ifdef _WIN32
+    FreeLibrary(reinterpret_cast<HMODULE>(library_));
+#else
+    dlclose(library_);
+#endif
+  }
+  library_ = NULL;
+  score_rows_ = NULL;
+}
+
+void* CompiledForest::Symbol(const string& filename, const char* name) {
+#ifdef _WIN32
+  void* symbol = reinterpret_cast<void*>(GetProcAddress(
+      reinterpret_cast<HMODULE>(library_), name));
+  CHECK(symbol) << "No " << name << " in " << filename;
+#else
+  void* symbol = dlsym(library_, name);
+  CHECK(symbol) << "No " << name << " in " << filename << ": " << dlerror();
+#endif
+  return symbol;
+}
+
+void CompiledForest::Load(const string& filename) {
+  Unload();
+#ifdef _WIN32
+  library_ = reinterpret_cast<void*>(LoadLibraryA(filename.c_str()));
+  CHECK(library_) << "Cannot load " << filename;
+#else
+  library_ = dlopen(filename.c_str(), RTLD_NOW | RTLD_LOCAL);
+  CHECK(library_) << "Cannot load " << filename << ": " << dlerror();
+#endif
+  typedef int (*CountFunction)();
+  num_features_ = reinterpret_cast<CountFunction>(
+      Symbol(filename, "score_num_features"))();
+  num_outputs_ = reinterpret_cast<CountFunction>(
+      Symbol(filename, "score_num_outputs"))();
+  score_rows_ = reinterpret_cast<ScoreRowsFunction>(
+      Symbol(filename, "score_rows"));
+  CHECK_GT(num_outputs_, 0) << "No forests in " << filename;
+}
+
+template <>
+void CompiledForest::Predict<float>(const float* data, const int num,
+    const int dim, float* out) const {
+  CHECK(score_rows_) << "No forest loaded";
+  CHECK(num_features_ == 0 || dim == num_features_)
+      << "Expected " << num_features_ << " features";
+  score_rows_(data, num, dim, out);
+}
+
+// Rounded to float, a double feature next to a threshold can go the other
+// way than in FlatForest::Predict<double>, so double rows are refused.
+template <>
+void CompiledForest::Predict<double>(const double* data, const int num,
+    const int dim, double* out) const {
+  LOG(FATAL) << "A compiled forest only scores float features";
+}
+
+}  // namespace caffe
@@ -0,0 +1,158 @@
+#include <stdint.h>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#include "caffe/common.hpp"
+#include "caffe/util/dequantize.hpp"
+
+// MSVC has no __F16C__, but every CPU with AVX2 also has F16C.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define CAFFE_HAS_F16C
+#endif
+
+namespace caffe {
+
+// Every kernel computes y[j] = x[j] * scale[j] + shift[j]. The float
+// versions run 8 features at a time when the build targets AVX2 (uint8) or
+// F16C (fp16); everything else, and the tails, go through the scalar loops.
+
+float caffe_half_to_float(const uint16_t h) {
+  const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  uint32_t exponent = (h >> 10) & 0x1f;
+  uint32_t mantissa = h & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    // inf or nan
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent) {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa) {
+    // subnormal: renormalize
+    exponent = 113;
+    while (!(mantissa & 0x400)) {
+      mantissa <<= 1;
+      --exponent;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  } else {
+    bits = sign;
+  }
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+uint16_t caffe_float_to_half(const float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const uint32_t abs = bits & 0x7fffffff;
+  if (abs >= 0x7f800000) {
+    // inf stays inf, nan stays a quiet nan
+    return sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0);
+  }
+  if (abs >= 0x477ff000) {
+    // rounds past the largest half
+    return sign | 0x7c00;
+  }
+  if (abs < 0x38800000) {
+    // subnormal half, or zero
+    if (abs < 0x33000000) {
+      return sign;
+    }
+    const uint32_t shift = 126 - (abs >> 23);
+    const uint32_t mantissa = (abs & 0x7fffff) | 0x800000;
+    uint32_t half = mantissa >> shift;
+    const uint32_t rest = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1))) {
+      ++half;
+    }
+    return sign | half;
+  }
+  // Round to nearest even; a carry into the exponent is still correct.
+  const uint32_t rounded = abs + 0xfff + ((abs >> 13) & 1);
+  return sign | ((rounded - 0x38000000) >> 13);
+}
+
+template <>
+void caffe_dequantize_uint8<float>(const int n, const uint8_t* x,
+    const float* scale, const float* shift, float* y) {
+  int j = 0;
+#ifdef __AVX2__
+  for (; j + 8 <= n; j += 8) {
+    const __m128i bytes =
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + j));
+    const __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    _mm256_storeu_ps(y + j, _mm256_add_ps(
+        _mm256_mul_ps(v, _mm256_loadu_ps(scale + j)),
+        _mm256_loadu_ps(shift + j)));
+  }
+#endif
+  for (; j < n; ++j) {
+    y[j] = x[j] * scale[j] + shift[j];
+  }
+}
+
+template <>
+void caffe_dequantize_uint8<double>(const int n, const uint8_t* x,
+    const double* scale, const double* shift, double* y) {
+  for (int j = 0; j < n; ++j) {
+    y[j] = x[j] * scale[j] + shift[j];
+  }
+}
+
+template <>
+void caffe_dequantize_half<float>(const int n, const uint16_t* x,
+    const float* scale, const float* shift, float* y) {
+  int j = 0;
+#ifdef CAFFE_HAS_F16C
+  for (; j + 8 <= n; j += 8) {
+    const __m256 v = _mm256_cvtph_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + j)));
+    _mm256_storeu_ps(y + j, _mm256_add_ps(
+        _mm256_mul_ps(v, _mm256_loadu_ps(scale + j)),
+        _mm256_loadu_ps(shift + j)));
+  }
+#endif
+  for (; j < n; ++j) {
+    y[j] = caffe_half_to_float(x[j]) * scale[j] + shift[j];
+  }
+}
+
+template <>
+void caffe_dequantize_half<double>(const int n, const uint16_t* x,
+    const double* scale, const double* shift, double* y) {
+  for (int j = 0; j < n; ++j) {
+    y[j] = caffe_half_to_float(x[j]) * scale[j] + shift[j];
+  }
+}
+
+template <>
+void caffe_dequantize_float<float>(const int n, const float* x,
+    const float* scale, const float* shift, float* y) {
+  int j = 0;
+#ifdef __AVX2__
+  for (; j + 8 <= n; j += 8) {
+    _mm256_storeu_ps(y + j, _mm256_add_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(x + j), _mm256_loadu_ps(scale + j)),
+        _mm256_loadu_ps(shift + j)));
+  }
+#endif
+  for (; j < n; ++j) {
+    y[j] = x[j] * scale[j] + shift[j];
+  }
+}
+
+template <>
+void caffe_dequantize_float<double>(const int n, const float* x,
+    const double* scale, const double* shift, double* y) {
+  for (int j = 0; j < n; ++j) {
+    y[j] = x[j] * scale[j] + shift[j];
+  }
+}
+
+}  // namespace caffe
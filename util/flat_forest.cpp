@@ -0,0 +1,106 @@
+// The compiled inference form of a ForestProto. The nodes of all trees are
+// laid out in one array of 12 byte FlatTreeNodes, each tree breadth first
+// with the two children of a node next to each other, so that a step down
+// a tree is one load and an add: the right child follows the left one.
+//
+// A sample goes left at a node when x[feature_split] <= value_split. The
+// score of a forest is init_pred + learning_rate * the sum of the leaf
+// predictions of its trees.
+
+#include <algorithm>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/flat_forest.hpp"
+
+namespace caffe {
+
+// Rows are scored in blocks of this many, tree by tree, so that a tree
+// stays in cache across a block.
+const int kFlatForestBlock = 64;
+
+FlatForest::FlatForest() : init_pred_(0), learning_rate_(1), dim_(0) {}
+
+void FlatForest::Build(const ForestProto& forest) {
+  init_pred_ = forest.init_pred();
+  learning_rate_ = forest.learning_rate();
+  dim_ = forest.dim();
+  nodes_.clear();
+  roots_.clear();
+  for (int t = 0; t < forest.trees_size(); ++t) {
+    AddTree(forest.trees(t));
+  }
+}
+
+void FlatForest::AddTree(const TreeProto& tree) {
+  CHECK_GT(tree.tree_nodes_size(), 0) << "Empty tree";
+  const int root = nodes_.size();
+  roots_.push_back(root);
+  // The source node of every flat node, in breadth first order
+  vector<int> order(1, 0);
+  nodes_.push_back(FlatTreeNode());
+  for (int k = 0; k < order.size(); ++k) {
+    const TreeNodeProto& source = tree.tree_nodes(order[k]);
+    FlatTreeNode& node = nodes_[root + k];
+    if (source.leaf()) {
+      node.feature = -1;
+      node.value = source.pred();
+      node.left = 0;
+      continue;
+    }
+    CHECK(dim_ == 0 || source.feature_split() < dim_)
+        << "Split on feature " << source.feature_split() << " of " << dim_;
+    CHECK_LT(source.left_child(), tree.tree_nodes_size());
+    CHECK_LT(source.right_child(), tree.tree_nodes_size());
+    node.feature = source.feature_split();
+    node.value = source.value_split();
+    node.left = root + order.size();
+    order.push_back(source.left_child());
+    order.push_back(source.right_child());
+    CHECK_LE(order.size(), tree.tree_nodes_size()) << "Not a tree";
+    // This may move the nodes, and with them node.
+    nodes_.resize(root + order.size());
+  }
+}
+
+template <typename Dtype>
+float FlatForest::PredictTree(const int tree, const Dtype* x) const {
+  const FlatTreeNode* nodes = &nodes_[0];
+  int n = roots_[tree];
+  while (nodes[n].feature >= 0) {
+    n = nodes[n].left + (x[nodes[n].feature] > nodes[n].value);
+  }
+  return nodes[n].value;
+}
+
+template <typename Dtype>
+void FlatForest::Predict(const Dtype* data, const int num, const int dim,
+    Dtype* out) const {
+  CHECK(dim_ == 0 || dim == dim_) << "Expected " << dim_ << " features";
+  const int num_trees = roots_.size();
+  for (int begin = 0; begin < num; begin += kFlatForestBlock) {
+    const int end = std::min(num, begin + kFlatForestBlock);
+    float sums[kFlatForestBlock] = {0};
+    for (int t = 0; t < num_trees; ++t) {
+      for (int i = begin; i < end; ++i) {
+        sums[i - begin] += PredictTree(t, data +
+            static_cast<size_t>(i) * dim);
+      }
+    }
+    for (int i = begin; i < end; ++i) {
+      out[i] = init_pred_ + learning_rate_ * sums[i - begin];
+    }
+  }
+}
+
+template float FlatForest::PredictTree<float>(const int tree,
+    const float* x) const;
+template float FlatForest::PredictTree<double>(const int tree,
+    const double* x) const;
+template void FlatForest::Predict<float>(const float* data, const int num,
+    const int dim, float* out) const;
+template void FlatForest::Predict<double>(const double* data, const int num,
+    const int dim, double* out) const;
+
+}  // namespace caffe
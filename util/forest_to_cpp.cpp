@@ -0,0 +1,122 @@
+// Writes the trained forests of a forest layer as C++ source for
+// tools/forest_to_cpp: every tree a function of nested comparisons against
+// float literals, and the extern "C" score functions that
+// util/compiled_forest.cpp loads.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "caffe/common.hpp"
+#include "caffe/util/forest_to_cpp.hpp"
+
+namespace caffe {
+
+// The rows score_rows runs each tree over at a time
+const int kRowBlock = 64;
+
+// A float literal that reads back as exactly value.
+string FloatLiteral(const float value) {
+  CHECK(std::isfinite(value)) << "Cannot write " << value;
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.9g", value);
+  string literal(buffer);
+  if (literal.find_first_of(".e") == string::npos) {
+    literal += ".";
+  }
+  return literal + "f";
+}
+
+void WriteTreeNode(FILE* file, const TreeProto& tree, const int n,
+    const int depth, const int dim) {
+  CHECK_LT(depth, tree.tree_nodes_size()) << "Not a tree";
+  CHECK_LT(n, tree.tree_nodes_size());
+  const TreeNodeProto& node = tree.tree_nodes(n);
+  const string indent(2 * depth + 2, ' ');
+  if (node.leaf()) {
+    fprintf(file, "%sreturn %s;\n", indent.c_str(),
+        FloatLiteral(node.pred()).c_str());
+    return;
+  }
+  CHECK(dim == 0 || static_cast<int>(node.feature_split()) < dim)
+      << "Split on feature " << node.feature_split() << " of " << dim;
+  fprintf(file, "%sif (x[%d] <= %s) {\n", indent.c_str(),
+      node.feature_split(), FloatLiteral(node.value_split()).c_str());
+  WriteTreeNode(file, tree, node.left_child(), depth + 1, dim);
+  fprintf(file, "%s} else {\n", indent.c_str());
+  WriteTreeNode(file, tree, node.right_child(), depth + 1, dim);
+  fprintf(file, "%s}\n", indent.c_str());
+}
+
+void WriteForests(FILE* file, const char* net_filename,
+    const LayerParameter& layer) {
+  int dim = 0;
+  for (int f = 0; f < layer.forests_size(); ++f) {
+    const ForestProto& forest = layer.forests(f);
+    CHECK(dim == 0 || static_cast<int>(forest.dim()) == dim)
+        << "Forests differ in dim";
+    CHECK_GT(forest.trees_size(), 0) << "No trees in forest " << f;
+    dim = forest.dim();
+  }
+  fprintf(file, "// Generated by forest_to_cpp from layer %s of %s.\n\n",
+      layer.name().c_str(), net_filename);
+  fprintf(file, "#ifdef _WIN32\n"
+      "#define FOREST_EXPORT extern \"C\" __declspec(dllexport)\n"
+      "#else\n"
+      "#define FOREST_EXPORT extern \"C\"\n"
+      "#endif\n\n"
+      "typedef float (*TreeFunction)(const float* x);\n");
+  for (int f = 0; f < layer.forests_size(); ++f) {
+    const ForestProto& forest = layer.forests(f);
+    for (int t = 0; t < forest.trees_size(); ++t) {
+      CHECK_GT(forest.trees(t).tree_nodes_size(), 0) << "Empty tree";
+      fprintf(file, "\nstatic float forest%d_tree%d(const float* x) {\n", f,
+          t);
+      // A single leaf does not read x.
+      if (forest.trees(t).tree_nodes(0).leaf()) {
+        fprintf(file, "  (void)x;\n");
+      }
+      WriteTreeNode(file, forest.trees(t), 0, 0, dim);
+      fprintf(file, "}\n");
+    }
+  }
+  for (int f = 0; f < layer.forests_size(); ++f) {
+    const ForestProto& forest = layer.forests(f);
+    fprintf(file, "\nstatic const TreeFunction forest%d_trees[] = {\n", f);
+    for (int t = 0; t < forest.trees_size(); ++t) {
+      fprintf(file, "  forest%d_tree%d,\n", f, t);
+    }
+    fprintf(file, "};\n");
+  }
+  fprintf(file, "\nFOREST_EXPORT int score_num_features() {\n"
+      "  return %d;\n}\n", dim);
+  fprintf(file, "\nFOREST_EXPORT int score_num_outputs() {\n"
+      "  return %d;\n}\n", layer.forests_size());
+  fprintf(file, "\nFOREST_EXPORT void score_rows(const float* x, int num, "
+      "int dim,\n    float* out) {\n"
+      "  for (int begin = 0; begin < num; begin += %d) {\n"
+      "    const int end = begin + %d < num ? begin + %d : num;\n",
+      kRowBlock, kRowBlock, kRowBlock);
+  for (int f = 0; f < layer.forests_size(); ++f) {
+    const ForestProto& forest = layer.forests(f);
+    fprintf(file, "    {\n"
+        "      float sums[%d] = {0};\n"
+        "      for (int t = 0; t < %d; ++t) {\n"
+        "        const TreeFunction tree = forest%d_trees[t];\n"
+        "        for (int i = begin; i < end; ++i) {\n"
+        "          sums[i - begin] += tree(x + static_cast<long>(i) * dim);\n"
+        "        }\n"
+        "      }\n"
+        "      for (int i = begin; i < end; ++i) {\n"
+        "        out[i * %d + %d] = %s + %s * sums[i - begin];\n"
+        "      }\n"
+        "    }\n", kRowBlock, forest.trees_size(), f,
+        layer.forests_size(), f, FloatLiteral(forest.init_pred()).c_str(),
+        FloatLiteral(forest.learning_rate()).c_str());
+  }
+  fprintf(file, "  }\n}\n");
+  fprintf(file, "\nFOREST_EXPORT void score(const float* x, float* out) {\n"
+      "  score_rows(x, 1, 0, out);\n}\n");
+}
+
+}  // namespace caffe
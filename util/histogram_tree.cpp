@@ -0,0 +1,387 @@
+// Regression trees for the forest layer grown from histograms of pre-binned
+// features. Every feature is quantized once into at most kMaxFeatureBins
+// bins, and a node finds its split by summing the gradients and hessians of
+// its samples per bin and scanning the bins, instead of sorting the sample
+// values of every feature. A level then costs O(samples x features) and the
+// features take a byte per value. A split builds the histogram of the
+// smaller child only and takes the larger child's as the parent's less it;
+// the histograms of the open leaves come from a pool that the trees of a
+// forest share.
+//
+// A sample goes left at a node when x[feature_split] <= value_split. The
+// thresholds are bin bounds: bin b of feature j holds the values in
+// (bounds[j][b - 1], bounds[j][b]].
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/histogram_tree.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void FitFeatureBins(const Dtype* data, const int num, const int dim,
+    const int max_bins, vector<vector<float> >* bounds) {
+  CHECK_GT(num, 0);
+  CHECK_GT(max_bins, 1);
+  CHECK_LE(max_bins, kMaxFeatureBins);
+  bounds->resize(dim);
+  vector<float> values(num);
+  for (int j = 0; j < dim; ++j) {
+    for (int i = 0; i < num; ++i) {
+      values[i] = data[static_cast<size_t>(i) * dim + j];
+    }
+    std::sort(values.begin(), values.end());
+    int distinct = 1;
+    for (int i = 1; i < num; ++i) {
+      distinct += values[i] != values[i - 1];
+    }
+    vector<float>& bound = (*bounds)[j];
+    bound.clear();
+    if (distinct <= max_bins) {
+      // Every value gets a bin of its own.
+      for (int i = 0; i + 1 < num; ++i) {
+        if (values[i] != values[i + 1]) {
+          bound.push_back(values[i]);
+        }
+      }
+    } else {
+      // Bins of about equal counts. A value repeated across several of them
+      // closes only the first.
+      for (int b = 1; b < max_bins; ++b) {
+        const float value = values[static_cast<int64_t>(b) * num / max_bins];
+        if ((bound.empty() || value > bound.back()) &&
+            value < values[num - 1]) {
+          bound.push_back(value);
+        }
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void BinFeatures(const Dtype* data, const int num, const int dim,
+    const vector<vector<float> >& bounds, uint8_t* bins) {
+  CHECK_EQ(bounds.size(), dim);
+  for (int i = 0; i < num; ++i) {
+    const Dtype* row = data + static_cast<size_t>(i) * dim;
+    uint8_t* row_bins = bins + static_cast<size_t>(i) * dim;
+    for (int j = 0; j < dim; ++j) {
+      const vector<float>& bound = bounds[j];
+      row_bins[j] = std::lower_bound(bound.begin(), bound.end(),
+          static_cast<float>(row[j])) - bound.begin();
+    }
+  }
+}
+
+void FeatureBinOffsets(const vector<vector<float> >& bounds,
+    vector<int>* offsets) {
+  const int dim = bounds.size();
+  offsets->resize(dim + 1);
+  (*offsets)[0] = 0;
+  for (int j = 0; j < dim; ++j) {
+    (*offsets)[j + 1] = (*offsets)[j] + bounds[j].size() + 1;
+  }
+}
+
+template <typename Dtype>
+void BuildHistogram(const uint8_t* bins, const int dim,
+    const vector<int>& offsets, const vector<int>& features,
+    const int* samples, const int num_samples, const Dtype* grad,
+    const Dtype* hess, HistogramBin* hist) {
+  std::fill(hist, hist + offsets[dim], HistogramBin());
+  const int num_features = features.size();
+  for (int s = 0; s < num_samples; ++s) {
+    const int i = samples[s];
+    const uint8_t* row = bins + static_cast<size_t>(i) * dim;
+    const double g = grad[i];
+    const double h = hess ? hess[i] : 1;
+    for (int f = 0; f < num_features; ++f) {
+      const int j = features[f];
+      HistogramBin& bin = hist[offsets[j] + row[j]];
+      bin.grad += g;
+      bin.hess += h;
+      ++bin.count;
+    }
+  }
+}
+
+void SubtractHistogram(const vector<int>& offsets,
+    const vector<int>& features, const HistogramBin* child,
+    HistogramBin* parent) {
+  for (int f = 0; f < features.size(); ++f) {
+    const int j = features[f];
+    for (int b = offsets[j]; b < offsets[j + 1]; ++b) {
+      parent[b].grad -= child[b].grad;
+      parent[b].hess -= child[b].hess;
+      parent[b].count -= child[b].count;
+    }
+  }
+}
+
+HistogramPool::HistogramPool(const int capacity)
+    : size_(0), capacity_(capacity) {}
+
+void HistogramPool::SetHistogramSize(const int size) {
+  if (size == size_) {
+    return;
+  }
+  CHECK_EQ(free_.size(), buffers_.size()) << "Histograms still in use";
+  buffers_.clear();
+  free_.clear();
+  size_ = size;
+}
+
+HistogramBin* HistogramPool::Acquire() {
+  if (!free_.empty()) {
+    HistogramBin* hist = free_.back();
+    free_.pop_back();
+    return hist;
+  }
+  if (buffers_.size() >= capacity_) {
+    return NULL;
+  }
+  buffers_.push_back(shared_ptr<vector<HistogramBin> >(
+      new vector<HistogramBin>(size_)));
+  return &(*buffers_.back())[0];
+}
+
+void HistogramPool::Release(HistogramBin* hist) {
+  free_.push_back(hist);
+}
+
+// The decrease of the second order approximation of the loss when the
+// samples of bin take their best common value -grad / hess.
+static inline double HistogramScore(const HistogramBin& bin) {
+  return bin.hess > 0 ? bin.grad * bin.grad / bin.hess : 0;
+}
+
+bool FindBestSplit(const HistogramBin* hist, const vector<int>& offsets,
+    const vector<int>& features, const HistogramBin& total,
+    const int min_leaf_n, HistogramSplit* split) {
+  const double parent = HistogramScore(total);
+  // Gains within rounding of zero are no gains.
+  split->gain = 1e-9 * parent;
+  bool found = false;
+  for (int f = 0; f < features.size(); ++f) {
+    const int j = features[f];
+    HistogramBin left = HistogramBin();
+    // The last bin can only go right.
+    for (int b = offsets[j]; b + 1 < offsets[j + 1]; ++b) {
+      left.grad += hist[b].grad;
+      left.hess += hist[b].hess;
+      left.count += hist[b].count;
+      if (left.count < min_leaf_n) {
+        continue;
+      }
+      HistogramBin right;
+      right.grad = total.grad - left.grad;
+      right.hess = total.hess - left.hess;
+      right.count = total.count - left.count;
+      if (right.count < min_leaf_n) {
+        break;
+      }
+      const double gain = HistogramScore(left) + HistogramScore(right) -
+          parent;
+      if (gain > split->gain) {
+        found = true;
+        split->feature = j;
+        split->bin = b - offsets[j];
+        split->gain = gain;
+        split->left = left;
+        split->right = right;
+      }
+    }
+  }
+  return found;
+}
+
+// A leaf of a growing tree: its node, the range of samples it holds, its
+// best split, if it has one, and its histogram, if the pool had room for it.
+struct GrowingLeaf {
+  int node;
+  int begin;
+  int end;
+  int depth;
+  HistogramBin total;
+  HistogramSplit split;
+  HistogramBin* hist;
+};
+
+// Appends a leaf holding total to the tree and returns its index.
+static int AddTreeLeaf(const HistogramBin& total, TreeProto* tree) {
+  TreeNodeProto* node = tree->add_tree_nodes();
+  node->set_feature_split(0);
+  node->set_value_split(0);
+  node->set_leaf(true);
+  node->set_nsamples(total.count);
+  node->set_left_child(0);
+  node->set_right_child(0);
+  node->set_ini_error(-HistogramScore(total));
+  node->set_best_error(-HistogramScore(total));
+  node->set_pred(total.hess > 0 ? -total.grad / total.hess : 0);
+  return tree->tree_nodes_size() - 1;
+}
+
+template <typename Dtype>
+void GrowHistogramTree(const LayerParameter& param, const uint8_t* bins,
+    const int dim, const vector<vector<float> >& bounds,
+    const vector<int>& features, const Dtype* grad, const Dtype* hess,
+    vector<int>* samples, HistogramPool* pool, TreeProto* tree) {
+  const int num_samples = samples->size();
+  const int max_depth = param.max_depth();
+  const int max_leaf_num = param.max_leaf_num();
+  const int min_leaf_n = std::max<int>(std::max<int>(param.min_leaf_n(),
+      param.min_obs() * num_samples), 1);
+  vector<int> offsets;
+  FeatureBinOffsets(bounds, &offsets);
+  pool->SetHistogramSize(offsets[dim]);
+  // For a histogram the pool has no room for, used and given up at once
+  vector<HistogramBin> scratch(offsets[dim]);
+  tree->Clear();
+
+  // The leaves that may still be split
+  vector<GrowingLeaf> leaves;
+  auto acquire = [&]() {
+    HistogramBin* hist = pool->Acquire();
+    return hist ? hist : &scratch[0];
+  };
+  auto release = [&](HistogramBin* hist) {
+    if (hist != NULL && hist != &scratch[0]) {
+      pool->Release(hist);
+    }
+  };
+  auto may_split = [&](const GrowingLeaf& leaf) {
+    return leaf.depth < max_depth && leaf.end - leaf.begin >= 2 * min_leaf_n;
+  };
+  auto build = [&](const GrowingLeaf& leaf, HistogramBin* hist) {
+    BuildHistogram(bins, dim, offsets, features, &(*samples)[0] + leaf.begin,
+        leaf.end - leaf.begin, grad, hess, hist);
+  };
+  // Finds the split of a leaf from its histogram. A leaf with one keeps the
+  // histogram, if it is not the scratch one, for its children.
+  auto open_leaf = [&](GrowingLeaf* leaf, HistogramBin* hist) {
+    leaf->hist = hist == &scratch[0] ? NULL : hist;
+    if (FindBestSplit(hist, offsets, features, leaf->total, min_leaf_n,
+        &leaf->split)) {
+      leaves.push_back(*leaf);
+    } else {
+      release(leaf->hist);
+    }
+  };
+
+  GrowingLeaf root;
+  root.begin = 0;
+  root.end = num_samples;
+  root.depth = 0;
+  root.total = HistogramBin();
+  for (int s = 0; s < num_samples; ++s) {
+    const int i = (*samples)[s];
+    root.total.grad += grad[i];
+    root.total.hess += hess ? hess[i] : 1;
+    ++root.total.count;
+  }
+  root.node = AddTreeLeaf(root.total, tree);
+  if (may_split(root)) {
+    HistogramBin* hist = acquire();
+    build(root, hist);
+    open_leaf(&root, hist);
+  }
+  // Split the leaf with the largest gain first, until the tree has
+  // max_leaf_num leaves or no leaf gains from a split.
+  for (int num_leaves = 1; num_leaves < max_leaf_num && !leaves.empty();
+      ++num_leaves) {
+    int best = 0;
+    for (int k = 1; k < leaves.size(); ++k) {
+      if (leaves[k].split.gain > leaves[best].split.gain) {
+        best = k;
+      }
+    }
+    const GrowingLeaf parent = leaves[best];
+    leaves[best] = leaves.back();
+    leaves.pop_back();
+    const int feature = parent.split.feature;
+    const int split_bin = parent.split.bin;
+    int* first = &(*samples)[0];
+    const int mid = std::partition(first + parent.begin, first + parent.end,
+        [&](const int i) {
+          return bins[static_cast<size_t>(i) * dim + feature] <= split_bin;
+        }) - first;
+
+    TreeNodeProto* node = tree->mutable_tree_nodes(parent.node);
+    node->set_leaf(false);
+    node->set_feature_split(feature);
+    node->set_value_split(bounds[feature][split_bin]);
+    node->set_left_child(tree->tree_nodes_size());
+    node->set_right_child(tree->tree_nodes_size() + 1);
+    node->set_best_error(-HistogramScore(parent.split.left) -
+        HistogramScore(parent.split.right));
+    GrowingLeaf children[2];
+    for (int c = 0; c < 2; ++c) {
+      children[c].begin = c ? mid : parent.begin;
+      children[c].end = c ? parent.end : mid;
+      children[c].depth = parent.depth + 1;
+      children[c].total = c ? parent.split.right : parent.split.left;
+      children[c].node = AddTreeLeaf(children[c].total, tree);
+    }
+    const int small = mid - parent.begin <= parent.end - mid ? 0 : 1;
+    GrowingLeaf* smaller = &children[small];
+    GrowingLeaf* larger = &children[1 - small];
+    if (parent.hist != NULL && may_split(*larger)) {
+      // Only the smaller child is built. The parent's histogram less the
+      // smaller child's is the larger child's.
+      HistogramBin* hist = acquire();
+      build(*smaller, hist);
+      SubtractHistogram(offsets, features, hist, parent.hist);
+      if (may_split(*smaller)) {
+        open_leaf(smaller, hist);
+      } else {
+        release(hist);
+      }
+      open_leaf(larger, parent.hist);
+    } else {
+      release(parent.hist);
+      for (int c = 0; c < 2; ++c) {
+        if (may_split(children[c])) {
+          HistogramBin* hist = acquire();
+          build(children[c], hist);
+          open_leaf(&children[c], hist);
+        }
+      }
+    }
+  }
+  for (int k = 0; k < leaves.size(); ++k) {
+    release(leaves[k].hist);
+  }
+}
+
+template void FitFeatureBins<float>(const float* data, const int num,
+    const int dim, const int max_bins, vector<vector<float> >* bounds);
+template void FitFeatureBins<double>(const double* data, const int num,
+    const int dim, const int max_bins, vector<vector<float> >* bounds);
+template void BinFeatures<float>(const float* data, const int num,
+    const int dim, const vector<vector<float> >& bounds, uint8_t* bins);
+template void BinFeatures<double>(const double* data, const int num,
+    const int dim, const vector<vector<float> >& bounds, uint8_t* bins);
+template void BuildHistogram<float>(const uint8_t* bins, const int dim,
+    const vector<int>& offsets, const vector<int>& features,
+    const int* samples, const int num_samples, const float* grad,
+    const float* hess, HistogramBin* hist);
+template void BuildHistogram<double>(const uint8_t* bins, const int dim,
+    const vector<int>& offsets, const vector<int>& features,
+    const int* samples, const int num_samples, const double* grad,
+    const double* hess, HistogramBin* hist);
+template void GrowHistogramTree<float>(const LayerParameter& param,
+    const uint8_t* bins, const int dim, const vector<vector<float> >& bounds,
+    const vector<int>& features, const float* grad, const float* hess,
+    vector<int>* samples, HistogramPool* pool, TreeProto* tree);
+template void GrowHistogramTree<double>(const LayerParameter& param,
+    const uint8_t* bins, const int dim, const vector<vector<float> >& bounds,
+    const vector<int>& features, const double* grad, const double* hess,
+    vector<int>* samples, HistogramPool* pool, TreeProto* tree);
+
+}  // namespace caffe
@@ -3,15 +3,30 @@
 #include <stdint.h>
 #include <fcntl.h>
 #include <io.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <glob.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <vector>
 
 #include "opencvlib.h"
 #include "caffe/common.hpp"
@@ -28,6 +43,7 @@ using google::protobuf::io::ZeroCopyInputStream;
 using google::protobuf::io::CodedInputStream;
 using google::protobuf::io::ZeroCopyOutputStream;
 using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
 
 const int totalBytesLimit = 1073741824;
 
@@ -65,11 +81,276 @@ void ReadProtoFromBinaryFile(const char* filename, Message* proto) {
   close(fd);
 }
 
+void ReadRepeatedProtoFromBinaryFile(const char* filename,
+    const int field_number, Message* item, const std::function<void()>& visit) {
+  int fd = open(filename, O_RDONLY | O_BINARY);
+  CHECK_NE(fd, -1) << "File not found: " << filename;
+  ZeroCopyInputStream* raw_input = new FileInputStream(fd);
+  CodedInputStream* coded_input = new CodedInputStream(raw_input);
+  coded_input->SetTotalBytesLimit(totalBytesLimit, totalBytesLimit/2);
+
+  uint32_t tag;
+  while ((tag = coded_input->ReadTag()) != 0) {
+    if (WireFormatLite::GetTagFieldNumber(tag) != field_number ||
+        WireFormatLite::GetTagWireType(tag) !=
+        WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      CHECK(WireFormatLite::SkipField(coded_input, tag))
+          << "Corrupted " << filename;
+      continue;
+    }
+    uint32_t length;
+    CHECK(coded_input->ReadVarint32(&length)) << "Corrupted " << filename;
+    const CodedInputStream::Limit limit = coded_input->PushLimit(length);
+    // Clear keeps the memory of the fields for the next item to parse into.
+    item->Clear();
+    CHECK(item->MergeFromCodedStream(coded_input) &&
+        coded_input->ConsumedEntireMessage()) << "Corrupted " << filename;
+    coded_input->PopLimit(limit);
+    visit();
+  }
+
+  delete coded_input;
+  delete raw_input;
+  close(fd);
+}
+
 void WriteProtoToBinaryFile(const Message& proto, const char* filename) {
   fstream output(filename, ios::out | ios::trunc | ios::binary);
   CHECK(proto.SerializeToOstream(&output));
 }
 
+const char* MapFileReadOnly(const string& filename, size_t* size) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+      NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+  CHECK(file != INVALID_HANDLE_VALUE) << "File not found: " << filename;
+  LARGE_INTEGER file_size;
+  CHECK(GetFileSizeEx(file, &file_size)) << "Cannot stat " << filename;
+  HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CHECK(mapping != NULL) << "Cannot map " << filename;
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CHECK(data != NULL) << "Cannot map " << filename;
+  // The view keeps the mapping alive after the handles are closed.
+  CloseHandle(mapping);
+  CloseHandle(file);
+  *size = static_cast<size_t>(file_size.QuadPart);
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  CHECK_NE(fd, -1) << "File not found: " << filename;
+  struct stat file_stat;
+  CHECK_EQ(fstat(fd, &file_stat), 0) << "Cannot stat " << filename;
+  void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  CHECK(data != MAP_FAILED) << "Cannot map " << filename;
+  close(fd);
+  *size = static_cast<size_t>(file_stat.st_size);
+#endif
+  return reinterpret_cast<const char*>(data);
+}
+
+void UnmapFile(const char* data, const size_t size) {
+#ifdef _WIN32
+  UnmapViewOfFile(data);
+#else
+  munmap(const_cast<char*>(data), size);
+#endif
+}
+
+// Asks the OS to start reading in a range of a mapped file that is about to
+// be used.
+void AdviseWillNeed(const char* data, const size_t size) {
+#ifndef _WIN32
+  const uintptr_t page = sysconf(_SC_PAGESIZE);
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data) / page * page;
+  madvise(reinterpret_cast<void*>(begin),
+      reinterpret_cast<uintptr_t>(data) + size - begin, MADV_WILLNEED);
+#endif
+}
+
+// The page cache works in pages, so chunks start on a page boundary.
+const uint64_t kStreamAlignment = 4096;
+
+SequentialFileReader::SequentialFileReader(const string& filename,
+    const uint64_t begin, const uint64_t end, const size_t chunk_size)
+    : begin_(begin), end_(end), buffer_offset_(0), buffer_size_(0) {
+  CHECK_LT(begin, end);
+  CHECK_GE(chunk_size, kStreamAlignment);
+  chunk_size_ = chunk_size / kStreamAlignment * kStreamAlignment;
+  buffer_.resize(chunk_size_);
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+      NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  CHECK(file != INVALID_HANDLE_VALUE) << "File not found: " << filename;
+  file_ = reinterpret_cast<intptr_t>(file);
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  CHECK_NE(fd, -1) << "File not found: " << filename;
+  // Doubles the read-ahead of the kernel for this file.
+  posix_fadvise(fd, begin, end - begin, POSIX_FADV_SEQUENTIAL);
+  file_ = fd;
+#endif
+}
+
+SequentialFileReader::~SequentialFileReader() {
+#ifdef _WIN32
+  CloseHandle(reinterpret_cast<HANDLE>(file_));
+#else
+  if (buffer_size_) {
+    posix_fadvise(file_, buffer_offset_, buffer_size_, POSIX_FADV_DONTNEED);
+  }
+  close(file_);
+#endif
+}
+
+void SequentialFileReader::Read(const uint64_t offset, size_t size,
+    char* out) {
+  uint64_t position = begin_ + offset;
+  CHECK_LE(position + size, end_);
+  while (size) {
+    if (position < buffer_offset_ ||
+        position >= buffer_offset_ + buffer_size_) {
+      Fill(position);
+    }
+    const size_t count = std::min<uint64_t>(size,
+        buffer_offset_ + buffer_size_ - position);
+    memcpy(out, &buffer_[position - buffer_offset_], count);
+    out += count;
+    position += count;
+    size -= count;
+  }
+}
+
+// Reads the chunk holding position. The pages of the chunk read before are
+// dropped from the page cache and the kernel is asked to start on the next
+// chunk right away. Windows has no such advice for buffered reads, so there
+// the pages stay cached.
+void SequentialFileReader::Fill(const uint64_t position) {
+  const uint64_t start = position / kStreamAlignment * kStreamAlignment;
+  const size_t size = std::min<uint64_t>(chunk_size_,
+      (end_ - start + kStreamAlignment - 1) / kStreamAlignment *
+      kStreamAlignment);
+#ifdef _WIN32
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  overlapped.Offset = static_cast<DWORD>(start);
+  overlapped.OffsetHigh = static_cast<DWORD>(start >> 32);
+  DWORD count = 0;
+  CHECK(ReadFile(reinterpret_cast<HANDLE>(file_), &buffer_[0],
+      static_cast<DWORD>(size), &count, &overlapped)) << "Failed to read";
+#else
+  if (buffer_size_) {
+    posix_fadvise(file_, buffer_offset_, buffer_size_, POSIX_FADV_DONTNEED);
+  }
+  size_t count = 0;
+  while (count < size) {
+    const ssize_t got = pread(file_, &buffer_[count], size - count,
+        start + count);
+    CHECK_GE(got, 0) << "Failed to read";
+    if (got == 0) {
+      break;
+    }
+    count += got;
+  }
+  const uint64_t next = start + count;
+  if (next < end_) {
+    posix_fadvise(file_, next, std::min<uint64_t>(chunk_size_, end_ - next),
+        POSIX_FADV_WILLNEED);
+  }
+#endif
+  CHECK_GT(start + count, position) << "Truncated file";
+  buffer_offset_ = start;
+  buffer_size_ = count;
+}
+
+// The size of one stored feature of a dense dataset.
+size_t DenseFeatureBytes(const DenseDatasetHeader& header) {
+  switch (header.feature_type) {
+  case DENSE_FLOAT32:
+    return sizeof(float);
+  case DENSE_UINT8:
+    return sizeof(uint8_t);
+  case DENSE_FLOAT16:
+    return sizeof(uint16_t);
+  default:
+    LOG(FATAL) << "Unknown dense feature type " << header.feature_type;
+  }
+  return 0;
+}
+
+void CheckDenseDatasetHeader(const DenseDatasetHeader& header,
+    const size_t file_size) {
+  CHECK_EQ(memcmp(header.magic, kDenseDatasetMagic, sizeof(header.magic)), 0)
+      << "Not a dense dataset file";
+  const uint64_t size = static_cast<uint64_t>(header.channels) *
+      header.height * header.width;
+  CHECK_GT(header.num, 0);
+  CHECK_GT(size, 0);
+  CHECK_LE(header.feature_offset +
+      header.num * size * DenseFeatureBytes(header), file_size)
+      << "Truncated dense dataset";
+  CHECK_LE(header.label_offset +
+      static_cast<uint64_t>(header.num) * header.label_dim * sizeof(float),
+      file_size) << "Truncated dense dataset";
+  if (header.num_groups) {
+    CHECK_LE(header.group_offset +
+        (header.num_groups + 1) * sizeof(uint32_t), file_size)
+        << "Truncated dense dataset";
+    CHECK_LE(header.group_id_offset + header.num_groups * sizeof(int32_t),
+        file_size) << "Truncated dense dataset";
+  }
+}
+
+// Splits a comma separated list of paths and expands the ones holding a
+// wildcard. Matches of a pattern are sorted; a pattern that matches nothing
+// is an error.
+vector<string> ExpandShardList(const string& sources) {
+  vector<string> paths;
+  size_t begin = 0;
+  while (begin <= sources.size()) {
+    size_t end = sources.find(',', begin);
+    if (end == string::npos) {
+      end = sources.size();
+    }
+    const string pattern = sources.substr(begin, end - begin);
+    begin = end + 1;
+    if (pattern.empty()) {
+      continue;
+    }
+    if (pattern.find_first_of("*?") == string::npos) {
+      paths.push_back(pattern);
+      continue;
+    }
+    vector<string> matches;
+#ifdef _WIN32
+    // FindFirstFile only matches the last component of the path.
+    const size_t slash = pattern.find_last_of("/\\");
+    const string dir =
+        slash == string::npos ? string() : pattern.substr(0, slash + 1);
+    WIN32_FIND_DATAA found;
+    HANDLE handle = FindFirstFileA(pattern.c_str(), &found);
+    if (handle != INVALID_HANDLE_VALUE) {
+      do {
+        if (strcmp(found.cFileName, ".") && strcmp(found.cFileName, "..")) {
+          matches.push_back(dir + found.cFileName);
+        }
+      } while (FindNextFileA(handle, &found));
+      FindClose(handle);
+    }
+#else
+    glob_t found;
+    if (glob(pattern.c_str(), 0, NULL, &found) == 0) {
+      for (size_t i = 0; i < found.gl_pathc; ++i) {
+        matches.push_back(found.gl_pathv[i]);
+      }
+    }
+    globfree(&found);
+#endif
+    CHECK(!matches.empty()) << "No shard matches " << pattern;
+    std::sort(matches.begin(), matches.end());
+    paths.insert(paths.end(), matches.begin(), matches.end());
+  }
+  return paths;
+}
+
 bool ReadImageToDatum(const string& filename, const int label,
     const int height, const int width, Datum* datum) {
   cv::Mat cv_img;
@@ -172,4 +453,111 @@ bool ReadGrayScaleImageToDatum(const string& filename, const int label,
   return true;
 }
 
+
+// Reads the query id at p into the group_id of datum. Returns false if there
+// is none or it does not fit an int32, so that distinct queries never wrap
+// onto one.
+static bool ReadTextGroupId(const char* p, char** end, Datum* datum) {
+  errno = 0;
+  const long qid = strtol(p, end, 10);
+  if (*end == p || errno == ERANGE || qid < INT_MIN || qid > INT_MAX) {
+    return false;
+  }
+  datum->set_group_id(qid);
+  return true;
+}
+
+// Parses one line of a text ranking dataset into datum.
+//    csv, tsv  label,qid,f1,f2,... with commas or tabs between the fields
+//    libsvm    label [qid:q] index:value ... [# comment], 1-based indices
+// The label always goes to float_label, so that every record of a dataset
+// stores it the same way whether or not it is integral.
+// Dense records hold the features as float_data of num_features channels;
+// csv and tsv take the width of the line when num_features is 0. Sparse
+// libsvm records keep the nonzeros with sparse_dim num_features. Returns
+// false on a malformed line.
+bool ReadTextLineToDatum(const char* line, const TextDatasetFormat format,
+    const int num_features, const bool sparse, Datum* datum) {
+  datum->Clear();
+  char* end;
+  const double label = strtod(line, &end);
+  if (end == line) {
+    return false;
+  }
+  datum->add_float_label(label);
+  const char* p = end;
+  if (format == TEXT_CSV || format == TEXT_TSV) {
+    const char separator = format == TEXT_CSV ? ',' : '\t';
+    if (*p++ != separator) {
+      return false;
+    }
+    if (!ReadTextGroupId(p, &end, datum)) {
+      return false;
+    }
+    for (p = end; *p == separator; p = end) {
+      ++p;
+      datum->add_float_data(strtod(p, &end));
+      if (end == p) {
+        return false;
+      }
+    }
+    while (*p == ' ' || *p == '\r' || *p == '\n') {
+      ++p;
+    }
+    if (*p != '\0' || datum->float_data_size() == 0 ||
+        (num_features && datum->float_data_size() != num_features)) {
+      return false;
+    }
+    datum->set_channels(datum->float_data_size());
+  } else {
+    if (num_features <= 0) {
+      return false;
+    }
+    if (!sparse) {
+      datum->mutable_float_data()->Resize(num_features, 0);
+    }
+    for (;;) {
+      while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        ++p;
+      }
+      if (*p == '\0' || *p == '#') {
+        break;
+      }
+      if (strncmp(p, "qid:", 4) == 0) {
+        if (!ReadTextGroupId(p + 4, &end, datum)) {
+          return false;
+        }
+        p = end;
+        continue;
+      }
+      const long index = strtol(p, &end, 10);
+      if (end == p || *end != ':' || index < 1 || index > num_features) {
+        return false;
+      }
+      p = end + 1;
+      const float value = strtod(p, &end);
+      if (end == p) {
+        return false;
+      }
+      p = end;
+      if (sparse) {
+        datum->add_sparse_index(index - 1);
+        datum->add_sparse_value(value);
+      } else {
+        datum->set_float_data(index - 1, value);
+      }
+    }
+    if (sparse) {
+      datum->set_sparse_dim(num_features);
+    } else {
+      datum->set_channels(num_features);
+    }
+  }
+  if (!sparse) {
+    datum->set_height(1);
+    datum->set_width(1);
+  }
+  return true;
+}
+
 }  // namespace caffe
@@ -0,0 +1,52 @@
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/util/query_ranges.hpp"
+
+namespace caffe {
+
+// Query q spans the records [start[q], start[q] + num[q]). With padding,
+// records with query id -1 belong to no query; without it, as in batches that
+// are not query_batching, -1 is a query id like any other.
+
+template <typename Dtype>
+void QueryRangesFromQid(const Dtype* qid, const int count, const bool padding,
+    vector<int>* start, vector<int>* num) {
+  start->clear();
+  num->clear();
+  for (int i = 0; i < count; ++i) {
+    if (padding && qid[i] == -1) {
+      continue;
+    }
+    if (num->empty() || qid[i] != qid[start->back()] ||
+        start->back() + num->back() != i) {
+      start->push_back(i);
+      num->push_back(0);
+    }
+    ++num->back();
+  }
+}
+
+template <typename Dtype>
+void QueryRangesFromOffsets(const Blob<Dtype>& offsets, vector<int>* start,
+    vector<int>* num) {
+  start->clear();
+  num->clear();
+  const Dtype* data = offsets.cpu_data();
+  for (int i = 0; i + 1 < offsets.count() && data[i + 1] >= 0; ++i) {
+    start->push_back(static_cast<int>(data[i]));
+    num->push_back(static_cast<int>(data[i + 1] - data[i]));
+  }
+}
+
+template void QueryRangesFromQid<float>(const float* qid, const int count,
+    const bool padding, vector<int>* start, vector<int>* num);
+template void QueryRangesFromQid<double>(const double* qid, const int count,
+    const bool padding, vector<int>* start, vector<int>* num);
+template void QueryRangesFromOffsets<float>(const Blob<float>& offsets,
+    vector<int>* start, vector<int>* num);
+template void QueryRangesFromOffsets<double>(const Blob<double>& offsets,
+    vector<int>* start, vector<int>* num);
+
+}  // namespace caffe
@@ -0,0 +1,179 @@
+// QuickScorer evaluation of a ForestProto (Lucchese et al., SIGIR 2015).
+// Rather than walking every tree from the root, the split nodes of all
+// trees are grouped by feature and sorted by threshold. Each tree has a
+// bitvector of its leaves, numbered left to right, that are still reachable.
+// For every feature, the nodes whose threshold is below the feature value,
+// the ones that send a sample right, clear the leaves of their left subtrees
+// from the bitvector of their tree. The exit leaf of a tree is then the
+// lowest bit left. There are no data dependent branches within a tree, only
+// a scan that stops at the first threshold not below the feature value.
+//
+// Bitvectors are 64 bits, so trees with more leaves are walked node by node
+// through a FlatForest instead.
+//
+// The forest layer, tree/ForestLayer.h, is not part of this tree, so no
+// LayerParameter selects this engine yet; it is meant to score the forests
+// of that layer once it can be built here.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/flat_forest.hpp"
+#include "caffe/util/quick_scorer.hpp"
+
+namespace caffe {
+
+const int kQuickScorerMaxLeaves = 64;
+
+// The index of the lowest set bit of v, which is not 0.
+static inline int LowestBit(const uint64_t v) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, v);
+  return index;
+#else
+  return __builtin_ctzll(v);
+#endif
+}
+
+// The number of leaves under node n, or more than kQuickScorerMaxLeaves if
+// there are more.
+static int CountTreeLeaves(const TreeProto& tree, const int n,
+    const int depth) {
+  CHECK_LT(depth, tree.tree_nodes_size()) << "Not a tree";
+  const TreeNodeProto& node = tree.tree_nodes(n);
+  if (node.leaf()) {
+    return 1;
+  }
+  const int left = CountTreeLeaves(tree, node.left_child(), depth + 1);
+  if (left > kQuickScorerMaxLeaves) {
+    return left;
+  }
+  return left + CountTreeLeaves(tree, node.right_child(), depth + 1);
+}
+
+// A split node of a tree with a bitvector
+struct QuickScorerNode {
+  int feature;
+  float threshold;
+  int tree;
+  // The leaves still reachable when the sample goes right
+  uint64_t mask;
+
+  bool operator<(const QuickScorerNode& other) const {
+    return feature < other.feature ||
+        (feature == other.feature && threshold < other.threshold);
+  }
+};
+
+// Appends the leaves under node n to leaf_values left to right, and its
+// split nodes to nodes. Returns the number of leaves.
+static int AddQuickScorerNodes(const TreeProto& tree, const int n,
+    const int quick_tree, const int first_leaf, vector<float>* leaf_values,
+    vector<QuickScorerNode>* nodes) {
+  const TreeNodeProto& source = tree.tree_nodes(n);
+  if (source.leaf()) {
+    leaf_values->push_back(source.pred());
+    return 1;
+  }
+  const int left = AddQuickScorerNodes(tree, source.left_child(),
+      quick_tree, first_leaf, leaf_values, nodes);
+  const int right = AddQuickScorerNodes(tree, source.right_child(),
+      quick_tree, first_leaf + left, leaf_values, nodes);
+  QuickScorerNode node;
+  node.feature = source.feature_split();
+  node.threshold = source.value_split();
+  node.tree = quick_tree;
+  // A right subtree has a leaf, so left < 64.
+  node.mask = ~(((static_cast<uint64_t>(1) << left) - 1) << first_leaf);
+  nodes->push_back(node);
+  return left + right;
+}
+
+QuickScorer::QuickScorer() : init_pred_(0), learning_rate_(1), dim_(0) {}
+
+void QuickScorer::Build(const ForestProto& forest) {
+  init_pred_ = forest.init_pred();
+  learning_rate_ = forest.learning_rate();
+  dim_ = forest.dim();
+  leaf_offsets_.clear();
+  leaf_values_.clear();
+  large_trees_ = FlatForest();
+  vector<QuickScorerNode> nodes;
+  for (int t = 0; t < forest.trees_size(); ++t) {
+    const TreeProto& tree = forest.trees(t);
+    CHECK_GT(tree.tree_nodes_size(), 0) << "Empty tree";
+    if (CountTreeLeaves(tree, 0, 0) > kQuickScorerMaxLeaves) {
+      large_trees_.AddTree(tree);
+      continue;
+    }
+    const int quick_tree = leaf_offsets_.size();
+    leaf_offsets_.push_back(leaf_values_.size());
+    AddQuickScorerNodes(tree, 0, quick_tree, 0, &leaf_values_, &nodes);
+  }
+  std::sort(nodes.begin(), nodes.end());
+  int num_features = dim_;
+  if (!nodes.empty()) {
+    CHECK(dim_ == 0 || nodes.back().feature < dim_)
+        << "Split on feature " << nodes.back().feature << " of " << dim_;
+    num_features = std::max(num_features, nodes.back().feature + 1);
+  }
+  feature_offsets_.assign(num_features + 1, 0);
+  thresholds_.resize(nodes.size());
+  node_trees_.resize(nodes.size());
+  masks_.resize(nodes.size());
+  for (int k = 0; k < nodes.size(); ++k) {
+    ++feature_offsets_[nodes[k].feature + 1];
+    thresholds_[k] = nodes[k].threshold;
+    node_trees_[k] = nodes[k].tree;
+    masks_[k] = nodes[k].mask;
+  }
+  for (int j = 0; j < num_features; ++j) {
+    feature_offsets_[j + 1] += feature_offsets_[j];
+  }
+}
+
+template <typename Dtype>
+void QuickScorer::Predict(const Dtype* data, const int num, const int dim,
+    Dtype* out) const {
+  CHECK(dim_ == 0 || dim == dim_) << "Expected " << dim_ << " features";
+  const int num_features = feature_offsets_.size() - 1;
+  CHECK_LE(num_features, dim);
+  const int num_quick_trees = leaf_offsets_.size();
+  const int num_large_trees = large_trees_.num_trees();
+  vector<uint64_t> leaves(num_quick_trees);
+  for (int i = 0; i < num; ++i) {
+    const Dtype* x = data + static_cast<size_t>(i) * dim;
+    std::fill(leaves.begin(), leaves.end(), ~static_cast<uint64_t>(0));
+    for (int j = 0; j < num_features; ++j) {
+      const Dtype value = x[j];
+      for (int k = feature_offsets_[j]; k < feature_offsets_[j + 1] &&
+          thresholds_[k] < value; ++k) {
+        leaves[node_trees_[k]] &= masks_[k];
+      }
+    }
+    float sum = 0;
+    for (int t = 0; t < num_quick_trees; ++t) {
+      sum += leaf_values_[leaf_offsets_[t] + LowestBit(leaves[t])];
+    }
+    for (int t = 0; t < num_large_trees; ++t) {
+      sum += large_trees_.PredictTree(t, x);
+    }
+    out[i] = init_pred_ + learning_rate_ * sum;
+  }
+}
+
+template void QuickScorer::Predict<float>(const float* data, const int num,
+    const int dim, float* out) const;
+template void QuickScorer::Predict<double>(const double* data, const int num,
+    const int dim, double* out) const;
+
+}  // namespace caffe